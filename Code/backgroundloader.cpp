@@ -0,0 +1,298 @@
+/// @file backgroundloader.cpp
+/// @brief Implementations for loading files on a background thread.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "fileexception.h"
+#include "systemindex.h"
+#include "catalog.h"
+#include "compressedinput.h"
+#include "backgroundloader.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief Reads a file in blocks for the loaders, counting lines as it
+///        goes and ending the stream early once cancelled.
+class ProgressBuffer : public streambuf
+{
+    public:
+        ProgressBuffer(istream &source, atomic<uint64_t> &lines, const atomic<bool> &cancelled)
+            : source(source), lines(lines), cancelled(cancelled) {}
+
+    protected:
+        int_type underflow() override {
+            if (this->cancelled.load(memory_order_relaxed)) {
+                return traits_type::eof();
+            }
+            this->source.read(this->block, sizeof(this->block));
+            streamsize n = this->source.gcount();
+            if (n <= 0) {
+                return traits_type::eof();
+            }
+            this->lines.fetch_add(count(this->block, this->block + n, '\n'), memory_order_relaxed);
+            this->setg(this->block, this->block, this->block + n);
+            return traits_type::to_int_type(this->block[0]);
+        }
+
+    private:
+        istream &source;
+        atomic<uint64_t> &lines;
+        const atomic<bool> &cancelled;
+        char block[1 << 16];
+};
+
+
+/// @return a one line description of the load
+string LoadProgress::toString() const {
+    if (this->state == LoadState::Idle) {
+        return "No background load.";
+    }
+
+    ostringstream out;
+    out << fixed << setprecision(1);
+    switch (this->state) {
+        case LoadState::Running:
+            out << "Loading ";
+            break;
+        case LoadState::Finished:
+            out << "Finished ";
+            break;
+        case LoadState::Cancelled:
+            out << "Cancelled ";
+            break;
+        default:
+            break;
+    }
+    out << (this->kind == LoadKind::Celestial ? "celestial" : "connection") << " file "
+        << this->fileName << ": " << this->lines << " lines, "
+        << this->bytes / 1048576.0 << " of " << this->totalBytes / 1048576.0 << " MB";
+    if (this->totalBytes > 0) {
+        out << " (" << setprecision(0) << 100.0 * this->bytes / this->totalBytes << "%)" << setprecision(1);
+    }
+    out << ", " << this->elapsedSeconds << " s elapsed";
+    if (this->state == LoadState::Running && this->etaSeconds >= 0) {
+        out << ", about " << this->etaSeconds << " s left";
+    }
+    return out.str();
+}
+
+/// @brief Cancels and waits for a running load.
+BackgroundLoader::~BackgroundLoader() {
+    this->cancelled.store(true);
+    this->join();
+}
+
+/// @brief Start loading a file on the worker thread.
+/// @param kind celestial objects or connections
+/// @param fileName the file to load
+/// @param systems the loaded systems; connection files resolve names
+///        against a copy of their names taken now
+void BackgroundLoader::start(LoadKind kind, const string &fileName,
+                             const vector<shared_ptr<SolarSystem>> &systems) {
+    if (this->busy) {
+        throw logic_error("A background load is already in progress.");
+    }
+
+    this->file.open(fileName);
+    if (!this->file.is_open()) {
+        throw FileException("Exception Caught: File Not Found - " + fileName);
+    }
+    this->totalBytes = this->file.getFileSize();
+
+    // connection lines name loaded systems, so stage a shell for each in
+    // the same order; staged ids then equal the loaded ids
+    this->stagedSystems.clear();
+    this->stagedIndex.clear();
+    if (kind == LoadKind::Connections) {
+        this->stagedSystems.reserve(systems.size());
+        for (const auto &system : systems) {
+            this->stagedSystems.push_back(make_shared<SolarSystem>(system->getName()));
+        }
+        this->stagedIndex.sync(this->stagedSystems);
+    }
+
+    this->kind = kind;
+    this->fileName = fileName;
+    this->error.clear();
+    this->lines.store(0);
+    this->cancelled.store(false);
+    this->done.store(false);
+    this->started = chrono::steady_clock::now();
+    this->busy = true;
+    this->ended = LoadState::Idle;
+    this->worker = thread(&BackgroundLoader::run, this);
+}
+
+/// @return true from start until the load is committed or cancelled
+bool BackgroundLoader::isBusy() const {
+    return this->busy;
+}
+
+/// @return progress of the current or last load
+LoadProgress BackgroundLoader::progress() const {
+    LoadProgress progress;
+    progress.kind = this->kind;
+    progress.fileName = this->fileName;
+    progress.totalBytes = this->totalBytes;
+    progress.bytes = this->file.is_open() ? this->file.getFileBytesRead() : this->endBytes;
+    progress.lines = this->lines.load(memory_order_relaxed);
+
+    if (!this->busy) {
+        progress.state = this->ended;
+        progress.elapsedSeconds = this->finishedSeconds.load();
+        return progress;
+    }
+    if (this->done.load(memory_order_acquire)) {
+        progress.state = LoadState::Finished;
+        progress.elapsedSeconds = this->finishedSeconds.load();
+        return progress;
+    }
+
+    progress.state = LoadState::Running;
+    progress.elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - this->started).count();
+    progress.etaSeconds = -1.0;
+    if (progress.bytes > 0 && progress.totalBytes >= progress.bytes) {
+        progress.etaSeconds = progress.elapsedSeconds * (progress.totalBytes - progress.bytes) / progress.bytes;
+    }
+    return progress;
+}
+
+/// @brief Ask the worker to stop and throw its staged data away.
+void BackgroundLoader::cancel() {
+    if (!this->busy) {
+        return;
+    }
+    this->cancelled.store(true);
+    this->join();
+    this->stagedSystems.clear();
+    this->stagedIndex.clear();
+    this->endBytes = this->file.getFileBytesRead();
+    this->file.close();
+    this->busy = false;
+    this->ended = LoadState::Cancelled;
+}
+
+/// @brief When the worker has finished, merge its staged data into the
+///        loaded systems in one step. A bad line stops parsing like the
+///        synchronous loaders do, and the lines before it are committed.
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param message set to a summary of the load
+/// @return true when something was committed
+bool BackgroundLoader::commit(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, string &message) {
+    if (!this->busy || !this->done.load(memory_order_acquire)) {
+        return false;
+    }
+    this->join();
+
+    index.sync(systems);
+    if (this->kind == LoadKind::Celestial) {
+        this->mergeCelestial(systems, index);
+    } else {
+        this->mergeConnections(index);
+    }
+
+    ostringstream out;
+    out << "Background load of " << this->fileName << " committed: "
+        << this->lines.load() << " lines in " << fixed << setprecision(2)
+        << this->finishedSeconds.load() << " s.";
+    if (!this->error.empty()) {
+        out << endl << this->error;
+    }
+    message = out.str();
+
+    this->stagedSystems.clear();
+    this->stagedIndex.clear();
+    this->endBytes = this->file.getFileBytesRead();
+    this->file.close();
+    this->busy = false;
+    this->ended = LoadState::Finished;
+    return true;
+}
+
+/// @brief worker thread: parse the whole file into the staging systems
+void BackgroundLoader::run() {
+    ProgressBuffer buffer(this->file, this->lines, this->cancelled);
+    istream in(&buffer);
+    in.exceptions(ios::badbit); // pass on errors found inflating the file
+    try {
+        if (this->kind == LoadKind::Celestial) {
+            loadCelestialObjects(in, this->stagedSystems, this->stagedIndex);
+        } else {
+            loadSolarSystemConnections(in, this->stagedSystems, this->stagedIndex);
+        }
+    } catch (const exception &e) {
+        this->error = e.what();
+    }
+    this->finishedSeconds.store(chrono::duration<double>(chrono::steady_clock::now() - this->started).count());
+    this->done.store(true, memory_order_release);
+}
+
+/// @brief wait for the worker thread if there is one
+void BackgroundLoader::join() {
+    if (this->worker.joinable()) {
+        this->worker.join();
+    }
+}
+
+/// @brief Move staged systems into the loaded ones. New systems are taken
+///        over whole. Bodies of systems already loaded merge the way the
+///        loader would add them: stars and satellites already there are
+///        skipped and satellites join the first planet of their name.
+void BackgroundLoader::mergeCelestial(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    index.markBodiesChanged();
+    for (const auto &staged : this->stagedSystems) {
+        int id = index.idOf(staged->getName());
+        if (id == -1) {
+            systems.push_back(staged);
+            index.sync(systems);
+            continue;
+        }
+
+        shared_ptr<SolarSystem> loaded = index.at(id);
+        if (staged->hasPosition()) {
+            index.setPosition(id, staged->getX(), staged->getY(), staged->getZ());
+        }
+        for (const auto &body : staged->getCelestialBodies()) {
+            if (shared_ptr<Star> star = dynamic_pointer_cast<Star>(body)) {
+                if (loaded->find<Star>(star->getName()) == nullptr) {
+                    loaded->insertCelestial(star);
+                }
+            } else if (shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(body)) {
+                // a fresh planet, its satellites go to the first of its name
+                shared_ptr<Planet> added = make_shared<Planet>(planet->getName(), planet->getOrbitalPeriod(), planet->getRadius());
+                loaded->insertCelestial(added);
+                shared_ptr<Planet> orbited = loaded->find<Planet>(planet->getName());
+                for (const auto &sat : planet->getSats()) {
+                    shared_ptr<Satellite> satellite = dynamic_pointer_cast<Satellite>(sat);
+                    if (satellite != nullptr && !orbited->satExists(satellite->getName())) {
+                        loaded->insertSatellite(orbited, satellite);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// @brief Add every staged connection to the loaded systems. Staged ids
+///        equal loaded ids, see start.
+void BackgroundLoader::mergeConnections(SystemIndex &index) {
+    int numSystems = min(this->stagedIndex.size(), index.size());
+    for (int id = 0; id < numSystems; id++) {
+        for (int target : this->stagedIndex.neighbors(id)) {
+            index.connect(id, target);
+        }
+    }
+}
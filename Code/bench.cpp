@@ -0,0 +1,1982 @@
+/// @file bench.cpp
+/// @brief Benchmark harness for the Interstellar Travel App. Generates a
+///        synthetic universe, times each stage with warmup and repetitions,
+///        and reports percentiles to the console and optionally as JSON.
+///
+/// Usage: bench.out [-systems N] [-stars N] [-planets N] [-satellites N]
+///                  [-degree D] [-model uniform|powerlaw|smallworld] [-rewire P] [-seed S]
+///                  [-reps N] [-warmup N] [-queries N] [-stage name]...
+///                  [-satload N] [-readers N] [-landmarks N] [-reachsystems N]
+///                  [-json file]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "celestial.h"
+#include "solarsystem.h"
+#include "flightpath.h"
+#include "systemindex.h"
+#include "catalog.h"
+#include "deltaloader.h"
+#include "spatialindex.h"
+#include "routeplanner.h"
+#include "contractionhierarchy.h"
+#include "itineraryplanner.h"
+#include "orbitalrouter.h"
+#include "graphanalytics.h"
+#include "nameindex.h"
+#include "queryengine.h"
+#include "universegen.h"
+#include "lazycatalog.h"
+#include "universesnapshot.h"
+#include "compressedinput.h"
+#include <zlib.h>
+#ifdef INTERSTELLAR_ZSTD
+#include <zstd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+/// @brief stream buffer that throws output away, for timing print paths
+class NullBuffer : public streambuf
+{
+    protected:
+        int overflow(int c) override { return c; }
+        streamsize xsputn(const char *, streamsize n) override { return n; }
+};
+
+/// @brief stream buffer that parses generated connection lines straight
+///        into compressed rows, so graphs too big to load as SolarSystem
+///        objects can still be searched. Lines arrive in system order.
+class EdgeCollector : public streambuf
+{
+    public:
+        EdgeCollector(vector<int> &offsets, vector<int> &targets) : offsets(offsets), targets(targets) {
+            this->offsets.assign(1, 0);
+        }
+
+        /// @brief close the rows of systems after the last line
+        void finish(long systems) {
+            while (static_cast<long>(this->offsets.size()) <= systems) {
+                this->offsets.push_back(this->targets.size());
+            }
+        }
+
+    protected:
+        int overflow(int c) override {
+            if (c != traits_type::eof()) {
+                this->put(static_cast<char>(c));
+            }
+            return c;
+        }
+        streamsize xsputn(const char *s, streamsize n) override {
+            for (streamsize i = 0; i < n; i++) {
+                this->put(s[i]);
+            }
+            return n;
+        }
+
+    private:
+        void put(char c) {
+            if (c != '\n') {
+                this->line.push_back(c);
+                return;
+            }
+            // SYS<from>,SYS<to>,... with names numbered by generatedSystemName
+            if (!this->line.empty() && this->line.at(0) != '#') {
+                char *at = nullptr;
+                long from = strtol(this->line.c_str() + 3, &at, 10);
+                this->finish(from);
+                while (*at == ',') {
+                    this->targets.push_back(strtol(at + 4, &at, 10));
+                }
+            }
+            this->line.clear();
+        }
+
+        vector<int> &offsets;
+        vector<int> &targets;
+        string line;
+};
+
+/// @brief timings of one benchmark stage
+struct StageResult
+{
+    string name;
+    vector<double> samples; // milliseconds, one per timed unit
+    long opsPerSample = 1;
+    vector<pair<string, double>> counters;
+};
+
+/// @brief settings shared by every stage
+struct BenchConfig
+{
+    UniverseSpec spec;
+    int reps = 5;
+    int warmup = 1;
+    int queries = 1000;
+    long satelliteLoad = 100000;
+    int readers = 4;
+    int landmarks = 16;
+    long reachSystems = 10000000;
+    vector<string> stages;
+    string jsonFile;
+};
+
+/// @brief The generated universe every stage works on: the generated file
+///        contents and the systems loaded from them
+struct BenchUniverse
+{
+    string celestialData;
+    string connectionData;
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+};
+
+// Local Function Prototypes
+double timeMs(const function<void()> &work);
+double heapMb();
+double residentMb();
+double percentile(vector<double> sorted, double p);
+void printResult(const StageResult &result);
+void writeJson(const string &fileName, const BenchConfig &config, const vector<StageResult> &results);
+bool wanted(const BenchConfig &config, const string &stage);
+long countEdges(const RoutePlanner &planner);
+StageResult repeat(const string &name, const BenchConfig &config,
+                   const function<void()> &setup, const function<void()> &work);
+static void runIsValidStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results);
+static void runPrintStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results);
+static void runDeltaStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results);
+static void runSpatialStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results);
+static void runRouteStage(const BenchConfig &config, BenchUniverse &universe,
+                          mt19937_64 &rng, vector<StageResult> &results);
+static void runLandmarksStage(const BenchConfig &config, BenchUniverse &universe,
+                              mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runConstrainedStage(const BenchConfig &config, BenchUniverse &universe,
+                                mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runItineraryStage(const BenchConfig &config, BenchUniverse &universe,
+                              mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runOrbitalStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runRangedStage(const BenchConfig &config, BenchUniverse &universe,
+                           mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runReachStage(const BenchConfig &config, BenchUniverse &universe,
+                          mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runAnalyticsStage(const BenchConfig &config, BenchUniverse &universe,
+                              vector<StageResult> &results, bool &failedChecks);
+static void runReorderStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runHierarchyStage(const BenchConfig &config, BenchUniverse &universe,
+                              mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks);
+static void runNamesStage(const BenchConfig &config, BenchUniverse &universe,
+                          mt19937_64 &rng, vector<StageResult> &results);
+static void runQueryStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results);
+static void runSatellitesStage(const BenchConfig &config, BenchUniverse &universe,
+                               vector<StageResult> &results);
+static void runSnapshotStage(const BenchConfig &config, BenchUniverse &universe,
+                             vector<StageResult> &results, bool &failedChecks);
+static void runLazyStage(const BenchConfig &config, BenchUniverse &universe,
+                         mt19937_64 &rng, vector<StageResult> &results);
+static void runCompressedStage(const BenchConfig &config, BenchUniverse &universe,
+                               vector<StageResult> &results, bool &failedChecks);
+static void runTolerantStage(const BenchConfig &config, BenchUniverse &universe,
+                             vector<StageResult> &results, bool &failedChecks);
+static void runStarsStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results);
+
+int main(int argc, char* argv[])
+{
+    BenchConfig config;
+    config.spec.systems = 100000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        string value = argv[i + 1];
+        if (arg == "-systems") {
+            config.spec.systems = stol(value);
+        } else if (arg == "-stars") {
+            config.spec.starsPerSystem = stoi(value);
+        } else if (arg == "-planets") {
+            config.spec.planetsPerSystem = stoi(value);
+        } else if (arg == "-satellites") {
+            config.spec.satellitesPerPlanet = stoi(value);
+        } else if (arg == "-degree") {
+            config.spec.meanDegree = stod(value);
+        } else if (arg == "-model") {
+            config.spec.degreeModel = value;
+        } else if (arg == "-rewire") {
+            config.spec.rewire = stod(value);
+        } else if (arg == "-seed") {
+            config.spec.seed = stoul(value);
+        } else if (arg == "-reps") {
+            config.reps = stoi(value);
+        } else if (arg == "-warmup") {
+            config.warmup = stoi(value);
+        } else if (arg == "-queries") {
+            config.queries = stoi(value);
+        } else if (arg == "-satload") {
+            config.satelliteLoad = stol(value);
+        } else if (arg == "-readers") {
+            config.readers = max(1, min(stoi(value), SnapshotPublisher::kMaxReaders));
+        } else if (arg == "-landmarks") {
+            config.landmarks = max(1, stoi(value));
+        } else if (arg == "-reachsystems") {
+            config.reachSystems = stol(value);
+        } else if (arg == "-stage") {
+            config.stages.push_back(value);
+        } else if (arg == "-json") {
+            config.jsonFile = value;
+        } else {
+            cout << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    const UniverseSpec &spec = config.spec;
+    cout << "Generating " << spec.systems << " systems, "
+        << spec.systems * (spec.starsPerSystem + spec.planetsPerSystem * (1 + spec.satellitesPerPlanet))
+        << " bodies, " << spec.degreeModel << " degree " << spec.meanDegree << endl;
+    BenchUniverse universe;
+    ostringstream celestialOut, connectionOut;
+    writeCelestialData(celestialOut, spec);
+    writeConnectionData(connectionOut, spec);
+    universe.celestialData = celestialOut.str();
+    universe.connectionData = connectionOut.str();
+    const string &celestialData = universe.celestialData;
+    const string &connectionData = universe.connectionData;
+
+    vector<StageResult> results;
+    vector<shared_ptr<SolarSystem>> &systems = universe.systems;
+    SystemIndex &index = universe.index;
+    mt19937_64 rng(spec.seed + 7);
+
+    // loading always runs, every later stage needs the data
+    results.push_back(repeat("load_celestial", config, [&]() {
+        systems.clear();
+        index.clear();
+    }, [&]() {
+        istringstream in(celestialData);
+        loadCelestialObjects(in, systems, index);
+    }));
+    results.back().opsPerSample = count(celestialData.begin(), celestialData.end(), '\n');
+
+    results.push_back(repeat("load_connections", config, [&]() {
+        for (const auto &system : systems) {
+            system->clearConnections();
+        }
+        index.clearConnections();
+    }, [&]() {
+        istringstream in(connectionData);
+        loadSolarSystemConnections(in, systems, index);
+    }));
+    results.back().opsPerSample = count(connectionData.begin(), connectionData.end(), '\n');
+
+    bool failedChecks = false;
+
+    if (wanted(config, "is_valid")) {
+        runIsValidStage(config, universe, rng, results);
+    }
+
+    if (wanted(config, "print")) {
+        runPrintStage(config, universe, results);
+    }
+
+    if (wanted(config, "delta")) {
+        runDeltaStage(config, universe, results);
+    }
+
+    if (wanted(config, "spatial")) {
+        runSpatialStage(config, universe, rng, results);
+    }
+
+    if (wanted(config, "route")) {
+        runRouteStage(config, universe, rng, results);
+    }
+
+    if (wanted(config, "landmarks")) {
+        runLandmarksStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "constrained")) {
+        runConstrainedStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "itinerary")) {
+        runItineraryStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "orbital")) {
+        runOrbitalStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "ranged")) {
+        runRangedStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "reach")) {
+        runReachStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "analytics")) {
+        runAnalyticsStage(config, universe, results, failedChecks);
+    }
+
+    if (wanted(config, "reorder")) {
+        runReorderStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "hierarchy")) {
+        runHierarchyStage(config, universe, rng, results, failedChecks);
+    }
+
+    if (wanted(config, "names")) {
+        runNamesStage(config, universe, rng, results);
+    }
+
+    if (wanted(config, "query")) {
+        runQueryStage(config, universe, results);
+    }
+
+    if (wanted(config, "satellites")) {
+        runSatellitesStage(config, universe, results);
+    }
+
+    if (wanted(config, "snapshot")) {
+        runSnapshotStage(config, universe, results, failedChecks);
+    }
+
+    if (wanted(config, "lazy")) {
+        runLazyStage(config, universe, rng, results);
+    }
+
+    if (wanted(config, "compressed")) {
+        runCompressedStage(config, universe, results, failedChecks);
+    }
+
+    if (wanted(config, "tolerant")) {
+        runTolerantStage(config, universe, results, failedChecks);
+    }
+
+    if (wanted(config, "stars")) {
+        runStarsStage(config, universe, results);
+    }
+
+    for (const auto &result : results) {
+        printResult(result);
+    }
+    if (!config.jsonFile.empty()) {
+        writeJson(config.jsonFile, config, results);
+    }
+    return failedChecks ? 1 : 0;
+}
+
+/// @brief random walks along connections, so every path is valid and
+///        isValid has to check every step
+static void runIsValidStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results) {
+    vector<shared_ptr<SolarSystem>> &systems = universe.systems;
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    StageResult result{"is_valid", {}, 10, {}};
+    FlightPath path;
+    for (int q = 0; q < config.warmup + config.queries; q++) {
+        vector<shared_ptr<SolarSystem>> steps;
+        int at = anySystem(rng);
+        steps.push_back(index.at(at));
+        for (int s = 0; s < 10 && !index.neighbors(at).empty(); s++) {
+            const vector<int> &next = index.neighbors(at);
+            at = next[rng() % next.size()];
+            steps.push_back(index.at(at));
+        }
+        path.setPath(steps);
+        bool valid = false;
+        double ms = timeMs([&]() { valid = path.isValid(systems); });
+        if (q >= config.warmup) {
+            result.samples.push_back(ms);
+        }
+        if (!valid) {
+            cout << "is_valid: random walk reported invalid" << endl;
+        }
+    }
+    results.push_back(result);
+}
+
+/// @brief print every system's bodies, connections and the load
+///        statistics to a discarding stream
+static void runPrintStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results) {
+    vector<shared_ptr<SolarSystem>> &systems = universe.systems;
+    NullBuffer nullBuffer;
+    ostream nullOut(&nullBuffer);
+
+    results.push_back(repeat("print_celestial", config, []() {}, [&]() {
+        printSystemsCelestialDetails(systems, nullOut);
+    }));
+    results.push_back(repeat("print_connections", config, []() {}, [&]() {
+        printSystemsConnectionDetails(systems, nullOut);
+    }));
+    results.push_back(repeat("print_stats", config, []() {}, [&]() {
+        printLoadedCelestialStats(systems, nullOut);
+    }));
+}
+
+/// @brief each repetition applies a different 1000 line delta
+static void runDeltaStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results) {
+    const UniverseSpec &spec = config.spec;
+    vector<shared_ptr<SolarSystem>> &systems = universe.systems;
+    SystemIndex &index = universe.index;
+
+    string delta;
+    int deltaNumber = 0;
+    StageResult result = repeat("delta_apply", config, [&]() {
+        ostringstream out;
+        mt19937_64 deltaRng(spec.seed + 100 + deltaNumber++);
+        for (int line = 0; line < 1000; line++) {
+            string system = generatedSystemName(deltaRng() % spec.systems);
+            string other = generatedSystemName(deltaRng() % spec.systems);
+            switch (line % 5) {
+                case 0:
+                    out << "Star,S" << system.substr(3) << "_0," << system << ",G2V,5800,1.1\n";
+                    break;
+                case 1:
+                    out << "Planet,NP" << deltaNumber << "_" << line << ",S" << system.substr(3) << "_0," << system << ",400,1.2\n";
+                    break;
+                case 2:
+                    out << "Satellite,NM" << deltaNumber << "_" << line << ",P" << system.substr(3) << "_0," << system << ",0.1,No\n";
+                    break;
+                case 3:
+                    out << "Connect," << system << "," << other << "\n";
+                    break;
+                default:
+                    out << "Disconnect," << system << "," << other << "\n";
+                    break;
+            }
+        }
+        delta = out.str();
+    }, [&]() {
+        istringstream in(delta);
+        DeltaReport report;
+        applyDelta(in, systems, index, report);
+    });
+    result.opsPerSample = 1000;
+    results.push_back(result);
+}
+
+/// @brief build the k-d tree and time nearest ten queries at random
+///        points
+static void runSpatialStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results) {
+    const UniverseSpec &spec = config.spec;
+    SystemIndex &index = universe.index;
+
+    SpatialIndex spatial;
+    results.push_back(repeat("knn_build", config, []() {}, [&]() { spatial.build(index); }));
+
+    StageResult result{"knn_10", {}, 1, {}};
+    uniform_real_distribution<double> coordinate(0.0, cbrt(static_cast<double>(spec.systems)));
+    for (int q = 0; q < config.warmup + config.queries; q++) {
+        double x = coordinate(rng), y = coordinate(rng), z = coordinate(rng);
+        double ms = timeMs([&]() { spatial.nearest(x, y, z, 10); });
+        if (q >= config.warmup) {
+            result.samples.push_back(ms);
+        }
+    }
+    results.push_back(result);
+}
+
+/// @brief build the route planner and time A* against uninformed
+///        search between random systems
+static void runRouteStage(const BenchConfig &config, BenchUniverse &universe,
+                          mt19937_64 &rng, vector<StageResult> &results) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    RoutePlanner planner;
+    results.push_back(repeat("route_build", config, []() {}, [&]() { planner.build(index); }));
+
+    StageResult informed{"route_astar", {}, 1, {}};
+    StageResult uninformed{"route_uninformed", {}, 1, {}};
+    double informedSettled = 0, uninformedSettled = 0;
+    int routes = max(1, config.queries / 10);
+    vector<int> route;
+    for (int q = 0; q < config.warmup + routes; q++) {
+        int start = anySystem(rng), end = anySystem(rng);
+        RouteStats a, b;
+        planner.findRoute(start, end, route, &a);
+        planner.findRouteUninformed(start, end, route, &b);
+        if (q >= config.warmup) {
+            informed.samples.push_back(a.elapsedMs);
+            uninformed.samples.push_back(b.elapsedMs);
+            informedSettled += a.settled;
+            uninformedSettled += b.settled;
+        }
+    }
+    informed.counters.push_back({"mean_settled", informedSettled / routes});
+    informed.counters.push_back({"heuristic", planner.usesHeuristic()});
+    uninformed.counters.push_back({"mean_settled", uninformedSettled / routes});
+    results.push_back(informed);
+    results.push_back(uninformed);
+}
+
+/// @brief ALT search with either choice of landmarks, alone and together
+///        with the distance bound, against uninformed search. Every route
+///        must keep the uninformed hop count.
+static void runLandmarksStage(const BenchConfig &config, BenchUniverse &universe,
+                              mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    RoutePlanner plain;
+    plain.build(index);
+    int routes = max(1, config.queries / 10);
+    vector<pair<int, int>> pairs;
+    for (int q = 0; q < config.warmup + routes; q++) {
+        pairs.push_back({anySystem(rng), anySystem(rng)});
+    }
+    StageResult uninformed{"route_uninformed", {}, 1, {}};
+    vector<int> expected(pairs.size());
+    double uninformedSettled = 0;
+    vector<int> route;
+    for (size_t q = 0; q < pairs.size(); q++) {
+        RouteStats stats;
+        expected[q] = plain.findRouteUninformed(pairs[q].first, pairs[q].second, route, &stats) ? route.size() : 0;
+        if (static_cast<int>(q) >= config.warmup) {
+            uninformed.samples.push_back(stats.elapsedMs);
+            uninformedSettled += stats.settled;
+        }
+    }
+    uninformed.counters.push_back({"mean_settled", uninformedSettled / routes});
+    results.push_back(uninformed);
+
+    for (LandmarkChoice choice : {LandmarkChoice::Farthest, LandmarkChoice::Degree}) {
+        string choiceName = choice == LandmarkChoice::Farthest ? "farthest" : "degree";
+        RoutePlanner planner;
+        planner.setLandmarks(config.landmarks, choice);
+        StageResult build{"landmarks_build_" + choiceName, {}, 1, {}};
+        build.samples.push_back(timeMs([&]() { planner.build(index); }));
+        build.counters.push_back({"landmarks", static_cast<double>(planner.landmarkCount())});
+        build.counters.push_back({"table_mb", planner.landmarkBytes() / (1024.0 * 1024.0)});
+        results.push_back(build);
+
+        for (bool withDistance : {false, true}) {
+            StageResult result{"route_alt_" + choiceName + (withDistance ? "_distance" : ""), {}, 1, {}};
+            double settled = 0;
+            long mismatches = 0;
+            for (size_t q = 0; q < pairs.size(); q++) {
+                RouteStats stats;
+                bool found = withDistance ? planner.findRoute(pairs[q].first, pairs[q].second, route, &stats)
+                                          : planner.findRouteLandmarks(pairs[q].first, pairs[q].second, route, &stats);
+                mismatches += (found ? static_cast<int>(route.size()) : 0) != expected[q];
+                if (static_cast<int>(q) >= config.warmup) {
+                    result.samples.push_back(stats.elapsedMs);
+                    settled += stats.settled;
+                }
+            }
+            result.counters.push_back({"mean_settled", settled / routes});
+            result.counters.push_back({"mismatches", static_cast<double>(mismatches)});
+            results.push_back(result);
+            if (mismatches > 0) {
+                cout << "landmarks: " << result.name << " differs from uninformed search on "
+                    << mismatches << " routes" << endl;
+                failedChecks = true;
+            }
+        }
+    }
+}
+
+/// @brief routes through two waypoints around 1% of systems avoided, then
+///        the same routes with the hop limit at their length, which must
+///        still succeed, and one under it, which must fail early. Each route
+///        is checked for the avoid set, waypoint order and connections, and
+///        plain and landmark planners must agree on every hop count.
+static void runConstrainedStage(const BenchConfig &config, BenchUniverse &universe,
+                                mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    const UniverseSpec &spec = config.spec;
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    RoutePlanner plain, guided;
+    plain.build(index);
+    guided.setLandmarks(config.landmarks);
+    guided.build(index);
+    SystemSet avoid;
+    for (int i = 0; i < spec.systems / 100; i++) {
+        avoid.insert(anySystem(rng));
+    }
+    auto allowed = [&]() {
+        int id = anySystem(rng);
+        while (avoid.contains(id)) {
+            id = anySystem(rng);
+        }
+        return id;
+    };
+    int routes = max(1, config.queries / 10);
+    vector<RouteConstraints> requests;
+    vector<pair<int, int>> pairs;
+    for (int q = 0; q < config.warmup + routes; q++) {
+        RouteConstraints constraints;
+        constraints.avoid = avoid;
+        constraints.waypoints = {allowed(), allowed()};
+        requests.push_back(constraints);
+        pairs.push_back({allowed(), allowed()});
+    }
+    auto valid = [&](const vector<int> &route, const RouteConstraints &constraints, int start, int end) {
+        if (route.empty() || route.front() != start || route.back() != end) {
+            return false;
+        }
+        size_t waypoint = 0;
+        for (size_t i = 0; i < route.size(); i++) {
+            if (constraints.avoid.contains(route[i])) {
+                return false;
+            }
+            if (i > 0) {
+                const vector<int> &next = index.neighbors(route[i - 1]);
+                if (find(next.begin(), next.end(), route[i]) == next.end()) {
+                    return false;
+                }
+            }
+            if (waypoint < constraints.waypoints.size() && route[i] == constraints.waypoints[waypoint]) {
+                waypoint++;
+            }
+        }
+        return waypoint == constraints.waypoints.size() &&
+               (constraints.maxHops < 0 || static_cast<int>(route.size()) - 1 <= constraints.maxHops);
+    };
+
+    vector<int> expected(pairs.size());
+    long mismatches = 0, found = 0;
+    vector<int> route;
+    size_t first = results.size();
+    for (RoutePlanner *planner : {&plain, &guided}) {
+        bool isGuided = planner == &guided;
+        StageResult open{isGuided ? "constrained_alt" : "constrained_astar", {}, 1, {}};
+        StageResult tight{isGuided ? "constrained_alt_limit" : "constrained_astar_limit", {}, 1, {}};
+        StageResult under{isGuided ? "constrained_alt_under" : "constrained_astar_under", {}, 1, {}};
+        double openSettled = 0, tightSettled = 0, underSettled = 0;
+        for (size_t q = 0; q < pairs.size(); q++) {
+            RouteConstraints constraints = requests[q];
+            int start = pairs[q].first, end = pairs[q].second;
+            RouteStats a, b, c;
+            bool ok = planner->findConstrainedRoute(start, end, constraints, route, &a);
+            int hops = ok ? static_cast<int>(route.size()) - 1 : -1;
+            if (isGuided ? hops != expected[q] : (ok && !valid(route, constraints, start, end))) {
+                mismatches++;
+            }
+            expected[q] = hops;
+            if (ok) {
+                found += !isGuided && static_cast<int>(q) >= config.warmup;
+                constraints.maxHops = hops;
+                if (!planner->findConstrainedRoute(start, end, constraints, route, &b) ||
+                    !valid(route, constraints, start, end)) {
+                    mismatches++;
+                }
+                if (hops > 0) {
+                    constraints.maxHops = hops - 1;
+                    mismatches += planner->findConstrainedRoute(start, end, constraints, route, &c);
+                }
+            }
+            if (static_cast<int>(q) >= config.warmup) {
+                open.samples.push_back(a.elapsedMs);
+                openSettled += a.settled;
+                if (ok) {
+                    tight.samples.push_back(b.elapsedMs);
+                    under.samples.push_back(c.elapsedMs);
+                    tightSettled += b.settled;
+                    underSettled += c.settled;
+                }
+            }
+        }
+        open.counters.push_back({"mean_settled", openSettled / routes});
+        results.push_back(open);
+        if (!tight.samples.empty()) {
+            tight.counters.push_back({"mean_settled", tightSettled / tight.samples.size()});
+            under.counters.push_back({"mean_settled", underSettled / under.samples.size()});
+            results.push_back(tight);
+            results.push_back(under);
+        }
+    }
+    results[first].counters.push_back({"routed", static_cast<double>(found)});
+    results[first].counters.push_back({"avoided", static_cast<double>(avoid.count())});
+    if (mismatches > 0) {
+        cout << "constrained: " << mismatches << " routes broke their constraints or disagree" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief round trips through 10, 50 and 500 stops that can all reach each
+///        other. Each trip must leave from and return to the origin along
+///        real connections, visit every stop, and take as many hops as its
+///        order does in the matrix. The heuristic is also run on the exact
+///        cases to see how far from optimal it lands.
+static void runItineraryStage(const BenchConfig &config, BenchUniverse &universe,
+                              mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    RoutePlanner planner;
+    planner.build(index);
+    ItineraryPlanner itineraries(planner);
+    long mismatches = 0;
+    for (int want : {10, 50, 500}) {
+        int origin = anySystem(rng);
+        vector<int> candidates = {origin};
+        for (int i = 0; i < 3 * want; i++) {
+            candidates.push_back(anySystem(rng));
+        }
+        vector<int> reach = itineraries.hopMatrix(candidates);
+        int c = candidates.size();
+        vector<int> stops = {origin};
+        for (int i = 1; i < c && static_cast<int>(stops.size()) < want; i++) {
+            if (reach[i] < ItineraryPlanner::kNoRoute && reach[i * c] < ItineraryPlanner::kNoRoute &&
+                find(stops.begin(), stops.end(), candidates[i]) == stops.end()) {
+                stops.push_back(candidates[i]);
+            }
+        }
+        int n = stops.size();
+
+        StageResult result{"itinerary_" + to_string(want), {}, 1, {}};
+        ItineraryStats stats, total;
+        Itinerary itinerary;
+        for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+            double ms = timeMs([&]() { itineraries.plan(stops, itinerary, &stats); });
+            if (rep >= config.warmup) {
+                result.samples.push_back(ms);
+                total.matrixMs += stats.matrixMs;
+                total.orderMs += stats.orderMs;
+                total.expandMs += stats.expandMs;
+            }
+        }
+        vector<int> matrix = itineraries.hopMatrix(itinerary.order);
+        vector<int> inOrder(n);
+        for (int i = 0; i < n; i++) {
+            inOrder[i] = i;
+        }
+        bool connected = !itinerary.route.empty() && itinerary.route.front() == origin &&
+                         itinerary.route.back() == origin;
+        for (size_t i = 1; i < itinerary.route.size(); i++) {
+            auto next = planner.neighbors(planner.vertexOf(itinerary.route[i - 1]));
+            connected = connected && find(next.first, next.second, planner.vertexOf(itinerary.route[i])) != next.second;
+        }
+        for (int stop : stops) {
+            connected = connected && find(itinerary.route.begin(), itinerary.route.end(), stop) != itinerary.route.end();
+        }
+        if (!connected || static_cast<int>(itinerary.order.size()) != n ||
+            itinerary.hops != ItineraryPlanner::tripHops(matrix, n, inOrder)) {
+            mismatches++;
+        }
+
+        result.counters.push_back({"stops", static_cast<double>(n)});
+        result.counters.push_back({"matrix_ms", total.matrixMs / config.reps});
+        result.counters.push_back({"order_ms", total.orderMs / config.reps});
+        result.counters.push_back({"route_ms", total.expandMs / config.reps});
+        result.counters.push_back({"hops", static_cast<double>(itinerary.hops)});
+        if (stats.exact) {
+            long firstHops = 0;
+            vector<int> guess = itineraries.solveHeuristic(matrix, n, &firstHops);
+            long heuristicHops = ItineraryPlanner::tripHops(matrix, n, guess);
+            result.counters.push_back({"heuristic_hops", static_cast<double>(heuristicHops)});
+            result.counters.push_back({"nearest_hops", static_cast<double>(firstHops)});
+            mismatches += heuristicHops < itinerary.hops;
+        } else {
+            result.counters.push_back({"nearest_hops", static_cast<double>(stats.firstHops)});
+            result.counters.push_back({"moves", static_cast<double>(stats.improvements)});
+        }
+        results.push_back(result);
+    }
+    if (mismatches > 0) {
+        cout << "itinerary: " << mismatches << " trips were broken or beat the exact order" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief earliest arrival over departures spread across the longest orbits.
+///        Each arrival must match its route flown through the tables, must
+///        not come after the fewest hop route flown the same day, and must
+///        never come earlier for a later departure.
+static void runOrbitalStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    OrbitalRouter router;
+    StageResult build{"orbital_build", {}, 1, {}};
+    build.samples.push_back(timeMs([&]() { router.build(index); }));
+    build.counters.push_back({"table_mb", router.tableBytes() / (1024.0 * 1024.0)});
+    results.push_back(build);
+
+    RoutePlanner planner;
+    planner.build(index);
+    StageResult result{"route_earliest", {}, 1, {}};
+    double settled = 0, days = 0, saved = 0;
+    long mismatches = 0, answered = 0, slower = 0;
+    int routes = max(1, config.queries / 100);
+    vector<int> route, fewest;
+    for (int q = 0; q < config.warmup + routes; q++) {
+        int start = anySystem(rng), end = anySystem(rng);
+        bool reachable = planner.findRoute(start, end, fewest);
+        double lastArrival = 0.0;
+        for (int departure = 0; departure <= 5000; departure += 500) {
+            RouteStats stats;
+            double arriveDay = 0.0;
+            bool found = router.findEarliestArrival(start, end, departure, route, arriveDay, &stats);
+            double hopArrival = reachable ? router.followRoute(fewest, departure) : 0.0;
+            if (found != reachable ||
+                (found && (fabs(router.followRoute(route, departure) - arriveDay) > 1e-6 ||
+                           arriveDay > hopArrival + 1e-6 || arriveDay < lastArrival - 1e-3))) {
+                mismatches++;
+            }
+            lastArrival = arriveDay;
+            if (q >= config.warmup) {
+                result.samples.push_back(stats.elapsedMs);
+                settled += stats.settled;
+                if (found) {
+                    answered++;
+                    days += arriveDay - departure;
+                    saved += hopArrival - arriveDay;
+                    slower += route.size() > fewest.size();
+                }
+            }
+        }
+    }
+    result.counters.push_back({"mean_settled", settled / result.samples.size()});
+    result.counters.push_back({"mean_days", answered > 0 ? days / answered : 0.0});
+    result.counters.push_back({"days_saved", answered > 0 ? saved / answered : 0.0});
+    result.counters.push_back({"longer_routes_pct", answered > 0 ? 100.0 * slower / answered : 0.0});
+    results.push_back(result);
+    if (mismatches > 0) {
+        cout << "orbital: " << mismatches << " earliest arrivals were inconsistent" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief fewest hop routes for ships that must refuel, with ranges a small
+///        multiple of the mean jump, where refuelling is common (FGK stars
+///        or artificial satellites) and where it is rare (G stars only).
+///        Each route is flown again to check it never runs dry, and with
+///        unlimited range it must match the unconstrained hop count.
+static void runRangedStage(const BenchConfig &config, BenchUniverse &universe,
+                           mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    RoutePlanner planner;
+    planner.build(index);
+    double jumps = 0;
+    long edges = 0;
+    for (int id = 0; id < planner.size(); id++) {
+        auto next = planner.neighbors(id);
+        for (const int *to = next.first; to != next.second; to++, edges++) {
+            jumps += planner.jumpLength(planner.systemOf(id), planner.systemOf(*to));
+        }
+    }
+    double meanJump = edges > 0 ? jumps / edges : 1.0;
+    RefuelPolicy common, rare;
+    rare.starClasses = "G";
+    rare.artificialSatellites = false;
+
+    int routes = max(1, config.queries / 10);
+    vector<pair<int, int>> pairs;
+    vector<int> expected;
+    vector<int> route;
+    for (int q = 0; q < config.warmup + routes; q++) {
+        pairs.push_back({anySystem(rng), anySystem(rng)});
+        expected.push_back(planner.findRouteUninformed(pairs[q].first, pairs[q].second, route) ? route.size() : 0);
+    }
+
+    long mismatches = 0;
+    for (const RefuelPolicy *policy : {&common, &rare}) {
+        StageResult refuelBuild{string("refuel_set_") + (policy == &common ? "common" : "rare"), {}, 1, {}};
+        SystemSet refuel;
+        refuelBuild.samples.push_back(timeMs([&]() { refuel = findRefuelSystems(index, *policy); }));
+        refuelBuild.counters.push_back({"refuel_pct", 100.0 * refuel.count() / max(1, planner.size())});
+        results.push_back(refuelBuild);
+
+        for (double multiple : {1.5, 3.0, 0.0}) {
+            double range = multiple > 0.0 ? multiple * meanJump : 1e300;
+            ostringstream name;
+            name << "route_ranged_" << (policy == &common ? "common_" : "rare_");
+            if (multiple > 0.0) {
+                name << multiple << "x";
+            } else {
+                name << "unlimited";
+            }
+            StageResult result{name.str(), {}, 1, {}};
+            double settled = 0, extraHops = 0;
+            long found = 0, reachable = 0;
+            for (size_t q = 0; q < pairs.size(); q++) {
+                RouteStats stats;
+                bool ok = planner.findRangedRoute(pairs[q].first, pairs[q].second, range, refuel, route, &stats);
+                double fuel = range;
+                bool flown = ok && route.front() == pairs[q].first && route.back() == pairs[q].second;
+                for (size_t i = 1; flown && i < route.size(); i++) {
+                    auto next = planner.neighbors(planner.vertexOf(route[i - 1]));
+                    fuel -= planner.jumpLength(route[i - 1], route[i]);
+                    flown = find(next.first, next.second, planner.vertexOf(route[i])) != next.second && fuel >= 0.0;
+                    if (refuel.contains(route[i])) {
+                        fuel = range;
+                    }
+                }
+                int hops = ok ? route.size() : 0;
+                if ((ok && (!flown || hops < expected[q])) || (ok && expected[q] == 0) ||
+                    (multiple == 0.0 && hops != expected[q])) {
+                    mismatches++;
+                }
+                if (static_cast<int>(q) >= config.warmup) {
+                    result.samples.push_back(stats.elapsedMs);
+                    settled += stats.settled;
+                    reachable += expected[q] > 0;
+                    found += ok;
+                    extraHops += ok ? hops - expected[q] : 0;
+                }
+            }
+            result.counters.push_back({"mean_labels", settled / routes});
+            result.counters.push_back({"routed_pct", reachable > 0 ? 100.0 * found / reachable : 0.0});
+            result.counters.push_back({"extra_hops", found > 0 ? extraHops / found : 0.0});
+            results.push_back(result);
+        }
+    }
+    results.back().counters.push_back({"mean_jump", meanJump});
+    if (mismatches > 0) {
+        cout << "ranged: " << mismatches << " routes ran dry, were broken or beat fewest hops" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief rings of everything within K = 1..10 jumps on a separate graph of
+///        reachSystems systems (10M unless asked otherwise), from one origin
+///        and merged from eight. Each ring is checked against hop counts
+///        from a plain breadth first search, and the K = 10 rings are also
+///        timed streaming to a file.
+static void runReachStage(const BenchConfig &config, BenchUniverse &universe,
+                          mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    const UniverseSpec &spec = config.spec;
+
+    UniverseSpec reachSpec = spec;
+    reachSpec.systems = config.reachSystems;
+    vector<int> offsets, targets;
+    EdgeCollector collector(offsets, targets);
+    ostream edgeOut(&collector);
+    StageResult build{"reach_graph", {}, 1, {}};
+    RoutePlanner graph;
+    build.samples.push_back(timeMs([&]() {
+        writeConnectionData(edgeOut, reachSpec);
+        collector.finish(reachSpec.systems);
+        graph.build(move(offsets), move(targets));
+    }));
+    build.counters.push_back({"systems", static_cast<double>(graph.size())});
+    build.counters.push_back({"edges", static_cast<double>(countEdges(graph))});
+    build.counters.push_back({"rss_mb", residentMb()});
+    results.push_back(build);
+
+    uniform_int_distribution<int> anyNode(0, graph.size() - 1);
+    long mismatches = 0;
+    for (int origins : {1, 8}) {
+        vector<vector<int>> starts;
+        for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+            vector<int> from;
+            for (int i = 0; i < origins; i++) {
+                from.push_back(anyNode(rng));
+            }
+            starts.push_back(from);
+        }
+
+        // hop counts from the last origins by a plain search
+        vector<int> hopsTo(graph.size(), -1);
+        deque<int> queue;
+        for (int origin : starts.back()) {
+            if (hopsTo[origin] == -1) {
+                hopsTo[origin] = 0;
+                queue.push_back(origin);
+            }
+        }
+        while (!queue.empty()) {
+            int from = queue.front();
+            queue.pop_front();
+            auto next = graph.neighbors(from);
+            for (const int *to = next.first; to != next.second; to++) {
+                if (hopsTo[*to] == -1) {
+                    hopsTo[*to] = hopsTo[from] + 1;
+                    queue.push_back(*to);
+                }
+            }
+        }
+        vector<long> perRing(12, 0);
+        for (int hops : hopsTo) {
+            if (hops >= 0 && hops < 12) {
+                perRing[hops]++;
+            }
+        }
+
+        for (int k = 1; k <= 10; k++) {
+            StageResult result{"reach_" + to_string(origins) + "_origin" + (origins > 1 ? "s_k" : "_k") + to_string(k), {}, 1, {}};
+            long reached = 0, total = 0;
+            for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+                bool check = rep == config.warmup + config.reps - 1;
+                double ms = timeMs([&]() {
+                    reached = graph.findReachable(starts[rep], k, [&](int hops, const vector<int> &ring) {
+                        if (check) {
+                            mismatches += static_cast<long>(ring.size()) != perRing[hops];
+                            for (int id : ring) {
+                                mismatches += hopsTo[id] != hops;
+                            }
+                        }
+                    });
+                });
+                if (rep >= config.warmup) {
+                    result.samples.push_back(ms);
+                    total += reached;
+                }
+            }
+            result.counters.push_back({"mean_reached", static_cast<double>(total) / config.reps});
+            results.push_back(result);
+        }
+    }
+
+    const string fileName = "bench_reach_rings.csv";
+    StageResult streamed{"reach_stream_k10", {}, 1, {}};
+    long bytes = 0, totalBytes = 0;
+    for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+        int origin = anyNode(rng);
+        double ms = timeMs([&]() {
+            ofstream out(fileName);
+            graph.findReachable({origin}, 10, [&](int hops, const vector<int> &ring) {
+                for (int id : ring) {
+                    out << hops << ",SYS" << id << "\n";
+                }
+            });
+            bytes = out.tellp();
+        });
+        if (rep >= config.warmup) {
+            streamed.samples.push_back(ms);
+            totalBytes += bytes;
+        }
+    }
+    streamed.counters.push_back({"mean_file_mb", totalBytes / (1024.0 * 1024.0) / config.reps});
+    results.push_back(streamed);
+    remove(fileName.c_str());
+
+    if (mismatches > 0) {
+        cout << "reach: " << mismatches << " ring entries disagree with breadth first search" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief components, PageRank and betweenness. Exact betweenness runs up
+///        to 20k systems and must sum to the interior systems of every
+///        fewest hop route, sum over pairs of hops - 1, whatever the
+///        number of workers. Sampled estimates are timed against the exact
+///        top 20.
+static void runAnalyticsStage(const BenchConfig &config, BenchUniverse &universe,
+                              vector<StageResult> &results, bool &failedChecks) {
+    SystemIndex &index = universe.index;
+
+    RoutePlanner planner;
+    planner.build(index);
+    GraphAnalytics analytics(planner);
+    int n = planner.size();
+    long mismatches = 0;
+
+    StageResult components{"components", {}, 1, {}};
+    vector<int> sizes;
+    for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+        double ms = timeMs([&]() { analytics.components(sizes); });
+        if (rep >= config.warmup) {
+            components.samples.push_back(ms);
+        }
+    }
+    components.counters.push_back({"components", static_cast<double>(sizes.size())});
+    components.counters.push_back({"largest", sizes.empty() ? 0.0 : static_cast<double>(sizes[0])});
+    mismatches += accumulate(sizes.begin(), sizes.end(), 0L) != n;
+    results.push_back(components);
+
+    StageResult ranked{"pagerank", {}, 1, {}};
+    int iterations = 0;
+    vector<double> ranks;
+    for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+        double ms = timeMs([&]() { ranks = analytics.pageRank(0.85, 1e-9, 100, &iterations); });
+        if (rep >= config.warmup) {
+            ranked.samples.push_back(ms);
+        }
+    }
+    ranked.counters.push_back({"iterations", static_cast<double>(iterations)});
+    mismatches += fabs(accumulate(ranks.begin(), ranks.end(), 0.0) - 1.0) > 1e-6;
+    results.push_back(ranked);
+
+    vector<double> exact;
+    if (n <= 20000) {
+        for (int workers : {1, 4}) {
+            analytics.setWorkers(workers);
+            StageResult result{"betweenness_exact_w" + to_string(workers), {}, 1, {}};
+            vector<double> scores;
+            result.samples.push_back(timeMs([&]() { scores = analytics.betweenness(); }));
+            results.push_back(result);
+            if (exact.empty()) {
+                exact = scores;
+            }
+            for (int v = 0; v < n; v++) {
+                mismatches += fabs(scores[v] - exact[v]) > 1e-9 * max(1.0, exact[v]);
+            }
+        }
+        // every fewest hop route of d hops passes d - 1 systems
+        double interior = 0.0;
+        for (int source = 0; source < n; source++) {
+            planner.findReachable({source}, -1, [&](int hops, const vector<int> &ring) {
+                interior += hops > 0 ? (hops - 1.0) * ring.size() : 0.0;
+            });
+        }
+        double total = accumulate(exact.begin(), exact.end(), 0.0);
+        mismatches += fabs(total - interior) > 1e-6 * max(1.0, interior);
+    }
+
+    vector<pair<int, double>> exactTop = exact.empty() ? vector<pair<int, double>>() : GraphAnalytics::topN(exact, 20);
+    for (int samples : {64, 256, 1024}) {
+        for (int workers : {1, 4}) {
+            analytics.setWorkers(workers);
+            StageResult result{"betweenness_s" + to_string(samples) + "_w" + to_string(workers), {}, 1, {}};
+            vector<double> scores;
+            for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+                double ms = timeMs([&]() { scores = analytics.betweenness(samples, rep + 1); });
+                if (rep >= config.warmup) {
+                    result.samples.push_back(ms);
+                }
+            }
+            if (!exactTop.empty()) {
+                vector<pair<int, double>> top = GraphAnalytics::topN(scores, 20);
+                int overlap = 0;
+                double error = 0.0;
+                for (const auto &[id, score] : exactTop) {
+                    overlap += any_of(top.begin(), top.end(), [&](const pair<int, double> &p) { return p.first == id; });
+                    error += fabs(scores[id] - score) / max(1.0, score);
+                }
+                result.counters.push_back({"top20_overlap", static_cast<double>(overlap)});
+                result.counters.push_back({"top20_rel_error", error / exactTop.size()});
+            }
+            results.push_back(result);
+        }
+    }
+    analytics.setWorkers(0);
+    if (mismatches > 0) {
+        cout << "analytics: " << mismatches << " results failed their checks" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief the generated graph of reachSystems systems, once as generated
+///        and once with its ids shuffled the way a catalogue in no
+///        particular order scatters neighbours, then numbered each way.
+///        Breadth first searches, routes, components and PageRank must
+///        agree through the shuffle whatever the numbering; mean_gap is how
+///        far apart the two ends of a connection sit in the arrays.
+static void runReorderStage(const BenchConfig &config, BenchUniverse &universe,
+                            mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    const UniverseSpec &spec = config.spec;
+
+    UniverseSpec reorderSpec = spec;
+    reorderSpec.systems = config.reachSystems;
+    vector<int> offsets, targets;
+    EdgeCollector collector(offsets, targets);
+    ostream edgeOut(&collector);
+    writeConnectionData(edgeOut, reorderSpec);
+    collector.finish(reorderSpec.systems);
+    int n = offsets.size() - 1;
+
+    // system i of the generated graph is system shuffled[i] of the other
+    vector<int> shuffled(n), shuffledOffsets(n + 1, 0), shuffledTargets(targets.size());
+    iota(shuffled.begin(), shuffled.end(), 0);
+    shuffle(shuffled.begin(), shuffled.end(), rng);
+    for (int i = 0; i < n; i++) {
+        shuffledOffsets[shuffled[i] + 1] = offsets[i + 1] - offsets[i];
+    }
+    partial_sum(shuffledOffsets.begin(), shuffledOffsets.end(), shuffledOffsets.begin());
+    for (int i = 0; i < n; i++) {
+        int at = shuffledOffsets[shuffled[i]];
+        for (int j = offsets[i]; j < offsets[i + 1]; j++) {
+            shuffledTargets[at++] = shuffled[targets[j]];
+        }
+    }
+
+    uniform_int_distribution<int> anyNode(0, n - 1);
+    int routes = max(1, config.queries / 100);
+    vector<pair<int, int>> pairs;
+    for (int q = 0; q < routes; q++) {
+        pairs.push_back({anyNode(rng), anyNode(rng)});
+    }
+    vector<int> origins;
+    for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+        origins.push_back(anyNode(rng));
+    }
+
+    struct Numbering
+    {
+        string name;
+        bool shuffled;
+        SystemOrder order;
+    };
+    vector<Numbering> numberings = {{"load", false, SystemOrder::Load}, {"shuffled", true, SystemOrder::Load},
+                                    {"shuffled_bfs", true, SystemOrder::Bfs}, {"shuffled_rcm", true, SystemOrder::Rcm},
+                                    {"shuffled_degree", true, SystemOrder::Degree}};
+    vector<long> baseReached, baseHops;
+    vector<double> baseRanks;
+    vector<int> baseSizes;
+    long mismatches = 0;
+    for (const Numbering &numbering : numberings) {
+        auto id = [&](int system) { return numbering.shuffled ? shuffled[system] : system; };
+        RoutePlanner planner;
+        planner.setOrder(numbering.order);
+        double buildMs = timeMs([&]() {
+            if (numbering.shuffled) {
+                planner.build(shuffledOffsets, shuffledTargets);
+            } else {
+                planner.build(offsets, targets);
+            }
+        });
+        double gap = 0.0;
+        long edges = 0;
+        for (int v = 0; v < planner.size(); v++) {
+            auto [first, last] = planner.neighbors(v);
+            for (const int *to = first; to != last; to++, edges++) {
+                gap += abs(*to - v);
+            }
+        }
+
+        StageResult bfs{"reorder_bfs_" + numbering.name, {}, 1, {}};
+        vector<long> reachedFrom;
+        long systemsSeen = 0;
+        for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+            long reached = 0, hopSum = 0;
+            double ms = timeMs([&]() {
+                reached = planner.findReachable({id(origins[rep])}, -1, [&](int hops, const vector<int> &ring) {
+                    hopSum += static_cast<long>(hops) * ring.size();
+                });
+            });
+            reachedFrom.push_back(reached);
+            reachedFrom.push_back(hopSum);
+            if (rep >= config.warmup) {
+                bfs.samples.push_back(ms);
+                systemsSeen += reached;
+            }
+        }
+        bfs.counters.push_back({"build_ms", buildMs});
+        bfs.counters.push_back({"mean_gap", edges > 0 ? gap / edges : 0.0});
+        bfs.counters.push_back({"reached", static_cast<double>(systemsSeen) / config.reps});
+        results.push_back(bfs);
+
+        StageResult route{"reorder_route_" + numbering.name, {}, routes, {}};
+        vector<long> hopsOf;
+        vector<int> path;
+        for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+            hopsOf.clear();
+            double ms = timeMs([&]() {
+                for (const auto &[start, end] : pairs) {
+                    bool found = planner.findRoute(id(start), id(end), path);
+                    hopsOf.push_back(found ? static_cast<long>(path.size()) : -1L);
+                }
+            });
+            if (rep >= config.warmup) {
+                route.samples.push_back(ms);
+            }
+        }
+        results.push_back(route);
+
+        GraphAnalytics analytics(planner);
+        StageResult stats{"reorder_stats_" + numbering.name, {}, 1, {}};
+        vector<double> ranks;
+        vector<int> sizes;
+        int iterations = 0;
+        for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+            double ms = timeMs([&]() {
+                analytics.components(sizes);
+                ranks = analytics.pageRank(0.85, 1e-9, 100, &iterations);
+            });
+            if (rep >= config.warmup) {
+                stats.samples.push_back(ms);
+            }
+        }
+        stats.counters.push_back({"iterations", static_cast<double>(iterations)});
+        results.push_back(stats);
+
+        if (!numbering.shuffled) {
+            baseReached = reachedFrom;
+            baseHops = hopsOf;
+            baseRanks = ranks;
+            baseSizes = sizes;
+            continue;
+        }
+        mismatches += reachedFrom != baseReached || hopsOf != baseHops || sizes != baseSizes;
+        for (int system = 0; system < n; system++) {
+            mismatches += fabs(ranks[shuffled[system]] - baseRanks[system]) > 1e-6 * baseRanks[system];
+        }
+    }
+    if (mismatches > 0) {
+        cout << "reorder: " << mismatches << " results differ between numberings" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief contraction hierarchy against the plain search it replaces. Each
+///        route must have the plain search's hop count and follow real
+///        connections once unpacked.
+static void runHierarchyStage(const BenchConfig &config, BenchUniverse &universe,
+                              mt19937_64 &rng, vector<StageResult> &results, bool &failedChecks) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    ContractionHierarchy hierarchy;
+    RoutePlanner planner;
+    planner.build(index);
+    StageResult build{"hierarchy_build", {}, 1, {}};
+    build.samples.push_back(timeMs([&]() { hierarchy.build(index); }));
+    HierarchyStats built = hierarchy.getStats();
+    build.counters.push_back({"core", static_cast<double>(built.coreSystems)});
+    build.counters.push_back({"shortcuts", static_cast<double>(built.shortcuts)});
+    build.counters.push_back({"index_mb", built.bytes / (1024.0 * 1024.0)});
+    results.push_back(build);
+
+    StageResult fast{"route_hierarchy", {}, 1, {}};
+    StageResult plain{"route_dijkstra", {}, 1, {}};
+    double fastSettled = 0, plainSettled = 0;
+    long mismatches = 0;
+    int routes = max(1, config.queries / 10);
+    vector<int> fastRoute, plainRoute;
+    for (int q = 0; q < config.warmup + routes; q++) {
+        int start = anySystem(rng), end = anySystem(rng);
+        RouteStats a, b;
+        bool found = hierarchy.findRoute(start, end, fastRoute, &a);
+        bool plainFound = planner.findRouteUninformed(start, end, plainRoute, &b);
+        bool connected = true;
+        for (size_t i = 1; i < fastRoute.size(); i++) {
+            const vector<int> &next = index.neighbors(fastRoute[i - 1]);
+            connected = connected && find(next.begin(), next.end(), fastRoute[i]) != next.end();
+        }
+        if (found != plainFound || fastRoute.size() != plainRoute.size() || !connected ||
+            (found && (fastRoute.front() != start || fastRoute.back() != end))) {
+            mismatches++;
+        }
+        if (q >= config.warmup) {
+            fast.samples.push_back(a.elapsedMs);
+            plain.samples.push_back(b.elapsedMs);
+            fastSettled += a.settled;
+            plainSettled += b.settled;
+        }
+    }
+    fast.counters.push_back({"mean_settled", fastSettled / routes});
+    fast.counters.push_back({"mismatches", static_cast<double>(mismatches)});
+    plain.counters.push_back({"mean_settled", plainSettled / routes});
+    results.push_back(fast);
+    results.push_back(plain);
+    if (mismatches > 0) {
+        cout << "hierarchy: " << mismatches << " routes differ from the plain search" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief build the name index and time prefix and fuzzy lookups of
+///        generated names
+static void runNamesStage(const BenchConfig &config, BenchUniverse &universe,
+                          mt19937_64 &rng, vector<StageResult> &results) {
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    NameIndex names;
+    results.push_back(repeat("names_build", config, []() {}, [&]() { names.build(index); }));
+
+    StageResult prefix{"names_prefix", {}, 1, {}};
+    StageResult fuzzy{"names_fuzzy", {}, 1, {}};
+    for (int q = 0; q < config.warmup + config.queries; q++) {
+        string name = generatedSystemName(anySystem(rng));
+        string typo = name;
+        typo[typo.size() / 2] = 'x';
+        double prefixMs = timeMs([&]() { names.withPrefix(name.substr(0, name.size() - 1), 25); });
+        double fuzzyMs = timeMs([&]() { names.similar(typo, 2, 5, true); });
+        if (q >= config.warmup) {
+            prefix.samples.push_back(prefixMs);
+            fuzzy.samples.push_back(fuzzyMs);
+        }
+    }
+    results.push_back(prefix);
+    results.push_back(fuzzy);
+}
+
+/// @brief build the attribute query engine and time a selective and a
+///        non-selective query
+static void runQueryStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results) {
+    SystemIndex &index = universe.index;
+
+    QueryEngine queries;
+    results.push_back(repeat("query_build", config, []() {}, [&]() { queries.build(index); }));
+
+    size_t selective = 0, nonSelective = 0;
+    results.push_back(repeat("query_selective", config, []() {}, [&]() {
+        selective = queries.run("star type=G2* mass>2.9").rows.size();
+    }));
+    results.back().counters.push_back({"rows", static_cast<double>(selective)});
+    results.push_back(repeat("query_nonselective", config, []() {}, [&]() {
+        nonSelective = queries.run("planet radius>1").rows.size();
+    }));
+    results.back().counters.push_back({"rows", static_cast<double>(nonSelective)});
+}
+
+/// @brief satellites spread over 1000 planets of one system, through the
+///        loader so planet lookup and duplicate checks are included
+static void runSatellitesStage(const BenchConfig &config, BenchUniverse &universe,
+                               vector<StageResult> &results) {
+    ostringstream out;
+    for (long s = 0; s < config.satelliteLoad; s++) {
+        out << "Satellite,BM" << s << ",BP" << s % 1000 << ",BENCH,0.5,No\n";
+    }
+    string satelliteData = out.str();
+    vector<shared_ptr<SolarSystem>> benchSystems;
+    SystemIndex benchIndex;
+    StageResult result = repeat("satellite_load", config, [&]() {
+        benchSystems.clear();
+        benchIndex.clear();
+    }, [&]() {
+        istringstream in(satelliteData);
+        loadCelestialObjects(in, benchSystems, benchIndex);
+    });
+    result.opsPerSample = config.satelliteLoad;
+    results.push_back(result);
+}
+
+/// @brief one writer swaps between two connection sets, publishing after
+///        each, while readers route and read details from pinned snapshots.
+///        Readers check every snapshot they see is whole: its edge count is
+///        that of one set, routes follow its own connections, names and
+///        details agree, and sequence numbers never go backwards.
+static void runSnapshotStage(const BenchConfig &config, BenchUniverse &universe,
+                             vector<StageResult> &results, bool &failedChecks) {
+    const UniverseSpec &spec = config.spec;
+    const string &connectionData = universe.connectionData;
+    vector<shared_ptr<SolarSystem>> &systems = universe.systems;
+    SystemIndex &index = universe.index;
+
+    UniverseSpec rewired = spec;
+    rewired.seed += 1;
+    ostringstream rewiredOut;
+    writeConnectionData(rewiredOut, rewired);
+    const string connectionSets[2] = {connectionData, rewiredOut.str()};
+    auto applySet = [&](int set) {
+        for (const auto &system : systems) {
+            system->clearConnections();
+        }
+        index.clearConnections();
+        istringstream in(connectionSets[set]);
+        loadSolarSystemConnections(in, systems, index);
+    };
+
+    long edges[2];
+    for (int set : {1, 0}) {
+        applySet(set);
+        RoutePlanner counted;
+        counted.build(index);
+        edges[set] = countEdges(counted);
+    }
+
+    long violations = 0;
+    StageResult publishResult{"snapshot_publish", {}, 1, {}};
+    vector<int> readerCounts;
+    for (int readers = 1; readers < config.readers; readers *= 2) {
+        readerCounts.push_back(readers);
+    }
+    readerCounts.push_back(config.readers);
+
+    for (int readers : readerCounts) {
+        // sequence s holds set (s - 1) % 2, the live systems hold set 0
+        SnapshotPublisher publisher;
+        publisher.publish(systems, index);
+        atomic<bool> stop{false};
+        atomic<long> failures{0};
+        vector<long> reads(readers, 0);
+        vector<vector<double>> samples(readers);
+
+        const int numSystems = index.size();
+        auto started = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (int r = 0; r < readers; r++) {
+            threads.emplace_back([&, r]() {
+                SnapshotReader reader(publisher);
+                mt19937_64 local(spec.seed + 100 + r);
+                uniform_int_distribution<int> pick(0, numSystems - 1);
+                uint64_t lastSeen = 0;
+                vector<int> route;
+                while (!stop.load(memory_order_relaxed)) {
+                    int a = pick(local), b = pick(local);
+                    long failed = 0;
+                    double ms = timeMs([&]() {
+                        SnapshotReader::Pin snapshot = reader.pin();
+                        uint64_t sequence = snapshot->getSequence();
+                        if (sequence < lastSeen) {
+                            failed++;
+                        } else if (sequence != lastSeen) {
+                            lastSeen = sequence;
+                            failed += countEdges(snapshot->getPlanner()) != edges[(sequence - 1) % 2];
+                        }
+                        if (snapshot->findRoute(a, b, route, reader.getScratch())) {
+                            failed += route.front() != a || route.back() != b;
+                            for (size_t i = 0; i + 1 < route.size(); i++) {
+                                const RoutePlanner &planner = snapshot->getPlanner();
+                                auto [first, last] = planner.neighbors(planner.vertexOf(route[i]));
+                                failed += find(first, last, planner.vertexOf(route[i + 1])) == last;
+                            }
+                        }
+                        const string &name = snapshot->nameOf(a);
+                        failed += snapshot->idOf(name) != a;
+                        failed += snapshot->detailsOf(a).compare(0, name.size(), name) != 0;
+                    });
+                    if (failed != 0) {
+                        failures.fetch_add(failed);
+                    }
+                    if (reads[r]++ % 16 == 0) {
+                        samples[r].push_back(ms);
+                    }
+                }
+            });
+        }
+
+        uint64_t maxPending = 0;
+        for (int update = 0; update < config.warmup + config.reps; update++) {
+            double ms = timeMs([&]() {
+                applySet((update + 1) % 2);
+                publisher.publish(systems, index);
+            });
+            if (update >= config.warmup) {
+                publishResult.samples.push_back(ms);
+            }
+            maxPending = max(maxPending, publisher.getStats().pending);
+        }
+        stop.store(true);
+        for (thread &worker : threads) {
+            worker.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        if (publisher.current()->getSequence() % 2 == 0) {
+            applySet(0);
+        }
+
+        // with every reader gone nothing may stay retired
+        publisher.reclaim();
+        SnapshotStats stats = publisher.getStats();
+        long leaked = static_cast<long>(stats.pending);
+        violations += failures.load() + leaked;
+
+        StageResult result{"snapshot_read_r" + to_string(readers), {}, 1, {}};
+        long totalReads = 0;
+        for (int r = 0; r < readers; r++) {
+            result.samples.insert(result.samples.end(), samples[r].begin(), samples[r].end());
+            totalReads += reads[r];
+        }
+        result.counters.push_back({"readers", static_cast<double>(readers)});
+        result.counters.push_back({"reads_per_s", totalReads / seconds});
+        result.counters.push_back({"published", static_cast<double>(stats.published)});
+        result.counters.push_back({"reclaimed", static_cast<double>(stats.reclaimed)});
+        result.counters.push_back({"max_pending", static_cast<double>(maxPending)});
+        result.counters.push_back({"violations", static_cast<double>(failures.load() + leaked)});
+        results.push_back(result);
+        publishResult.counters = {{"capture_ms", stats.lastCaptureMs}};
+    }
+    results.push_back(publishResult);
+    if (violations != 0) {
+        cout << "snapshot: " << violations << " consistency violations" << endl;
+        failedChecks = true;
+    }
+}
+
+/// @brief time to first query: load, connect and answer one route, lazily
+///        then eagerly, with the heap each leaves behind. Lazy runs first
+///        so the process RSS it reports is not inflated by the eager run.
+static void runLazyStage(const BenchConfig &config, BenchUniverse &universe,
+                         mt19937_64 &rng, vector<StageResult> &results) {
+    const string &celestialData = universe.celestialData;
+    const string &connectionData = universe.connectionData;
+    SystemIndex &index = universe.index;
+    uniform_int_distribution<int> anySystem(0, index.size() - 1);
+
+    const string fileName = "bench_lazy_celestial.csv";
+    {
+        ofstream out(fileName, ios::binary);
+        out << celestialData;
+    }
+    int start = anySystem(rng), end = anySystem(rng);
+
+    for (bool lazyMode : {true, false}) {
+        StageResult result{lazyMode ? "ttfq_lazy" : "ttfq_eager", {}, 1, {}};
+        StageResult detail{"lazy_detail", {}, 1, {}};
+        double heap = 0.0;
+        for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+            double before = heapMb();
+            vector<shared_ptr<SolarSystem>> freshSystems;
+            SystemIndex freshIndex;
+            LazyCatalog lazy;
+            RoutePlanner planner;
+            vector<int> route;
+            double ms = timeMs([&]() {
+                if (lazyMode) {
+                    lazy.open(fileName, freshSystems, freshIndex, 1024);
+                } else {
+                    ifstream in(fileName, ios::binary);
+                    loadCelestialObjects(in, freshSystems, freshIndex);
+                }
+                istringstream connections(connectionData);
+                loadSolarSystemConnections(connections, freshSystems, freshIndex);
+                planner.build(freshIndex);
+                planner.findRoute(start, end, route);
+            });
+            if (rep >= config.warmup) {
+                result.samples.push_back(ms);
+            }
+
+            // on the last repetition, details on demand through the
+            // bounded cache, which also fills it for the heap figure
+            if (lazyMode && rep + 1 == config.warmup + config.reps) {
+                for (int q = 0; q < config.warmup + config.queries; q++) {
+                    int id = anySystem(rng);
+                    double detailMs = timeMs([&]() {
+                        lazy.ensureLoaded(id);
+                        freshSystems[id]->toString();
+                    });
+                    if (q >= config.warmup) {
+                        detail.samples.push_back(detailMs);
+                    }
+                }
+                detail.counters.push_back({"resident", static_cast<double>(lazy.residentCount())});
+            }
+            heap = heapMb() - before;
+        }
+        result.counters.push_back({"heap_mb", heap});
+        result.counters.push_back({"rss_mb", residentMb()});
+        results.push_back(result);
+        if (lazyMode) {
+            results.push_back(detail);
+        }
+    }
+    remove(fileName.c_str());
+}
+
+/// @brief the same celestial file loaded plain, gzipped through the
+///        streaming reader, gzipped but first inflated to a temporary file
+///        the way loading worked before, and zstd compressed when the
+///        build has zstd
+static void runCompressedStage(const BenchConfig &config, BenchUniverse &universe,
+                               vector<StageResult> &results, bool &failedChecks) {
+    const UniverseSpec &spec = config.spec;
+    const string &celestialData = universe.celestialData;
+
+    const string plainName = "bench_compressed_celestial.csv";
+    const string gzName = plainName + ".gz";
+    const string inflatedName = plainName + ".inflated";
+    {
+        ofstream out(plainName, ios::binary);
+        out << celestialData;
+    }
+    string compressed(deflateBound(nullptr, celestialData.size()) + 64, '\0');
+    z_stream deflater{};
+    deflateInit2(&deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    deflater.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(celestialData.data()));
+    deflater.avail_in = celestialData.size();
+    deflater.next_out = reinterpret_cast<Bytef *>(&compressed[0]);
+    deflater.avail_out = compressed.size();
+    deflate(&deflater, Z_FINISH);
+    compressed.resize(deflater.total_out);
+    deflateEnd(&deflater);
+    {
+        ofstream out(gzName, ios::binary);
+        out << compressed;
+    }
+
+    vector<shared_ptr<SolarSystem>> freshSystems;
+    SystemIndex freshIndex;
+    auto reset = [&]() {
+        freshSystems.clear();
+        freshIndex.clear();
+    };
+    long lines = count(celestialData.begin(), celestialData.end(), '\n');
+
+    results.push_back(repeat("load_plain_file", config, reset, [&]() {
+        ifstream in(plainName, ios::binary);
+        loadCelestialObjects(in, freshSystems, freshIndex);
+    }));
+    results.back().opsPerSample = lines;
+
+    results.push_back(repeat("load_gz_streaming", config, reset, [&]() {
+        DataFileStream in(gzName);
+        loadCelestialObjects(in, freshSystems, freshIndex);
+    }));
+    results.back().opsPerSample = lines;
+    if (static_cast<long>(freshSystems.size()) != spec.systems) {
+        cout << "compressed: streaming load found " << freshSystems.size() << " systems" << endl;
+        failedChecks = true;
+    }
+    results.back().counters.push_back({"file_mb", compressed.size() / (1024.0 * 1024.0)});
+    results.back().counters.push_back({"ratio", static_cast<double>(celestialData.size()) / compressed.size()});
+
+    results.push_back(repeat("load_gz_inflate_first", config, reset, [&]() {
+        gzFile gz = gzopen(gzName.c_str(), "rb");
+        ofstream out(inflatedName, ios::binary);
+        vector<char> block(1 << 20);
+        int got;
+        while ((got = gzread(gz, block.data(), block.size())) > 0) {
+            out.write(block.data(), got);
+        }
+        gzclose(gz);
+        out.close();
+        ifstream in(inflatedName, ios::binary);
+        loadCelestialObjects(in, freshSystems, freshIndex);
+    }));
+    results.back().opsPerSample = lines;
+
+#ifdef INTERSTELLAR_ZSTD
+    const string zstName = plainName + ".zst";
+    string packed(ZSTD_compressBound(celestialData.size()), '\0');
+    size_t packedSize = ZSTD_compress(&packed[0], packed.size(), celestialData.data(), celestialData.size(), 3);
+    if (ZSTD_isError(packedSize)) {
+        cout << "compressed: zstd failed, " << ZSTD_getErrorName(packedSize) << endl;
+        failedChecks = true;
+    } else {
+        packed.resize(packedSize);
+        {
+            ofstream out(zstName, ios::binary);
+            out << packed;
+        }
+        results.push_back(repeat("load_zstd_streaming", config, reset, [&]() {
+            DataFileStream in(zstName);
+            loadCelestialObjects(in, freshSystems, freshIndex);
+        }));
+        results.back().opsPerSample = lines;
+        results.back().counters.push_back({"file_mb", packed.size() / (1024.0 * 1024.0)});
+        results.back().counters.push_back({"ratio", static_cast<double>(celestialData.size()) / packed.size()});
+        if (static_cast<long>(freshSystems.size()) != spec.systems) {
+            cout << "compressed: zstd load found " << freshSystems.size() << " systems" << endl;
+            failedChecks = true;
+        }
+        remove(zstName.c_str());
+    }
+#else
+    cout << "compressed: zstd skipped, this build has no zstd support (make ZSTD=1 bench)" << endl;
+#endif
+
+    remove(plainName.c_str());
+    remove(gzName.c_str());
+    remove(inflatedName.c_str());
+}
+
+/// @brief the same data through the tolerant loader, applying as it goes
+///        and held back for an all or nothing commit, then with one line
+///        in a thousand broken so the transactional load refuses it
+static void runTolerantStage(const BenchConfig &config, BenchUniverse &universe,
+                             vector<StageResult> &results, bool &failedChecks) {
+    const string &celestialData = universe.celestialData;
+
+    vector<shared_ptr<SolarSystem>> freshSystems;
+    SystemIndex freshIndex;
+    auto reset = [&]() {
+        freshSystems.clear();
+        freshIndex.clear();
+    };
+    long lines = count(celestialData.begin(), celestialData.end(), '\n');
+    string brokenData;
+    {
+        istringstream in(celestialData);
+        string line;
+        for (long n = 1; getline(in, line); n++) {
+            brokenData += n % 1000 == 0 ? "Comet," + line : line;
+            brokenData += '\n';
+        }
+    }
+
+    for (bool transactional : {false, true}) {
+        for (bool broken : {false, true}) {
+            LoadOptions options;
+            options.transactional = transactional;
+            LoadReport report;
+            string name = string(transactional ? "load_transactional" : "load_tolerant") + (broken ? "_broken" : "");
+            results.push_back(repeat(name, config, reset, [&]() {
+                istringstream in(broken ? brokenData : celestialData);
+                report = LoadReport();
+                loadCelestialObjects(in, freshSystems, freshIndex, options, report);
+            }));
+            results.back().opsPerSample = lines;
+            results.back().counters.push_back({"bad_lines", static_cast<double>(report.errorCount)});
+            if (report.errorCount != (broken ? lines / 1000 : 0) ||
+                (transactional && broken) != freshSystems.empty()) {
+                cout << "tolerant: " << name << " reported " << report.errorCount << " bad lines and kept "
+                    << freshSystems.size() << " systems" << endl;
+                failedChecks = true;
+            }
+        }
+    }
+}
+
+/// @brief duplicate star checks against a system holding 10k stars
+static void runStarsStage(const BenchConfig &config, BenchUniverse &universe, vector<StageResult> &results) {
+    shared_ptr<SolarSystem> crowded = make_shared<SolarSystem>("CROWDED");
+    for (int s = 0; s < 10000; s++) {
+        crowded->insertCelestial(make_shared<Star>("CS" + to_string(s), "G2V", 5800, 1.0));
+    }
+    long found = 0;
+    StageResult result = repeat("star_duplicate_check", config, []() {}, [&]() {
+        for (int s = 0; s < 20000; s++) {
+            found += crowded->find<Star>("CS" + to_string(s)) != nullptr;
+        }
+    });
+    result.opsPerSample = 20000;
+    results.push_back(result);
+}
+
+/// @brief time a piece of work
+/// @return elapsed wall clock milliseconds
+double timeMs(const function<void()> &work) {
+    auto started = chrono::steady_clock::now();
+    work();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+}
+
+/// @return megabytes malloc has handed out, 0 where that is unknown
+double heapMb() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks / (1024.0 * 1024.0);
+#else
+    return 0.0;
+#endif
+}
+
+/// @return resident set size of the process in megabytes, 0 where unknown
+double residentMb() {
+    ifstream statm("/proc/self/statm");
+    long pages = 0, residentPages = 0;
+    if (!(statm >> pages >> residentPages)) {
+        return 0.0;
+    }
+    return residentPages * 4096.0 / (1024.0 * 1024.0);
+}
+
+/// @brief nearest rank percentile
+/// @param sorted samples in ascending order
+/// @param p percentile between 0 and 100
+double percentile(vector<double> sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size());
+    return sorted.at(min(rank, sorted.size() - 1));
+}
+
+/// @brief run setup then work warmup + reps times, timing only the work
+///        of the measured repetitions
+StageResult repeat(const string &name, const BenchConfig &config,
+                   const function<void()> &setup, const function<void()> &work) {
+    StageResult result{name, {}, 1, {}};
+    for (int rep = 0; rep < config.warmup + config.reps; rep++) {
+        setup();
+        double ms = timeMs(work);
+        if (rep >= config.warmup) {
+            result.samples.push_back(ms);
+        }
+    }
+    return result;
+}
+
+/// @return true when a stage group was asked for, or none were
+bool wanted(const BenchConfig &config, const string &stage) {
+    return config.stages.empty() ||
+           find(config.stages.begin(), config.stages.end(), stage) != config.stages.end();
+}
+
+/// @return number of connections in a planner's snapshot
+long countEdges(const RoutePlanner &planner) {
+    long edges = 0;
+    for (int id = 0; id < planner.size(); id++) {
+        auto [first, last] = planner.neighbors(id);
+        edges += last - first;
+    }
+    return edges;
+}
+
+/// @brief one console line per stage
+void printResult(const StageResult &result) {
+    vector<double> sorted = result.samples;
+    sort(sorted.begin(), sorted.end());
+    double mean = 0.0;
+    for (double ms : sorted) {
+        mean += ms;
+    }
+    mean = sorted.empty() ? 0.0 : mean / sorted.size();
+
+    cout << left << setw(22) << result.name << right << fixed << setprecision(4)
+        << " n=" << setw(5) << sorted.size()
+        << " mean=" << setw(11) << mean
+        << " p50=" << setw(11) << percentile(sorted, 50)
+        << " p99=" << setw(11) << percentile(sorted, 99) << " ms";
+    if (result.opsPerSample > 1 && mean > 0.0) {
+        cout << "  " << setprecision(0) << result.opsPerSample / mean * 1000.0 << " ops/s";
+    }
+    for (const auto &[counter, value] : result.counters) {
+        cout << "  " << counter << "=" << setprecision(1) << value;
+    }
+    cout << defaultfloat << endl;
+}
+
+/// @brief write the configuration and every stage's statistics as JSON
+void writeJson(const string &fileName, const BenchConfig &config, const vector<StageResult> &results) {
+    ofstream out(fileName);
+    if (!out.is_open()) {
+        cout << "Unable to write " << fileName << endl;
+        return;
+    }
+
+    const UniverseSpec &spec = config.spec;
+    out << setprecision(9);
+    out << "{\n  \"config\": {\"systems\": " << spec.systems
+        << ", \"stars_per_system\": " << spec.starsPerSystem
+        << ", \"planets_per_system\": " << spec.planetsPerSystem
+        << ", \"satellites_per_planet\": " << spec.satellitesPerPlanet
+        << ", \"mean_degree\": " << spec.meanDegree
+        << ", \"degree_model\": \"" << spec.degreeModel << "\""
+        << ", \"seed\": " << spec.seed
+        << ", \"reps\": " << config.reps
+        << ", \"warmup\": " << config.warmup
+        << ", \"queries\": " << config.queries << "},\n  \"stages\": [";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const StageResult &result = results[i];
+        vector<double> sorted = result.samples;
+        sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double ms : sorted) {
+            total += ms;
+        }
+
+        out << (i > 0 ? "," : "") << "\n    {\"name\": \"" << result.name << "\""
+            << ", \"samples\": " << sorted.size()
+            << ", \"ops_per_sample\": " << result.opsPerSample
+            << ", \"mean_ms\": " << (sorted.empty() ? 0.0 : total / sorted.size())
+            << ", \"min_ms\": " << (sorted.empty() ? 0.0 : sorted.front())
+            << ", \"p50_ms\": " << percentile(sorted, 50)
+            << ", \"p90_ms\": " << percentile(sorted, 90)
+            << ", \"p99_ms\": " << percentile(sorted, 99)
+            << ", \"max_ms\": " << (sorted.empty() ? 0.0 : sorted.back());
+        for (const auto &[counter, value] : result.counters) {
+            out << ", \"" << counter << "\": " << value;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,606 @@
+/// @file catalog.cpp
+/// @brief Reading celestial and connection data from streams and printing
+///        the loaded catalog. Kept apart from the menu so the loaders and
+///        print paths can be driven by other tools such as the benchmarks.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <istream>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "celestial.h"
+#include "solarsystem.h"
+#include "fileexception.h"
+#include "systemindex.h"
+#include "catalog.h"
+#include "memoryreport.h"
+#include "lazycatalog.h"
+#include "profiler.h"
+
+using namespace std;
+
+/// @brief One celestial line once parsed, kept apart from applying it so
+///        a transactional load can check every line before changing anything
+struct CelestialLine
+{
+    enum Kind { System, Star, Planet, Satellite };
+    Kind kind = System;
+    string name;
+    string system;
+    string parent;       // star of a planet, planet of a satellite
+    string spectralType;
+    double values[3] = {0.0, 0.0, 0.0}; // x, y, z of a system, otherwise the
+                                        // body's numbers in file order
+    bool hasCoords = false;
+    bool isNatural = false;
+};
+
+// Local Helper Functions
+static string takeField(string &rest, const string &line);
+static double toNumber(const string &text, const string &line);
+static bool parseCelestialLine(const string &line, CelestialLine &record);
+static void applyCelestialLine(const CelestialLine &record, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+static bool parseConnectionLine(const string &line, SystemIndex &index, vector<pair<int, int>> &edges, string &unknown);
+
+/// @brief Load celestial object lines (System, Star, Planet, Satellite)
+///        from a stream into systems. Throws FileException on a bad line,
+///        the lines before it stay loaded.
+/// @param in the celestial data, structure as in 'data/alldata.csv'
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+void loadCelestialObjects(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    PROFILE_SCOPE("load.celestial");
+    // pick up any systems loaded since the index was last used
+    index.sync(systems);
+    index.markBodiesChanged();
+
+    // get data from the file
+    string line;
+    CelestialLine record;
+    while (getline(in, line)) {
+        if (parseCelestialLine(line, record)) {
+            applyCelestialLine(record, systems, index);
+        }
+    }
+}
+
+/// @brief Load celestial object lines, skipping bad lines into the report
+///        instead of stopping at the first. A transactional load holds
+///        every parsed line until the end and applies them only when none
+///        was bad, so a failed load leaves systems untouched; it needs
+///        memory for the parsed lines of the whole file meanwhile.
+/// @param in the celestial data, structure as in 'data/alldata.csv'
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param options how to treat bad lines
+/// @param report filled in with what was read, applied and skipped
+void loadCelestialObjects(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                          const LoadOptions &options, LoadReport &report) {
+    PROFILE_SCOPE("load.celestial");
+    auto started = chrono::steady_clock::now();
+    index.sync(systems);
+    if (!options.transactional) {
+        index.markBodiesChanged();
+    }
+
+    vector<CelestialLine> held; // transactional only
+    string line;
+    uint64_t offset = 0;
+    CelestialLine record;
+    try {
+        while (getline(in, line)) {
+            report.linesRead++;
+            uint64_t lineStart = offset;
+            offset += line.size() + 1;
+            try {
+                if (!parseCelestialLine(line, record)) {
+                    continue;
+                }
+            } catch (const exception &e) {
+                report.addError(report.linesRead, lineStart, e.what(), options.maxErrors);
+                continue;
+            }
+            if (options.transactional) {
+                held.push_back(move(record));
+            } else {
+                applyCelestialLine(record, systems, index);
+                report.linesApplied++;
+            }
+        }
+    } catch (const exception &e) {
+        // the stream itself broke off, e.g. corrupt compressed data
+        report.readFailed = true;
+        report.addError(report.linesRead + 1, offset, e.what(), options.maxErrors);
+    }
+
+    if (options.transactional && report.errorCount == 0) {
+        index.markBodiesChanged();
+        for (const CelestialLine &parsed : held) {
+            applyCelestialLine(parsed, systems, index);
+        }
+        report.linesApplied = held.size();
+    }
+    report.committed = !options.transactional || report.errorCount == 0;
+    report.elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+}
+
+/// @brief Load connection lines (source, target, target, ...) from a stream.
+///        Lines naming an unknown source and unknown targets are skipped.
+/// @param in the connection data, structure as in 'data/alldata_allconnections.csv'
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+void loadSolarSystemConnections(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    PROFILE_SCOPE("load.connections");
+    // pick up any systems loaded since the index was last used
+    index.sync(systems);
+
+    // get data from the file
+    string line, unknown;
+    vector<pair<int, int>> edges;
+    while (getline(in, line)) {
+        edges.clear();
+        parseConnectionLine(line, index, edges, unknown);
+        for (const auto &[source, target] : edges) {
+            index.connect(source, target);
+        }
+    }
+}
+
+/// @brief Load connection lines, reporting lines without a comma and
+///        names that are not loaded as errors. The known connections of a
+///        line with an unknown target are still added, unless the load is
+///        transactional, which adds nothing when any line was bad.
+/// @param in the connection data, structure as in 'data/alldata_allconnections.csv'
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param options how to treat bad lines
+/// @param report filled in with what was read, applied and skipped
+void loadSolarSystemConnections(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                                const LoadOptions &options, LoadReport &report) {
+    PROFILE_SCOPE("load.connections");
+    auto started = chrono::steady_clock::now();
+    index.sync(systems);
+
+    vector<pair<int, int>> edges; // every line's when transactional
+    string line, unknown;
+    uint64_t offset = 0;
+    try {
+        while (getline(in, line)) {
+            report.linesRead++;
+            uint64_t lineStart = offset;
+            offset += line.size() + 1;
+            if (!options.transactional) {
+                edges.clear();
+            }
+            size_t before = edges.size();
+            if (!parseConnectionLine(line, index, edges, unknown)) {
+                report.addError(report.linesRead, lineStart, "Bad Data Line - No Comma Found: " + line, options.maxErrors);
+                continue;
+            }
+            if (!unknown.empty()) {
+                report.addError(report.linesRead, lineStart, "Unknown Solar System: " + unknown, options.maxErrors);
+            }
+            if (!options.transactional) {
+                for (const auto &[source, target] : edges) {
+                    index.connect(source, target);
+                }
+            }
+            report.linesApplied += edges.size() > before;
+        }
+    } catch (const exception &e) {
+        report.readFailed = true;
+        report.addError(report.linesRead + 1, offset, e.what(), options.maxErrors);
+    }
+
+    if (options.transactional) {
+        if (report.errorCount == 0) {
+            for (const auto &[source, target] : edges) {
+                index.connect(source, target);
+            }
+        } else {
+            report.linesApplied = 0;
+        }
+    }
+    report.committed = !options.transactional || report.errorCount == 0;
+    report.elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+}
+
+/// @brief Remember a bad line, keeping the details of the first few
+/// @param lineNumber 1 based line of the data
+/// @param byteOffset where the line starts in the data, after decompression
+/// @param reason the parser's message
+/// @param maxErrors how many errors keep their details
+void LoadReport::addError(long lineNumber, uint64_t byteOffset, const string &reason, size_t maxErrors) {
+    this->errorCount++;
+    if (this->errors.size() >= maxErrors) {
+        return;
+    }
+    // the parser's messages repeat the whole line, which can be huge
+    const string prefix = "Exception Caught: ";
+    string shortReason = reason.compare(0, prefix.size(), prefix) == 0 ? reason.substr(prefix.size()) : reason;
+    if (shortReason.size() > 200) {
+        shortReason = shortReason.substr(0, 200) + "...";
+    }
+    this->errors.push_back({lineNumber, byteOffset, shortReason});
+}
+
+/// @brief multi-line summary followed by every kept error, not newline
+///        terminated
+string LoadReport::toString() const {
+    ostringstream out;
+    out << "Load Report" << endl;
+    out << "===========" << endl;
+    out << "Lines Read: " << this->linesRead << endl;
+    out << "Lines Applied: " << this->linesApplied << endl;
+    out << "Bad Lines: " << this->errorCount << endl;
+    if (this->readFailed) {
+        out << "Reading Stopped Early: Yes" << endl;
+    }
+    out << "Committed: " << (this->committed ? "Yes" : "No, nothing was changed") << endl;
+    out << "Time (ms): " << this->elapsedMs;
+    for (const LoadError &error : this->errors) {
+        out << endl << "Line " << error.lineNumber << " (byte " << error.byteOffset << "): " << error.reason;
+    }
+    if (this->errorCount > static_cast<long>(this->errors.size())) {
+        out << endl << "... and " << this->errorCount - this->errors.size() << " more";
+    }
+    return out.str();
+}
+
+/// @brief take the text before the next comma off the front of rest,
+///        throws FileException when there is no comma left
+static string takeField(string &rest, const string &line) {
+    size_t pos = rest.find(',');
+    if (pos == string::npos) {
+        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
+    }
+    string field = rest.substr(0, pos);
+    rest.erase(0, pos + 1);
+    return field;
+}
+
+/// @brief stod for data fields, an empty field is 0; throws FileException
+///        naming the line instead of stod's bare exceptions
+static double toNumber(const string &text, const string &line) {
+    if (text == "") {
+        return 0.0;
+    }
+    try {
+        return stod(text);
+    } catch (const logic_error &) {
+        throw FileException("Exception Caught: Bad Data Line - Bad Number: " + line);
+    }
+}
+
+/// @brief Parse one celestial line without touching the loaded data.
+///        Throws FileException on a bad line.
+/// @param line one line of the data file
+/// @param record filled in from the line
+/// @return false for blank and comment lines
+static bool parseCelestialLine(const string &line, CelestialLine &record) {
+    // skip blank lines
+    if (line.empty()) {
+        return false;
+    }
+
+    // skip lines starting with a #
+    if (line.at(0) == '#') {
+        return false;
+    }
+
+    // find the position of the comma delimiter
+    size_t commaPos = line.find(',');
+
+    // no comma
+    if (commaPos == string::npos) {
+        throw FileException("Exception Caught: Bad Data Line - No Comma Found: " + line);
+    }
+
+    // extract the keyword and keyword name from the line
+    string keyword = line.substr(0, commaPos);
+    string keywordName = line.substr(commaPos + 1);
+    record.hasCoords = false;
+    record.isNatural = false;
+
+    if (keyword == "System") {
+        // optional coordinates follow the name: System,name,x,y,z
+        record.kind = CelestialLine::System;
+        record.name = keywordName;
+        size_t pos = keywordName.find(',');
+        if (pos != string::npos) {
+            record.name = keywordName.substr(0, pos);
+            keywordName.erase(0, pos + 1);
+            for (int axis = 0; axis < 3; axis++) {
+                pos = keywordName.find(',');
+                if ((axis < 2) == (pos == string::npos)) {
+                    throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
+                }
+                string coordinate = keywordName.substr(0, pos);
+                if (coordinate == "") {
+                    throw FileException("Exception Caught: Bad Data Line - Bad Number: " + line);
+                }
+                record.values[axis] = toNumber(coordinate, line);
+                keywordName.erase(0, pos == string::npos ? pos : pos + 1);
+            }
+            record.hasCoords = true;
+        }
+    } else if (keyword == "Star") {
+        // name, solarSystem, spectralType, temperature, and solarMass
+        record.kind = CelestialLine::Star;
+        record.name = takeField(keywordName, line);
+        record.system = takeField(keywordName, line);
+        record.spectralType = takeField(keywordName, line);
+        record.values[0] = toNumber(takeField(keywordName, line), line);
+        record.values[1] = toNumber(keywordName, line);
+    } else if (keyword == "Planet") {
+        // name, starName, solarSystem, orbitalPeriod, and radius
+        record.kind = CelestialLine::Planet;
+        record.name = takeField(keywordName, line);
+        record.parent = takeField(keywordName, line);
+        record.system = takeField(keywordName, line);
+        record.values[0] = toNumber(takeField(keywordName, line), line);
+        record.values[1] = toNumber(keywordName, line);
+    } else if (keyword == "Satellite") {
+        // name, planetName, solarSystemName, radius, and isNatural
+        record.kind = CelestialLine::Satellite;
+        record.name = takeField(keywordName, line);
+        record.parent = takeField(keywordName, line);
+        record.system = takeField(keywordName, line);
+        record.values[0] = toNumber(takeField(keywordName, line), line);
+        record.isNatural = keywordName == "Yes";
+    } else {
+        // throw exception if the type of Celestial object is invalid
+        throw FileException("Exception Caught: Bad Data Line - Invalid Celestial Type: " + line);
+    }
+    return true;
+}
+
+/// @brief Add one parsed celestial line to the loaded systems, creating
+///        the systems, stars and planets it names that do not exist yet
+static void applyCelestialLine(const CelestialLine &record, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    bool created = false;
+    if (record.kind == CelestialLine::System) {
+        PROFILE_SCOPE("parse.system");
+        // if already exists dont create, but still take its coordinates
+        int id = index.findOrCreate(systems, record.name, created);
+        if (record.hasCoords) {
+            index.setPosition(id, record.values[0], record.values[1], record.values[2]);
+        }
+    } else if (record.kind == CelestialLine::Star) {
+        PROFILE_SCOPE("parse.star");
+        // if already exists dont create
+        shared_ptr<SolarSystem> existing = index.find(record.system);
+        if (existing != nullptr && existing->find<Star>(record.name) != nullptr) {
+            return;
+        }
+
+        // add star to its solar system if it exists, if not create the solar system and add it
+        shared_ptr<Star> star = make_shared<Star>(record.name, record.spectralType, record.values[0], record.values[1]);
+        int id = index.findOrCreate(systems, record.system, created);
+        index.at(id)->insertCelestial(star);
+    } else if (record.kind == CelestialLine::Planet) {
+        PROFILE_SCOPE("parse.planet");
+        shared_ptr<Planet> planet = make_shared<Planet>(record.name, record.values[0], record.values[1]);
+
+        // find the solar system, if it doesn't exist create it
+        shared_ptr<SolarSystem> solarSystem = index.at(index.findOrCreate(systems, record.system, created));
+
+        // find the star, if the star doesn't exist create it
+        if (solarSystem->find<Star>(record.parent) == nullptr) {
+            shared_ptr<Star> star = make_shared<Star>(record.parent, "unknown", 0.0, 0.0); // Spectral type, temperature, and solar mass are not specified in the data
+            solarSystem->insertCelestial(star);
+        }
+
+        // add planet to the solar system
+        solarSystem->insertCelestial(planet);
+    } else {
+        PROFILE_SCOPE("parse.satellite");
+        // find the solar system, if it doesn't exist create it
+        shared_ptr<SolarSystem> solarSystem = index.at(index.findOrCreate(systems, record.system, created));
+
+        // a satellite of a system the file never named is not natural
+        shared_ptr<Satellite> satellite = make_shared<Satellite>(record.name, record.values[0], record.isNatural && !created);
+
+        // find the planet, if the planet doesn't exist create it
+        shared_ptr<Planet> planet = solarSystem->find<Planet>(record.parent);
+        if (planet == nullptr) {
+            planet = make_shared<Planet>(record.parent, 0.0, 0.0); // Orbital period and radius are not specified in the data
+            solarSystem->insertCelestial(planet);
+        }
+
+        // add satellite to the planet unless it already orbits it
+        if (!planet->satExists(record.name)) {
+            solarSystem->insertSatellite(planet, satellite);
+        }
+    }
+}
+
+/// @brief Resolve one connection line into source and target ids
+/// @param line one line of the connection file
+/// @param index the index of the loaded systems
+/// @param edges the line's connections are appended
+/// @param unknown set to the first name that is not loaded, or cleared
+/// @return false for a line with no comma
+static bool parseConnectionLine(const string &line, SystemIndex &index, vector<pair<int, int>> &edges, string &unknown) {
+    unknown.clear();
+
+    // skip blank lines and lines starting with a #
+    if (line.empty() || line.at(0) == '#') {
+        return true;
+    }
+
+    PROFILE_SCOPE("connections.resolve");
+
+    // get the first word of the line (every character before the comma)
+    size_t pos = line.find(',');
+    if (pos == string::npos) {
+        return false;
+    }
+    string sourceSolarSystemName = line.substr(0, pos);
+
+    // check the source solar system exists, if search failed skip line
+    int source = index.idOf(sourceSolarSystemName);
+    if (source == -1) {
+        PROFILE_COUNT("connections.unresolved", 1);
+        unknown = sourceSolarSystemName;
+        return true;
+    }
+
+    // add every named connection that is in the systems vector
+    size_t start = pos + 1;
+    while (start <= line.size()) {
+        pos = line.find(',', start);
+        if (pos == string::npos) {
+            pos = line.size();
+        }
+        string connection = line.substr(start, pos - start);
+        start = pos + 1;
+
+        // no data there
+        if (connection == "") {
+            continue;
+        }
+
+        int target = index.idOf(connection);
+        if (target != -1) {
+            edges.push_back({source, target});
+        } else {
+            PROFILE_COUNT("connections.unresolved", 1);
+            if (unknown.empty()) {
+                unknown = connection;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief Output every system with its celestial bodies, one toString per system
+/// @param systems the vector of loaded Solar Systems
+/// @param out where to write, the console by default
+/// @param lazy when given, loads each system's bodies before it is printed
+void printSystemsCelestialDetails(vector<shared_ptr<SolarSystem>> &systems, ostream &out, LazyCatalog *lazy) {
+    PROFILE_SCOPE("print.celestial");
+    if (systems.empty()) {
+        out << "No data loaded." << endl;
+    }
+    // iterate through systems vector, positions are index ids
+    for (size_t i = 0; i < systems.size(); i++) {
+        if (lazy != nullptr) {
+            lazy->ensureLoaded(i);
+        }
+        out << systems[i]->toString() << endl;
+    }
+}
+
+/// @brief Output every system with its connections
+/// @param systems the vector of loaded Solar Systems
+/// @param out where to write, the console by default
+void printSystemsConnectionDetails(vector<shared_ptr<SolarSystem>> &systems, ostream &out) {
+    PROFILE_SCOPE("print.connections");
+    if (systems.empty()) {
+        out << "No connections loaded." << endl;
+    }
+    // iterate through systems vector
+    for (const auto& solarsystem : systems) {
+        out << solarsystem->getName() << " -> " << solarsystem->connectionsToString() << endl;
+    }
+}
+
+/// @brief Output counts of the loaded bodies and connection statistics
+/// @param systems the vector of loaded Solar Systems
+/// @param out where to write, the console by default
+/// @param lazy when given, loads each system's bodies before it is counted
+void printLoadedCelestialStats(const vector<shared_ptr<SolarSystem>> &systems, ostream &out, LazyCatalog *lazy) {
+    PROFILE_SCOPE("print.stats");
+    // Stats for Loaded Data
+    // =====================
+    // Number of Solar Systems: 3
+    // Number of Stars: 4
+    // Number of Planets: 4
+    // Number of Satellites: 1
+    // Minimum Number of Connections: 0
+    // Maximum Number of Connections: 0
+    // Average Number of Connections: 0
+    // Median Number of Connections: 0
+
+    int numSolarSystems = 0, totalNumStars = 0, totalNumPlanets = 0, totalNumSatellites = 0, minNumConnections = 0, maxNumConnections = 0; double avgNumConnections = 0.0, medNumConnections = 0.0;
+    vector<int> cons; int consSize = 0;
+    for (size_t i = 0; i < systems.size(); i++) {
+        if (lazy != nullptr) {
+            lazy->ensureLoaded(i);
+        }
+        const shared_ptr<SolarSystem> &system = systems[i];
+        numSolarSystems++;
+        totalNumStars += system->numStars();
+        totalNumPlanets += system->numPlanets();
+        totalNumSatellites += system->numSatellites();
+        avgNumConnections += system->numConnections();
+        cons.push_back(system->numConnections());
+        consSize++;
+    }
+
+    if (!cons.empty()) {
+        // calculate minimum and maximum number of connections
+        minNumConnections = *min_element(cons.begin(), cons.end());
+        maxNumConnections = *max_element(cons.begin(), cons.end());
+
+        // calculate average number of connections
+        avgNumConnections = avgNumConnections / consSize;
+
+        // calculate median number of connections
+        sort(cons.begin(), cons.end());
+        if (consSize % 2 == 0) {
+            // even number of elements
+            medNumConnections = cons[consSize / 2 - 1] + cons[consSize / 2] / 2.0;
+        } else {
+            // odd number of elements
+            medNumConnections = cons[consSize / 2.0];
+        }
+    } else {
+        // no connections found
+        minNumConnections = 0;
+        maxNumConnections = 0;
+        avgNumConnections = 0;
+        medNumConnections = 0;
+    }
+
+
+
+    out << "Stats for Loaded Data" << endl;
+    out << "=====================" << endl;
+    out << "Number of Solar Systems: " << numSolarSystems << endl;
+    out << "Number of Stars: " << totalNumStars << endl;
+    out << "Number of Planets: " << totalNumPlanets << endl;
+    out << "Number of Satellites: " << totalNumSatellites << endl;
+    out << "Minimum Number of Connections: " << minNumConnections << endl;
+    out << "Maximum Number of Connections: " << maxNumConnections << endl;
+    out << "Average Number of Connections: " << avgNumConnections << endl;
+    out << "Median Number of Connections: " << medNumConnections << endl;
+}
+
+/// @brief Output the heap bytes held by the loaded data, by category, next
+///        to what malloc reports for the whole process
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param out where to write, the console by default
+void printMemoryUsage(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, ostream &out) {
+    MemoryReport report = measureMemory(systems, index);
+
+    out << "Memory Use of Loaded Data" << endl;
+    out << "=========================" << endl;
+    out << report.toString() << endl;
+#ifdef __GLIBC__
+    // the whole process, stream buffers and derived indexes included
+    out << left << setw(20) << "Malloc in use" << right << setw(14) << mallinfo2().uordblks << " bytes" << endl;
+#endif
+}
@@ -0,0 +1,408 @@
+/// @file compressedinput.cpp
+/// @brief Implementations for reading plain, gzip and zstd data files with
+///        decompression running ahead of the parser on its own thread.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#ifdef INTERSTELLAR_ZSTD
+#include <zstd.h>
+#endif
+#include "fileexception.h"
+#include "profiler.h"
+#include "compressedinput.h"
+
+using namespace std;
+
+/// @brief Stream buffer handing out the file's bytes in blocks. Plain files
+///        are read on demand; compressed ones are inflated by a producer
+///        thread into a small queue of blocks, so reading the file,
+///        inflating and parsing overlap.
+class DecompressBuffer : public streambuf
+{
+    public:
+        static const size_t kBlockBytes = 1 << 20;   // inflated bytes per block
+        static const size_t kInputBytes = 256 << 10; // compressed bytes per read
+        static const size_t kQueueDepth = 4;         // blocks inflated ahead
+
+        /// @brief Open a file and start inflating it when compressed.
+        DecompressBuffer(const string &fileName);
+
+        /// @brief Stop the producer and close the file.
+        ~DecompressBuffer();
+
+        bool isOpen() const { return this->opened; }
+        Compression getCompression() const { return this->compression; }
+        uint64_t getFileBytesRead() const { return this->fileBytes.load(memory_order_relaxed); }
+        uint64_t getFileSize() const { return this->fileSize; }
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        size_t readFile(char *into, size_t length);
+        void produce();
+        void inflateGzip();
+        void inflateZstd();
+        vector<char> takeSpare();
+        bool push(vector<char> &block, size_t length);
+
+        string fileName;
+        ifstream file;
+        Compression compression = Compression::None;
+        bool opened = false;
+        uint64_t fileSize = 0;
+        atomic<uint64_t> fileBytes{0};
+        vector<char> current;
+
+        // shared between the producer and the reader
+        thread producer;
+        mutex lock;
+        condition_variable changed;
+        deque<vector<char>> ready;
+        vector<vector<char>> spare;
+        bool finished = false;
+        bool cancelled = false;
+        string error;
+};
+
+/// @brief Open a file and start inflating it when compressed.
+/// @param fileName the data file
+DecompressBuffer::DecompressBuffer(const string &fileName) : fileName(fileName) {
+    this->file.open(fileName, ios::binary);
+    if (!this->file.is_open()) {
+        return;
+    }
+    this->file.seekg(0, ios::end);
+    this->fileSize = static_cast<uint64_t>(max<streamoff>(0, this->file.tellg()));
+    this->file.seekg(0, ios::beg);
+
+    unsigned char magic[4] = {0, 0, 0, 0};
+    this->file.read(reinterpret_cast<char *>(magic), sizeof(magic));
+    this->compression = detectCompression(magic, this->file.gcount());
+    this->file.clear();
+    this->file.seekg(0, ios::beg);
+
+#ifndef INTERSTELLAR_ZSTD
+    if (this->compression == Compression::Zstd) {
+        this->file.close();
+        throw FileException("Exception Caught: zstd Not Supported - rebuild with make ZSTD=1 (needs libzstd) to read " + fileName);
+    }
+#endif
+
+    this->opened = true;
+    if (this->compression != Compression::None) {
+        this->producer = thread(&DecompressBuffer::produce, this);
+    }
+}
+
+/// @brief Stop the producer and close the file.
+DecompressBuffer::~DecompressBuffer() {
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->cancelled = true;
+    }
+    this->changed.notify_all();
+    if (this->producer.joinable()) {
+        this->producer.join();
+    }
+}
+
+/// @brief next block for the reader: straight from a plain file, or the
+///        next one the producer inflated
+DecompressBuffer::int_type DecompressBuffer::underflow() {
+    if (this->compression == Compression::None) {
+        this->current.resize(kBlockBytes);
+        size_t got = this->readFile(this->current.data(), kBlockBytes);
+        if (got == 0) {
+            return traits_type::eof();
+        }
+        this->setg(this->current.data(), this->current.data(), this->current.data() + got);
+        return traits_type::to_int_type(this->current[0]);
+    }
+
+    unique_lock<mutex> guard(this->lock);
+    if (!this->current.empty()) {
+        this->spare.push_back(move(this->current));
+        this->current.clear();
+        this->changed.notify_all();
+    }
+    this->changed.wait(guard, [this]() { return !this->ready.empty() || this->finished; });
+    if (this->ready.empty()) {
+        this->setg(nullptr, nullptr, nullptr);
+        if (!this->error.empty()) {
+            // istream rethrows this since DataFileStream sets badbit exceptions
+            throw FileException(this->error);
+        }
+        return traits_type::eof();
+    }
+    this->current = move(this->ready.front());
+    this->ready.pop_front();
+    this->setg(this->current.data(), this->current.data(), this->current.data() + this->current.size());
+    return traits_type::to_int_type(this->current[0]);
+}
+
+/// @brief read up to length bytes of the file itself
+/// @return bytes read, 0 at the end
+size_t DecompressBuffer::readFile(char *into, size_t length) {
+    this->file.read(into, length);
+    size_t got = this->file.gcount();
+    this->fileBytes.fetch_add(got, memory_order_relaxed);
+    return got;
+}
+
+/// @brief producer thread: inflate the whole file, then mark it finished
+void DecompressBuffer::produce() {
+    try {
+        if (this->compression == Compression::Gzip) {
+            this->inflateGzip();
+        } else {
+            this->inflateZstd();
+        }
+    } catch (const exception &e) {
+        lock_guard<mutex> guard(this->lock);
+        this->error = e.what();
+    }
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->finished = true;
+    }
+    this->changed.notify_all();
+}
+
+/// @brief Inflate gzip members one after another until the file ends, as
+///        gzip itself does for concatenated files.
+void DecompressBuffer::inflateGzip() {
+    z_stream stream{};
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        throw FileException("Exception Caught: Unable To Start gzip - " + this->fileName);
+    }
+    vector<char> input(kInputBytes);
+    vector<char> block = this->takeSpare();
+    size_t used = 0;
+    bool inMember = false;
+    bool pending = false; // the last call filled the block, more may be waiting
+
+    try {
+        while (true) {
+            if (stream.avail_in == 0 && !pending) {
+                size_t got = this->readFile(input.data(), input.size());
+                if (got == 0) {
+                    break;
+                }
+                stream.next_in = reinterpret_cast<Bytef *>(input.data());
+                stream.avail_in = got;
+            }
+
+            PROFILE_SCOPE("load.inflate");
+            stream.next_out = reinterpret_cast<Bytef *>(block.data() + used);
+            stream.avail_out = block.size() - used;
+            unsigned before = stream.avail_in;
+            int status = inflate(&stream, Z_NO_FLUSH);
+            used = block.size() - stream.avail_out;
+            pending = stream.avail_out == 0;
+            if (stream.avail_in != before) {
+                inMember = true;
+            }
+            if (status == Z_STREAM_END) {
+                inMember = false;
+                inflateReset(&stream);
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                throw FileException("Exception Caught: Corrupt gzip Data - " + this->fileName +
+                                    (stream.msg != nullptr ? string(": ") + stream.msg : string()));
+            }
+
+            if (used == block.size()) {
+                if (!this->push(block, used)) {
+                    inflateEnd(&stream);
+                    return;
+                }
+                block = this->takeSpare();
+                used = 0;
+            }
+        }
+    } catch (...) {
+        inflateEnd(&stream);
+        throw;
+    }
+    inflateEnd(&stream);
+
+    if (inMember) {
+        throw FileException("Exception Caught: Truncated gzip Data - " + this->fileName);
+    }
+    if (used > 0) {
+        this->push(block, used);
+    }
+}
+
+/// @brief Inflate zstd frames one after another until the file ends.
+void DecompressBuffer::inflateZstd() {
+#ifdef INTERSTELLAR_ZSTD
+    ZSTD_DStream *stream = ZSTD_createDStream();
+    ZSTD_initDStream(stream);
+    vector<char> input(kInputBytes);
+    vector<char> block = this->takeSpare();
+    ZSTD_inBuffer in{input.data(), 0, 0};
+    size_t used = 0;
+    size_t hint = 0;      // non zero while a frame is incomplete
+    bool pending = false; // the last call filled the block, more may be waiting
+
+    while (true) {
+        if (in.pos == in.size && !pending) {
+            size_t got = this->readFile(input.data(), input.size());
+            if (got == 0) {
+                break;
+            }
+            in = {input.data(), got, 0};
+        }
+
+        PROFILE_SCOPE("load.inflate");
+        ZSTD_outBuffer out{block.data(), block.size(), used};
+        hint = ZSTD_decompressStream(stream, &out, &in);
+        used = out.pos;
+        pending = out.pos == out.size;
+        if (ZSTD_isError(hint)) {
+            string reason = ZSTD_getErrorName(hint);
+            ZSTD_freeDStream(stream);
+            throw FileException("Exception Caught: Corrupt zstd Data - " + this->fileName + ": " + reason);
+        }
+
+        if (used == block.size()) {
+            if (!this->push(block, used)) {
+                ZSTD_freeDStream(stream);
+                return;
+            }
+            block = this->takeSpare();
+            used = 0;
+        }
+    }
+    ZSTD_freeDStream(stream);
+
+    if (hint != 0) {
+        throw FileException("Exception Caught: Truncated zstd Data - " + this->fileName);
+    }
+    if (used > 0) {
+        this->push(block, used);
+    }
+#endif
+}
+
+/// @return an empty block of kBlockBytes, reusing one the reader is done with
+vector<char> DecompressBuffer::takeSpare() {
+    lock_guard<mutex> guard(this->lock);
+    vector<char> block;
+    if (!this->spare.empty()) {
+        block = move(this->spare.back());
+        this->spare.pop_back();
+    }
+    block.resize(kBlockBytes);
+    return block;
+}
+
+/// @brief queue an inflated block for the reader, waiting while the
+///        queue is full
+/// @return false when the reader went away
+bool DecompressBuffer::push(vector<char> &block, size_t length) {
+    block.resize(length);
+    unique_lock<mutex> guard(this->lock);
+    this->changed.wait(guard, [this]() { return this->ready.size() < kQueueDepth || this->cancelled; });
+    if (this->cancelled) {
+        return false;
+    }
+    this->ready.push_back(move(block));
+    this->changed.notify_all();
+    return true;
+}
+
+
+/// @return the compression a file starting with these bytes uses
+Compression detectCompression(const unsigned char *bytes, size_t length) {
+    if (length >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+        return Compression::Gzip;
+    }
+    if (length >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+/// @return "plain", "gzip" or "zstd"
+string compressionName(Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            return "gzip";
+        case Compression::Zstd:
+            return "zstd";
+        default:
+            return "plain";
+    }
+}
+
+/// @brief A stream with no file open yet
+DataFileStream::DataFileStream() : istream(nullptr) {}
+
+/// @brief Open a file straight away, see open
+DataFileStream::DataFileStream(const string &fileName) : DataFileStream() {
+    this->open(fileName);
+}
+
+/// @brief Stops any decompression still running
+DataFileStream::~DataFileStream() {
+    this->close();
+}
+
+/// @brief Open a file, detecting its compression.
+/// @param fileName the data file
+void DataFileStream::open(const string &fileName) {
+    this->close();
+    this->buffer = make_unique<DecompressBuffer>(fileName);
+    if (!this->buffer->isOpen()) {
+        this->buffer.reset();
+        this->setstate(ios::failbit);
+        return;
+    }
+    this->rdbuf(this->buffer.get());
+    this->clear();
+
+    // errors found while inflating leave the read that met them as themselves
+    this->exceptions(ios::badbit);
+}
+
+/// @return true after a successful open until close
+bool DataFileStream::is_open() const {
+    return this->buffer != nullptr;
+}
+
+/// @brief Stop any decompression and close the file.
+void DataFileStream::close() {
+    if (this->buffer == nullptr) {
+        return;
+    }
+    this->exceptions(ios::goodbit);
+    this->rdbuf(nullptr);
+    this->buffer.reset();
+}
+
+/// @return the compression detected by open
+Compression DataFileStream::getCompression() const {
+    return this->buffer == nullptr ? Compression::None : this->buffer->getCompression();
+}
+
+/// @return bytes of the file itself read so far
+uint64_t DataFileStream::getFileBytesRead() const {
+    return this->buffer == nullptr ? 0 : this->buffer->getFileBytesRead();
+}
+
+/// @return size of the file itself in bytes
+uint64_t DataFileStream::getFileSize() const {
+    return this->buffer == nullptr ? 0 : this->buffer->getFileSize();
+}
@@ -0,0 +1,470 @@
+/// @file contractionhierarchy.cpp
+/// @brief Implementations for the ContractionHierarchy preprocessing and
+///        its bidirectional upward query.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <iomanip>
+#include <queue>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "systemindex.h"
+#include "routeplanner.h"
+#include "contractionhierarchy.h"
+#include "profiler.h"
+
+using namespace std;
+
+/// @brief A connection of the graph being contracted, seen from one end
+struct Arc
+{
+    int other;
+    int weight;  // hops
+    int middle;  // system a shortcut bypasses, -1 for a real connection
+};
+
+/// @brief Shortcut found while contracting a system
+struct Shortcut
+{
+    int from;
+    int to;
+    int weight;
+    int middle;
+};
+
+/// @brief Bounded Dijkstra over the systems not yet contracted, looking
+///        for a path that makes a shortcut unnecessary
+class WitnessSearch
+{
+    public:
+        explicit WitnessSearch(int n) : distance(n, INT_MAX), stamp(n, 0) {}
+
+        /// @brief search out from source without passing skip, giving up
+        ///        past limit hops or maxSettled systems
+        void run(const vector<vector<Arc>> &out, int source, int skip, int limit, int maxSettled) {
+            if (++this->currentStamp == 0) {
+                fill(this->stamp.begin(), this->stamp.end(), 0);
+                this->currentStamp = 1;
+            }
+            priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> open;
+            this->reach(source, 0);
+            open.emplace(0, source);
+            int settled = 0;
+            while (!open.empty() && settled < maxSettled) {
+                auto [d, v] = open.top();
+                open.pop();
+                if (d != this->distanceTo(v)) {
+                    continue;
+                }
+                if (d >= limit) {
+                    break;
+                }
+                settled++;
+                for (const Arc &arc : out[v]) {
+                    int to = arc.other;
+                    if (to != skip && d + arc.weight < this->distanceTo(to)) {
+                        this->reach(to, d + arc.weight);
+                        open.emplace(d + arc.weight, to);
+                    }
+                }
+            }
+        }
+
+        /// @return hops found to v by the last run, INT_MAX when none
+        int distanceTo(int v) const {
+            return this->stamp[v] == this->currentStamp ? this->distance[v] : INT_MAX;
+        }
+
+    private:
+        void reach(int v, int d) {
+            this->stamp[v] = this->currentStamp;
+            this->distance[v] = d;
+        }
+
+        vector<int> distance;
+        vector<unsigned> stamp;
+        unsigned currentStamp = 0;
+};
+
+// Local Helper Functions
+static const int kMaxWitnessSettled = 200;  // contracting
+static const int kMaxEstimateSettled = 40;  // estimating priorities
+static int findShortcuts(int v, const vector<vector<Arc>> &out, const vector<vector<Arc>> &in,
+                         WitnessSearch &witness, int maxSettled, vector<Shortcut> *shortcuts);
+static void addArc(vector<vector<Arc>> &out, vector<vector<Arc>> &in, const Shortcut &shortcut, long &arcs);
+static void removeArcsTo(vector<Arc> &arcs, int v);
+static void flatten(const vector<vector<Arc>> &arcs, vector<int> &offsets, vector<int> &ends,
+                    vector<int> &weights, vector<int> &middles);
+
+/// @brief Contract the connections of the index. Systems go in order of
+///        edge difference (shortcuts added less connections removed) plus
+///        the number of neighbours already contracted, which spreads
+///        contraction evenly; priorities are refreshed when a system comes
+///        up and when a neighbour is contracted.
+/// @param index the system index to contract
+/// @param maxCoreDegree contraction stops once the systems left average
+///        more connections than this
+void ContractionHierarchy::build(const SystemIndex &index, int maxCoreDegree) {
+    PROFILE_SCOPE("hierarchy.build");
+    auto started = chrono::steady_clock::now();
+    int n = index.size();
+    this->stats = HierarchyStats();
+    this->stats.systems = n;
+
+    // the graph still to contract, duplicate and self connections dropped
+    vector<vector<Arc>> out(n), in(n);
+    long arcs = 0;
+    for (int id = 0; id < n; id++) {
+        for (int to : index.neighbors(id)) {
+            if (to != id) {
+                addArc(out, in, {id, to, 1, -1}, arcs);
+            }
+        }
+    }
+    this->stats.connections = arcs;
+
+    // search graph arcs of each system, frozen as it is contracted
+    vector<vector<Arc>> up(n), down(n);
+    WitnessSearch witness(n);
+    vector<int> contractedNeighbours(n, 0);
+    vector<int> priority(n);
+    vector<bool> contracted(n, false);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> order;
+    auto prioritize = [&](int v) {
+        int added = findShortcuts(v, out, in, witness, kMaxEstimateSettled, nullptr);
+        priority[v] = added - static_cast<int>(out[v].size() + in[v].size()) + contractedNeighbours[v];
+        order.emplace(priority[v], v);
+    };
+    for (int v = 0; v < n; v++) {
+        prioritize(v);
+    }
+
+    int remaining = n;
+    vector<Shortcut> shortcuts;
+    while (!order.empty() && static_cast<double>(arcs) <= static_cast<double>(maxCoreDegree) * remaining) {
+        auto [p, v] = order.top();
+        order.pop();
+        if (contracted[v] || p != priority[v]) {
+            continue; // stale entry
+        }
+        // lazy update: contract only when still the least important
+        prioritize(v);
+        if (priority[v] > order.top().first) {
+            continue;
+        }
+
+        shortcuts.clear();
+        findShortcuts(v, out, in, witness, kMaxWitnessSettled, &shortcuts);
+        for (const Shortcut &shortcut : shortcuts) {
+            long had = arcs;
+            addArc(out, in, shortcut, arcs);
+            this->stats.shortcuts += arcs > had;
+        }
+
+        // every arc left at v leads to a system contracted later
+        up[v] = out[v];
+        down[v] = in[v];
+        contracted[v] = true;
+        remaining--;
+        arcs -= out[v].size() + in[v].size();
+        vector<int> neighbours;
+        for (const Arc &arc : out[v]) {
+            removeArcsTo(in[arc.other], v);
+            neighbours.push_back(arc.other);
+        }
+        for (const Arc &arc : in[v]) {
+            removeArcsTo(out[arc.other], v);
+            neighbours.push_back(arc.other);
+        }
+        vector<Arc>().swap(out[v]);
+        vector<Arc>().swap(in[v]);
+        sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (int neighbour : neighbours) {
+            contractedNeighbours[neighbour]++;
+            prioritize(neighbour);
+        }
+    }
+
+    // the core keeps all of its arcs in both directions
+    for (int v = 0; v < n; v++) {
+        if (!contracted[v]) {
+            up[v] = out[v];
+            down[v] = in[v];
+            this->stats.coreSystems++;
+        }
+    }
+
+    flatten(up, this->upOffsets, this->upEnds, this->upWeights, this->upMiddles);
+    flatten(down, this->downOffsets, this->downEnds, this->downWeights, this->downMiddles);
+    this->stats.upArcs = this->upEnds.size();
+    this->stats.downArcs = this->downEnds.size();
+    this->stats.bytes = (this->upOffsets.size() + this->downOffsets.size() +
+                         3 * (this->upEnds.size() + this->downEnds.size())) * sizeof(int);
+    this->stats.buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+
+    this->scratch = HierarchyScratch();
+    this->builtVersion = index.getVersion();
+    this->built = true;
+}
+
+/// @return true when the index changed since the last build
+bool ContractionHierarchy::isStale(const SystemIndex &index) const {
+    return !this->built || this->builtVersion != index.getVersion();
+}
+
+/// @brief Find a route with the fewest hops in the hierarchy's own scratch
+bool ContractionHierarchy::findRoute(int start, int end, vector<int> &route, RouteStats *stats) const {
+    return this->findRoute(start, end, route, this->scratch, stats);
+}
+
+/// @brief Bidirectional search: forward along up arcs from start, backward
+///        along down arcs from end, always extending the side with the
+///        nearer frontier. Each side stops once its frontier is no nearer
+///        than the best meeting found, since it only climbs and cannot
+///        count on the other side to come down to it.
+bool ContractionHierarchy::findRoute(int start, int end, vector<int> &route, HierarchyScratch &scratch,
+                                     RouteStats *stats) const {
+    PROFILE_SCOPE("route.hierarchy");
+    auto started = chrono::steady_clock::now();
+    route.clear();
+    int n = this->size();
+    if (start < 0 || end < 0 || start >= n || end >= n) {
+        return false;
+    }
+
+    // scratch sized for another hierarchy starts over
+    if (scratch.stamp[0].size() != static_cast<size_t>(n)) {
+        for (int side = 0; side < 2; side++) {
+            scratch.distance[side].assign(n, 0);
+            scratch.parent[side].assign(n, -1);
+            scratch.arc[side].assign(n, -1);
+            scratch.stamp[side].assign(n, 0);
+        }
+        scratch.currentStamp = 0;
+    }
+    if (++scratch.currentStamp == 0) {
+        fill(scratch.stamp[0].begin(), scratch.stamp[0].end(), 0);
+        fill(scratch.stamp[1].begin(), scratch.stamp[1].end(), 0);
+        scratch.currentStamp = 1;
+    }
+    const unsigned seen = scratch.currentStamp;
+    auto distanceTo = [&](int side, int v) {
+        return scratch.stamp[side][v] == seen ? scratch.distance[side][v] : INT_MAX;
+    };
+
+    using Entry = pair<int, int>;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> open[2];
+    int ends[2] = {start, end};
+    for (int side = 0; side < 2; side++) {
+        scratch.stamp[side][ends[side]] = seen;
+        scratch.distance[side][ends[side]] = 0;
+        scratch.parent[side][ends[side]] = -1;
+        open[side].emplace(0, ends[side]);
+    }
+
+    int best = INT_MAX, meeting = -1, settled = 0;
+    while (true) {
+        bool active[2];
+        for (int side = 0; side < 2; side++) {
+            active[side] = !open[side].empty() && open[side].top().first < best;
+        }
+        if (!active[0] && !active[1]) {
+            break;
+        }
+        int side = !active[0] || (active[1] && open[1].top().first < open[0].top().first) ? 1 : 0;
+        auto [d, v] = open[side].top();
+        open[side].pop();
+        if (d != distanceTo(side, v)) {
+            continue; // stale queue entry
+        }
+        settled++;
+        int across = distanceTo(1 - side, v);
+        if (across != INT_MAX && d + across < best) {
+            best = d + across;
+            meeting = v;
+        }
+
+        const vector<int> &offsets = side == 0 ? this->upOffsets : this->downOffsets;
+        const vector<int> &arcEnds = side == 0 ? this->upEnds : this->downEnds;
+        const vector<int> &weights = side == 0 ? this->upWeights : this->downWeights;
+        for (int i = offsets[v]; i < offsets[v + 1]; i++) {
+            int to = arcEnds[i];
+            int g = d + weights[i];
+            if (g < distanceTo(side, to)) {
+                scratch.stamp[side][to] = seen;
+                scratch.distance[side][to] = g;
+                scratch.parent[side][to] = v;
+                scratch.arc[side][to] = i;
+                open[side].emplace(g, to);
+            }
+        }
+    }
+
+    if (meeting != -1) {
+        // climb back from the meeting to the start, then unpack every arc
+        // on the way down to the end
+        vector<int> climb;
+        for (int v = meeting; v != start; v = scratch.parent[0][v]) {
+            climb.push_back(v);
+        }
+        route.push_back(start);
+        for (auto it = climb.rbegin(); it != climb.rend(); ++it) {
+            int v = *it;
+            this->unpack(scratch.parent[0][v], v, this->upMiddles[scratch.arc[0][v]], route);
+        }
+        for (int v = meeting; v != end; v = scratch.parent[1][v]) {
+            int next = scratch.parent[1][v];
+            this->unpack(v, next, this->downMiddles[scratch.arc[1][v]], route);
+        }
+    }
+
+    PROFILE_COUNT("route.settled", settled);
+    if (stats != nullptr) {
+        stats->settled = settled;
+        stats->elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+    return meeting != -1;
+}
+
+/// @return number of systems in the hierarchy
+int ContractionHierarchy::size() const {
+    return this->upOffsets.empty() ? 0 : this->upOffsets.size() - 1;
+}
+
+/// @return size of the hierarchy and its build time
+HierarchyStats ContractionHierarchy::getStats() const {
+    return this->stats;
+}
+
+/// @return e.g. "Hierarchy of 1000 systems: 120 in the core, 800 shortcuts
+///         over 4000 connections, 9000 search arcs in 0.1 MB, built in 42.0 ms"
+string HierarchyStats::toString() const {
+    ostringstream out;
+    out << "Hierarchy of " << this->systems << " systems: " << this->coreSystems << " in the core, "
+        << this->shortcuts << " shortcuts over " << this->connections << " connections, "
+        << this->upArcs + this->downArcs << " search arcs in " << fixed << setprecision(1)
+        << this->bytes / (1024.0 * 1024.0) << " MB, built in " << this->buildMs << " ms";
+    return out.str();
+}
+
+/// @return the middle of the arc between node and other in one search
+///         graph, -1 for a real connection
+int ContractionHierarchy::middleOf(bool up, int node, int other) const {
+    const vector<int> &offsets = up ? this->upOffsets : this->downOffsets;
+    const vector<int> &ends = up ? this->upEnds : this->downEnds;
+    const vector<int> &middles = up ? this->upMiddles : this->downMiddles;
+    for (int i = offsets[node]; i < offsets[node + 1]; i++) {
+        if (ends[i] == other) {
+            return middles[i];
+        }
+    }
+    return -1;
+}
+
+/// @brief Append the systems after from along the arc from -> to,
+///        replacing each shortcut by the two arcs it stands for. Both
+///        halves were arcs of the bypassed system when it was contracted:
+///        from -> middle is a down arc of middle, middle -> to an up arc.
+void ContractionHierarchy::unpack(int from, int to, int middle, vector<int> &route) const {
+    vector<Shortcut> pending = {{from, to, 0, middle}};
+    while (!pending.empty()) {
+        Shortcut arc = pending.back();
+        pending.pop_back();
+        if (arc.middle == -1) {
+            route.push_back(arc.to);
+            continue;
+        }
+        int m = arc.middle;
+        // second half first, so the first half comes off the stack first
+        pending.push_back({m, arc.to, 0, this->middleOf(true, m, arc.to)});
+        pending.push_back({arc.from, m, 0, this->middleOf(false, m, arc.from)});
+    }
+}
+
+/// @brief Work out the shortcuts contracting v needs: for each arc u -> v
+///        and v -> x, a shortcut u -> x unless a witness search finds an
+///        equally short way around v.
+/// @param maxSettled how far each witness search may look; a search cut
+///        short only costs a shortcut that was not needed
+/// @param shortcuts when given, filled with the shortcuts
+/// @return number of shortcuts needed
+static int findShortcuts(int v, const vector<vector<Arc>> &out, const vector<vector<Arc>> &in,
+                         WitnessSearch &witness, int maxSettled, vector<Shortcut> *shortcuts) {
+    int needed = 0;
+    for (const Arc &incoming : in[v]) {
+        int u = incoming.other;
+        int limit = 0;
+        for (const Arc &outgoing : out[v]) {
+            if (outgoing.other != u) {
+                limit = max(limit, incoming.weight + outgoing.weight);
+            }
+        }
+        if (limit == 0) {
+            continue;
+        }
+        witness.run(out, u, v, limit, maxSettled);
+        for (const Arc &outgoing : out[v]) {
+            int x = outgoing.other;
+            int via = incoming.weight + outgoing.weight;
+            if (x == u || witness.distanceTo(x) <= via) {
+                continue;
+            }
+            needed++;
+            if (shortcuts != nullptr) {
+                shortcuts->push_back({u, x, via, v});
+            }
+        }
+    }
+    return needed;
+}
+
+/// @brief Add an arc to both ends' lists, or shorten the arc already there
+/// @param arcs counts arcs in the graph, bumped for a new one
+static void addArc(vector<vector<Arc>> &out, vector<vector<Arc>> &in, const Shortcut &shortcut, long &arcs) {
+    for (Arc &arc : out[shortcut.from]) {
+        if (arc.other != shortcut.to) {
+            continue;
+        }
+        if (shortcut.weight < arc.weight) {
+            arc.weight = shortcut.weight;
+            arc.middle = shortcut.middle;
+            for (Arc &back : in[shortcut.to]) {
+                if (back.other == shortcut.from) {
+                    back.weight = shortcut.weight;
+                    back.middle = shortcut.middle;
+                }
+            }
+        }
+        return;
+    }
+    out[shortcut.from].push_back({shortcut.to, shortcut.weight, shortcut.middle});
+    in[shortcut.to].push_back({shortcut.from, shortcut.weight, shortcut.middle});
+    arcs++;
+}
+
+/// @brief drop the arcs leading to v
+static void removeArcsTo(vector<Arc> &arcs, int v) {
+    arcs.erase(remove_if(arcs.begin(), arcs.end(), [v](const Arc &arc) { return arc.other == v; }), arcs.end());
+}
+
+/// @brief lay per system arc lists out as compressed rows
+static void flatten(const vector<vector<Arc>> &arcs, vector<int> &offsets, vector<int> &ends,
+                    vector<int> &weights, vector<int> &middles) {
+    offsets.assign(1, 0);
+    ends.clear();
+    weights.clear();
+    middles.clear();
+    for (const vector<Arc> &list : arcs) {
+        for (const Arc &arc : list) {
+            ends.push_back(arc.other);
+            weights.push_back(arc.weight);
+            middles.push_back(arc.middle);
+        }
+        offsets.push_back(ends.size());
+    }
+}
@@ -0,0 +1,219 @@
+/// @file deltaloader.cpp
+/// @brief Applies delta files of celestial and connection changes to the
+///        loaded Solar Systems without reloading everything.
+///        Utilized by the Interstellar Travel App.
+
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "fileexception.h"
+#include "systemindex.h"
+#include "deltaloader.h"
+#include "profiler.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief split a line into its comma separated fields
+static void splitFields(const string &line, vector<string> &fields) {
+    fields.clear();
+    size_t start = 0;
+    while (true) {
+        size_t pos = line.find(',', start);
+        if (pos == string::npos) {
+            fields.push_back(line.substr(start));
+            return;
+        }
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+}
+
+/// @brief Convert a field to a double, empty fields are 0.0 like the
+///        loader. Throws FileException naming the line when the field is
+///        not a number.
+static double toDouble(const string &field, const string &line, int lineNumber) {
+    if (field == "") {
+        return 0.0;
+    }
+    try {
+        return stod(field);
+    } catch (const logic_error &) {
+        throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - Bad Number: " + line);
+    }
+}
+
+
+/// @brief summary of the delta as a multi-line string, not newline terminated
+string DeltaReport::toString() const {
+    ostringstream out;
+    out << "Delta Applied" << endl;
+    out << "=============" << endl;
+    out << "Lines Applied: " << linesApplied << endl;
+    out << "Solar Systems Added: " << systemsAdded << endl;
+    out << "Solar Systems Touched: " << systemsTouched << endl;
+    out << "Bodies Added: " << bodiesAdded << endl;
+    out << "Bodies Updated: " << bodiesUpdated << endl;
+    out << "Connections Added: " << connectionsAdded << endl;
+    out << "Connections Removed: " << connectionsRemoved << endl;
+    out << "Time (ms): " << elapsedMs;
+    return out.str();
+}
+
+/// @brief Apply every change in a delta stream to the loaded systems.
+///        Throws FileException on a bad line.
+/// @param in the delta file contents
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param report filled in with the changes applied
+void applyDelta(istream &in, vector<shared_ptr<SolarSystem>> &systems,
+                SystemIndex &index, DeltaReport &report) {
+    PROFILE_SCOPE("load.delta");
+    auto started = chrono::steady_clock::now();
+    index.sync(systems);
+    index.markBodiesChanged();
+
+    unordered_set<int> touched;
+    vector<string> fields;
+    string line; int lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+
+        // skip blank lines and comments
+        if (line.empty() || line.at(0) == '#') {
+            continue;
+        }
+
+        splitFields(line, fields);
+        const string &keyword = fields.at(0);
+        if (fields.size() < 2) {
+            throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - No Comma Found: " + line);
+        }
+
+        bool created = false;
+        if (keyword == "System") {
+            if (fields.size() != 2 && fields.size() != 5) {
+                throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - Mismatched Data Amount: " + line);
+            }
+            // numbers are checked before anything changes
+            double coordinates[3] = {0.0, 0.0, 0.0};
+            for (size_t axis = 0; axis + 2 < fields.size(); axis++) {
+                coordinates[axis] = toDouble(fields.at(axis + 2), line, lineNumber);
+            }
+            int id = index.findOrCreate(systems, fields.at(1), created);
+            if (created) {
+                report.systemsAdded++;
+                touched.insert(id);
+            }
+            if (fields.size() == 5) {
+                index.setPosition(id, coordinates[0], coordinates[1], coordinates[2]);
+                touched.insert(id);
+            }
+        } else if (keyword == "Star") {
+            if (fields.size() != 6) {
+                throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - Mismatched Data Amount: " + line);
+            }
+            double temperature = toDouble(fields.at(4), line, lineNumber);
+            double mass = toDouble(fields.at(5), line, lineNumber);
+            int id = index.findOrCreate(systems, fields.at(2), created);
+            report.systemsAdded += created;
+            touched.insert(id);
+
+            shared_ptr<SolarSystem> system = index.at(id);
+            shared_ptr<Star> star = system->find<Star>(fields.at(1));
+            if (star != nullptr) {
+                star->setSpectralType(fields.at(3));
+                star->setTemperature(temperature);
+                star->setMass(mass);
+                report.bodiesUpdated++;
+            } else {
+                system->insertCelestial(make_shared<Star>(fields.at(1), fields.at(3), temperature, mass));
+                report.bodiesAdded++;
+            }
+        } else if (keyword == "Planet") {
+            if (fields.size() != 6) {
+                throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - Mismatched Data Amount: " + line);
+            }
+            double orbitalPeriod = toDouble(fields.at(4), line, lineNumber);
+            double radius = toDouble(fields.at(5), line, lineNumber);
+            int id = index.findOrCreate(systems, fields.at(3), created);
+            report.systemsAdded += created;
+            touched.insert(id);
+
+            shared_ptr<SolarSystem> system = index.at(id);
+            shared_ptr<Planet> planet = system->find<Planet>(fields.at(1));
+            if (planet != nullptr) {
+                planet->setOrbitalPeriod(orbitalPeriod);
+                planet->setRadius(radius);
+                report.bodiesUpdated++;
+            } else {
+                // the planet's star is created when missing, same as the loader
+                if (system->find<Star>(fields.at(2)) == nullptr) {
+                    system->insertCelestial(make_shared<Star>(fields.at(2), "unknown", 0.0, 0.0));
+                    report.bodiesAdded++;
+                }
+                system->insertCelestial(make_shared<Planet>(fields.at(1), orbitalPeriod, radius));
+                report.bodiesAdded++;
+            }
+        } else if (keyword == "Satellite") {
+            if (fields.size() != 6) {
+                throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - Mismatched Data Amount: " + line);
+            }
+            double radius = toDouble(fields.at(4), line, lineNumber);
+            int id = index.findOrCreate(systems, fields.at(3), created);
+            report.systemsAdded += created;
+            touched.insert(id);
+
+            shared_ptr<SolarSystem> system = index.at(id);
+            shared_ptr<Planet> planet = system->find<Planet>(fields.at(2));
+            if (planet == nullptr) {
+                planet = make_shared<Planet>(fields.at(2), 0.0, 0.0);
+                system->insertCelestial(planet);
+                report.bodiesAdded++;
+            }
+
+            bool natural = fields.at(5) == "Yes";
+            shared_ptr<Satellite> satellite = dynamic_pointer_cast<Satellite>(planet->getSat(fields.at(1)));
+            if (satellite != nullptr) {
+                satellite->setRadius(radius);
+                satellite->setNatural(natural);
+                report.bodiesUpdated++;
+            } else if (!planet->satExists(fields.at(1))) {
+                system->insertSatellite(planet, make_shared<Satellite>(fields.at(1), radius, natural));
+                report.bodiesAdded++;
+            }
+        } else if (keyword == "Connect" || keyword == "Disconnect") {
+            // unknown systems are skipped, same as the connection loader
+            int source = index.idOf(fields.at(1));
+            for (size_t i = 2; source != -1 && i < fields.size(); i++) {
+                int target = index.idOf(fields.at(i));
+                if (target == -1) {
+                    continue;
+                }
+                if (keyword == "Connect" && index.connect(source, target)) {
+                    report.connectionsAdded++;
+                    touched.insert(source);
+                } else if (keyword == "Disconnect" && index.disconnect(source, target)) {
+                    report.connectionsRemoved++;
+                    touched.insert(source);
+                }
+            }
+        } else {
+            throw FileException("Exception Caught: Bad Delta Line " + to_string(lineNumber) + " - Invalid Delta Type: " + line);
+        }
+
+        report.linesApplied++;
+        report.systemsTouched = touched.size();
+    }
+
+    report.systemsTouched = touched.size();
+    report.elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+}
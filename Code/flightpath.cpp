@@ -21,6 +21,7 @@
 #include <vector>
 #include "solarsystem.h"
 #include "flightpath.h"
+#include "nameindex.h"
 
 using namespace std;
 
@@ -78,6 +79,45 @@ void FlightPath::createPath(const vector<shared_ptr<SolarSystem>> &systems) {
     }
 }
 
+/// @brief Create a path through user input like createPath, but look
+/// names up in the name index instead of scanning the systems vector.
+/// When a name is not found the closest system names are suggested.
+/// @param systems is the vector with the valid systems in it
+/// @param names is the name index built over the same systems
+void FlightPath::createPath(const vector<shared_ptr<SolarSystem>> &systems, const NameIndex &names) {
+    this->clear();
+    cout << "Name of a Solar System to add to plan: ";
+    string userInput; int i = 0;
+    while (getline(cin, userInput)) {
+        if (i != 0) {
+            cout << "Name of a Solar System to add to plan: ";
+        }
+        cout << endl;
+        // whitespace only means break the loop and end the function
+        if (userInput == "" || userInput == "DONE") {
+            break;
+        }
+
+        // system ids are positions in the systems vector
+        int id = names.findSystem(userInput);
+        if (id != -1) {
+            this->path.push_back(systems.at(id));
+            cout << userInput << " added to path." << endl;
+        } else {
+            cout << "Invalid system: Nothing added to path." << endl;
+            vector<NameMatch> suggestions = names.similar(userInput, 2, 5, true);
+            if (!suggestions.empty()) {
+                cout << "Did you mean: ";
+                for (size_t s = 0; s < suggestions.size(); s++) {
+                    cout << (s > 0 ? ", " : "") << suggestions.at(s).name;
+                }
+                cout << "?" << endl;
+            }
+        }
+        i++;
+    }
+}
+
 /// @brief Utilizes the Solar System connections to determine whether
 /// we can successfully navigate along the stored path from the
 /// first system to the last system to determine whether our
@@ -209,6 +249,12 @@ void FlightPath::printConnections() const {
     }
 }
 
+/// @brief replace the path with systems found by a route planner
+/// @param steps the systems in order from start to end
+void FlightPath::setPath(const vector<shared_ptr<SolarSystem>> &steps) {
+    this->path = steps;
+}
+
 /// @brief clear the path and reset to empty
 void FlightPath::clear() {
     this->path.clear();
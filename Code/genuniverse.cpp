@@ -0,0 +1,126 @@
+/// @file genuniverse.cpp
+/// @brief Standalone tool writing synthetic celestial and connection files
+///        in the formats of 'data/alldata.csv' and
+///        'data/alldata_allconnections.csv'. The same options and seed
+///        always write the same files.
+///
+/// Usage: genuniverse.out [-systems N] [-stars N] [-planets N]
+///                        [-satellites N] [-degree D]
+///                        [-model uniform|powerlaw|smallworld] [-rewire P]
+///                        [-seed S] [-comments N] [-nocoords]
+///                        [-celestial file] [-connections file]
+///
+/// The MB/s reported per file runs from the first byte to close(), so it
+/// depends on the sink: /dev/null times the generator alone, and a file
+/// times it plus the copy into the page cache, not the flush to disk.
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "universegen.h"
+
+using namespace std;
+
+// Local Function Prototypes
+bool writeFile(const string &fileName, const UniverseSpec &spec,
+               unsigned long long (*write)(ostream &, const UniverseSpec &));
+
+int main(int argc, char* argv[])
+{
+    UniverseSpec spec;
+    string celestialFile = "generated_celestial.csv";
+    string connectionFile = "generated_connections.csv";
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-nocoords") {
+            spec.coordinates = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << arg << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        try {
+            if (arg == "-systems") {
+                spec.systems = stol(value);
+            } else if (arg == "-stars") {
+                spec.starsPerSystem = stoi(value);
+            } else if (arg == "-planets") {
+                spec.planetsPerSystem = stoi(value);
+            } else if (arg == "-satellites") {
+                spec.satellitesPerPlanet = stoi(value);
+            } else if (arg == "-degree") {
+                spec.meanDegree = stod(value);
+            } else if (arg == "-model") {
+                spec.degreeModel = value;
+            } else if (arg == "-rewire") {
+                spec.rewire = stod(value);
+            } else if (arg == "-seed") {
+                spec.seed = stoul(value);
+            } else if (arg == "-comments") {
+                spec.commentEvery = stol(value);
+            } else if (arg == "-celestial") {
+                celestialFile = value;
+            } else if (arg == "-connections") {
+                connectionFile = value;
+            } else {
+                cout << "Unknown option " << arg << endl;
+                return 1;
+            }
+        } catch (const exception &) {
+            cout << "Invalid value for " << arg << ": " << value << endl;
+            return 1;
+        }
+    }
+
+    if (spec.systems < 1 || spec.starsPerSystem < 0 || spec.planetsPerSystem < 0 ||
+        spec.satellitesPerPlanet < 0 || spec.meanDegree < 0) {
+        cout << "Counts must not be negative and there must be at least one system." << endl;
+        return 1;
+    }
+    if (spec.planetsPerSystem > 0 && spec.starsPerSystem == 0) {
+        cout << "Planets need at least one star per system." << endl;
+        return 1;
+    }
+    if (spec.degreeModel != "uniform" && spec.degreeModel != "powerlaw" && spec.degreeModel != "smallworld") {
+        cout << "Unknown model " << spec.degreeModel << ", expected uniform, powerlaw or smallworld." << endl;
+        return 1;
+    }
+
+    if (!writeFile(celestialFile, spec, writeCelestialData) ||
+        !writeFile(connectionFile, spec, writeConnectionData)) {
+        return 1;
+    }
+    return 0;
+}
+
+/// @brief Write one generated file and report its size and write rate,
+///        timed up to close() without waiting for the disk.
+/// @return false when the file could not be written
+bool writeFile(const string &fileName, const UniverseSpec &spec,
+               unsigned long long (*write)(ostream &, const UniverseSpec &)) {
+    ofstream out(fileName, ios::binary);
+    if (!out.is_open()) {
+        cout << "Unable to open " << fileName << endl;
+        return false;
+    }
+
+    auto started = chrono::steady_clock::now();
+    unsigned long long bytes = write(out, spec);
+    out.close();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    if (out.fail()) {
+        cout << "Error writing " << fileName << endl;
+        return false;
+    }
+
+    double megabytes = bytes / (1024.0 * 1024.0);
+    cout << fixed << setprecision(1) << fileName << ": " << megabytes << " MB in "
+        << setprecision(2) << seconds << " s (" << setprecision(0)
+        << (seconds > 0 ? megabytes / seconds : 0.0) << " MB/s)" << defaultfloat << endl;
+    return true;
+}
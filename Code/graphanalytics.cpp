@@ -0,0 +1,261 @@
+/// @file graphanalytics.cpp
+/// @brief Implementations for centrality and components of the
+///        connection graph.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include "routeplanner.h"
+#include "profiler.h"
+#include "workerpool.h"
+#include "graphanalytics.h"
+
+using namespace std;
+
+// Local Helper Functions
+static const int kBlocks = 64; // pieces each PageRank iteration is split into
+
+/// @return the root of a union find tree, halving paths on the way
+static int rootOf(vector<int> &parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+
+/// @param graph a built planner whose connections are analysed
+GraphAnalytics::GraphAnalytics(const RoutePlanner &graph) : graph(graph) {}
+
+/// @brief Use this many threads, 0 for one per hardware thread.
+void GraphAnalytics::setWorkers(int workers) {
+    this->workers = max(0, workers);
+}
+
+/// @brief Brandes: a breadth first search from each source counts the
+///        fewest hop routes to every system, then systems are taken back
+///        in reverse order adding up each one's dependency on the systems
+///        one hop further. Walking forward connections from the nearer
+///        end means no predecessor lists are kept. Each worker sums into
+///        its own totals, added together at the end. Searches run on the
+///        planner's vertices and scores are given back by system id.
+/// @param samples sources to search, 0 or at least the number of systems
+///        for exact
+/// @param seed picks the sampled sources
+vector<double> GraphAnalytics::betweenness(int samples, unsigned long seed) const {
+    PROFILE_SCOPE("analytics.betweenness");
+    int n = this->graph.size();
+    vector<int> sources(n);
+    iota(sources.begin(), sources.end(), 0);
+    if (samples > 0 && samples < n) {
+        mt19937_64 rng(seed);
+        shuffle(sources.begin(), sources.end(), rng);
+        sources.resize(samples);
+    }
+    // sampled by system id, so a seed picks the same systems whatever the
+    // planner's numbering
+    for (int &source : sources) {
+        source = this->graph.vertexOf(source);
+    }
+    int jobs = sources.size();
+
+    int count = workerCount(this->workers, jobs);
+    vector<vector<double>> totals(count, vector<double>(n, 0.0));
+    vector<vector<int>> hops(count, vector<int>(n, -1));
+    vector<vector<double>> routes(count, vector<double>(n, 0.0));
+    vector<vector<double>> dependency(count, vector<double>(n, 0.0));
+    vector<vector<int>> order(count);
+    runJobs(jobs, count, [&](int worker, int job) {
+        vector<int> &hopsTo = hops[worker];
+        vector<double> &sigma = routes[worker];
+        vector<double> &delta = dependency[worker];
+        vector<int> &seen = order[worker];
+        int source = sources[job];
+
+        seen.clear();
+        seen.push_back(source);
+        hopsTo[source] = 0;
+        sigma[source] = 1.0;
+        for (size_t head = 0; head < seen.size(); head++) {
+            int v = seen[head];
+            auto next = this->graph.neighbors(v);
+            for (const int *w = next.first; w != next.second; w++) {
+                if (hopsTo[*w] == -1) {
+                    hopsTo[*w] = hopsTo[v] + 1;
+                    seen.push_back(*w);
+                }
+                if (hopsTo[*w] == hopsTo[v] + 1) {
+                    sigma[*w] += sigma[v];
+                }
+            }
+        }
+
+        vector<double> &total = totals[worker];
+        for (size_t i = seen.size(); i-- > 0; ) {
+            int v = seen[i];
+            auto next = this->graph.neighbors(v);
+            for (const int *w = next.first; w != next.second; w++) {
+                if (hopsTo[*w] == hopsTo[v] + 1) {
+                    delta[v] += sigma[v] / sigma[*w] * (1.0 + delta[*w]);
+                }
+            }
+            if (v != source) {
+                total[v] += delta[v];
+            }
+        }
+
+        // put back only what this search touched
+        for (int v : seen) {
+            hopsTo[v] = -1;
+            sigma[v] = 0.0;
+            delta[v] = 0.0;
+        }
+    });
+
+    vector<double> scores(n, 0.0);
+    double scale = jobs > 0 ? static_cast<double>(n) / jobs : 0.0;
+    for (const vector<double> &total : totals) {
+        for (int v = 0; v < n; v++) {
+            scores[this->graph.systemOf(v)] += total[v] * scale;
+        }
+    }
+    return scores;
+}
+
+/// @brief Power iteration pulling rank along reversed connections, each
+///        iteration split into blocks of systems for the workers. Rank
+///        left on systems without connections is spread evenly.
+/// @param iterations optional count of iterations run
+/// @return ranks summing to 1
+vector<double> GraphAnalytics::pageRank(double damping, double tolerance, int maxIterations, int *iterations) const {
+    PROFILE_SCOPE("analytics.pagerank");
+    int n = this->graph.size();
+    if (iterations != nullptr) {
+        *iterations = 0;
+    }
+    if (n == 0) {
+        return {};
+    }
+
+    // connections reversed, as compressed rows
+    vector<int> inOffsets(n + 1, 0), inSources, outDegree(n, 0);
+    for (int v = 0; v < n; v++) {
+        auto next = this->graph.neighbors(v);
+        outDegree[v] = next.second - next.first;
+        for (const int *w = next.first; w != next.second; w++) {
+            inOffsets[*w + 1]++;
+        }
+    }
+    partial_sum(inOffsets.begin(), inOffsets.end(), inOffsets.begin());
+    inSources.resize(inOffsets[n]);
+    vector<int> slot(inOffsets.begin(), inOffsets.end() - 1);
+    for (int v = 0; v < n; v++) {
+        auto next = this->graph.neighbors(v);
+        for (const int *w = next.first; w != next.second; w++) {
+            inSources[slot[*w]++] = v;
+        }
+    }
+
+    vector<double> rank(n, 1.0 / n), nextRank(n), share(n);
+    int blocks = min(n, kBlocks);
+    int count = workerCount(this->workers, blocks);
+    vector<double> change(blocks);
+    for (int iteration = 1; iteration <= maxIterations; iteration++) {
+        double dangling = 0.0;
+        for (int v = 0; v < n; v++) {
+            share[v] = outDegree[v] > 0 ? rank[v] / outDegree[v] : 0.0;
+            dangling += outDegree[v] > 0 ? 0.0 : rank[v];
+        }
+        double base = (1.0 - damping) / n + damping * dangling / n;
+        runJobs(blocks, count, [&](int, int block) {
+            int first = static_cast<long>(n) * block / blocks;
+            int last = static_cast<long>(n) * (block + 1) / blocks;
+            double moved = 0.0;
+            for (int v = first; v < last; v++) {
+                double pulled = 0.0;
+                for (int i = inOffsets[v]; i < inOffsets[v + 1]; i++) {
+                    pulled += share[inSources[i]];
+                }
+                nextRank[v] = base + damping * pulled;
+                moved += fabs(nextRank[v] - rank[v]);
+            }
+            change[block] = moved;
+        });
+        rank.swap(nextRank);
+        if (iterations != nullptr) {
+            *iterations = iteration;
+        }
+        if (accumulate(change.begin(), change.end(), 0.0) < tolerance) {
+            break;
+        }
+    }
+    for (int v = 0; v < n; v++) {
+        nextRank[this->graph.systemOf(v)] = rank[v];
+    }
+    return nextRank;
+}
+
+/// @brief Union find over every connection, then components numbered by
+///        size, largest first.
+/// @param sizes filled with the size of each component, largest first
+/// @return component number of each system
+vector<int> GraphAnalytics::components(vector<int> &sizes) const {
+    PROFILE_SCOPE("analytics.components");
+    int n = this->graph.size();
+    vector<int> parent(n);
+    iota(parent.begin(), parent.end(), 0);
+    for (int v = 0; v < n; v++) {
+        auto next = this->graph.neighbors(v);
+        for (const int *w = next.first; w != next.second; w++) {
+            int a = rootOf(parent, v), b = rootOf(parent, *w);
+            if (a != b) {
+                parent[max(a, b)] = min(a, b);
+            }
+        }
+    }
+
+    vector<int> rootSize(n, 0);
+    for (int v = 0; v < n; v++) {
+        rootSize[rootOf(parent, v)]++;
+    }
+    vector<int> roots;
+    for (int v = 0; v < n; v++) {
+        if (rootSize[v] > 0) {
+            roots.push_back(v);
+        }
+    }
+    stable_sort(roots.begin(), roots.end(), [&](int a, int b) { return rootSize[a] > rootSize[b]; });
+
+    vector<int> number(n, -1);
+    sizes.clear();
+    for (int root : roots) {
+        number[root] = sizes.size();
+        sizes.push_back(rootSize[root]);
+    }
+    vector<int> component(n);
+    for (int v = 0; v < n; v++) {
+        component[this->graph.systemOf(v)] = number[rootOf(parent, v)];
+    }
+    return component;
+}
+
+/// @return the n highest scoring (system id, score), highest first; ties
+///         go to the lower id
+vector<pair<int, double>> GraphAnalytics::topN(const vector<double> &scores, int n) {
+    vector<int> ids(scores.size());
+    iota(ids.begin(), ids.end(), 0);
+    int keep = max(0, min(n, static_cast<int>(ids.size())));
+    auto higher = [&](int a, int b) { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); };
+    partial_sort(ids.begin(), ids.begin() + keep, ids.end(), higher);
+
+    vector<pair<int, double>> top;
+    for (int i = 0; i < keep; i++) {
+        top.push_back({ids[i], scores[ids[i]]});
+    }
+    return top;
+}
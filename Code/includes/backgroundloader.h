@@ -0,0 +1,107 @@
+/// @file backgroundloader.h
+/// @brief Loading celestial and connection files on a background thread.
+///        The worker parses into its own staging systems and never touches
+///        the loaded ones; the menu thread commits the staged data in one
+///        step once parsing ends, so nothing half built is ever visible.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef BACKGROUNDLOADER_H
+#define BACKGROUNDLOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "compressedinput.h"
+
+using namespace std;
+
+enum class LoadKind { Celestial, Connections };
+
+enum class LoadState { Idle, Running, Finished, Cancelled };
+
+/// @brief Snapshot of a background load
+struct LoadProgress
+{
+    LoadKind kind = LoadKind::Celestial;
+    LoadState state = LoadState::Idle;
+    string fileName;
+    uint64_t bytes = 0;      // of the file as stored, compressed or not
+    uint64_t totalBytes = 0;
+    uint64_t lines = 0;
+    double elapsedSeconds = 0.0;
+    double etaSeconds = 0.0; // negative until there is enough to estimate
+
+    /// @return e.g. "Loading data/alldata.csv: 120000 lines, 4.1 of 9.8 MB
+    ///         (42%), 1.2 s elapsed, about 1.7 s left"
+    string toString() const;
+};
+
+class BackgroundLoader
+{
+    public:
+        BackgroundLoader() = default;
+        BackgroundLoader(const BackgroundLoader &) = delete;
+        BackgroundLoader &operator=(const BackgroundLoader &) = delete;
+
+        /// @brief Cancels and waits for a running load.
+        ~BackgroundLoader();
+
+        /// @brief Start loading a file on the worker thread. Connection
+        ///        files are resolved against the systems loaded now.
+        ///        Throws FileException when the file cannot be opened and
+        ///        logic_error while another load is uncommitted.
+        void start(LoadKind kind, const string &fileName,
+                   const vector<shared_ptr<SolarSystem>> &systems);
+
+        /// @return true from start until the load is committed or cancelled
+        bool isBusy() const;
+
+        /// @return progress of the current or last load
+        LoadProgress progress() const;
+
+        /// @brief Ask the worker to stop; its staged data is thrown away.
+        void cancel();
+
+        /// @brief When the worker has finished, merge its staged data into
+        ///        the loaded systems in one step.
+        /// @param message set to a summary, with the error of a bad line
+        ///        when parsing stopped early
+        /// @return true when something was committed
+        bool commit(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, string &message);
+
+    private:
+        void run();
+        void join();
+        void mergeCelestial(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+        void mergeConnections(SystemIndex &index);
+
+        thread worker;
+        DataFileStream file;
+        LoadKind kind = LoadKind::Celestial;
+        LoadState ended = LoadState::Idle; // how the last load ended
+        string fileName;
+        chrono::steady_clock::time_point started;
+        uint64_t totalBytes = 0;
+        uint64_t endBytes = 0; // file bytes read by the last load once closed
+        bool busy = false;
+
+        // written by the worker, read by the menu thread; bytes read of
+        // the file itself come from the file
+        atomic<uint64_t> lines{0};
+        atomic<bool> cancelled{false};
+        atomic<bool> done{false};
+        atomic<double> finishedSeconds{0.0};
+
+        // owned by the worker until done is set
+        vector<shared_ptr<SolarSystem>> stagedSystems;
+        SystemIndex stagedIndex;
+        string error;
+};
+
+#endif
@@ -0,0 +1,87 @@
+/// @file catalog.h
+/// @brief Reading celestial and connection data from streams and printing
+///        the loaded catalog.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <cstdint>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+
+using namespace std;
+
+class LazyCatalog;
+
+/// @brief One line a tolerant load could not use
+struct LoadError
+{
+    long lineNumber = 0;
+    uint64_t byteOffset = 0; // where the line starts, after decompression
+    string reason;
+};
+
+/// @brief How a tolerant load treats bad lines
+struct LoadOptions
+{
+    bool transactional = false; // change nothing unless every line is good
+    size_t maxErrors = 100;     // errors kept in detail, the rest are counted
+};
+
+/// @brief What a tolerant load read, applied and skipped
+struct LoadReport
+{
+    long linesRead = 0;
+    long linesApplied = 0;
+    long errorCount = 0;      // every bad line, kept in errors or not
+    bool readFailed = false;  // the stream broke off, later lines are unread
+    bool committed = false;   // false when a transactional load changed nothing
+    double elapsedMs = 0.0;
+    vector<LoadError> errors; // the first maxErrors bad lines
+
+    /// @brief count a bad line, keeping its details while there is room
+    void addError(long lineNumber, uint64_t byteOffset, const string &reason, size_t maxErrors);
+
+    /// @brief multi-line summary and the kept errors, not newline terminated
+    string toString() const;
+};
+
+/// @brief Load celestial object lines from a stream, throws FileException
+///        on a bad line
+void loadCelestialObjects(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+
+/// @brief Load celestial object lines from a stream, carrying on past bad
+///        lines and reporting them instead of throwing
+void loadCelestialObjects(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                          const LoadOptions &options, LoadReport &report);
+
+/// @brief Load connection lines from a stream
+void loadSolarSystemConnections(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+
+/// @brief Load connection lines from a stream, reporting bad lines and
+///        unknown names instead of skipping them quietly
+void loadSolarSystemConnections(istream &in, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                                const LoadOptions &options, LoadReport &report);
+
+/// @brief Output every system with its celestial bodies, loading them
+///        first when lazy is given
+void printSystemsCelestialDetails(vector<shared_ptr<SolarSystem>> &systems, ostream &out = cout, LazyCatalog *lazy = nullptr);
+
+/// @brief Output every system with its connections
+void printSystemsConnectionDetails(vector<shared_ptr<SolarSystem>> &systems, ostream &out = cout);
+
+/// @brief Output counts of the loaded bodies and connection statistics,
+///        loading the bodies first when lazy is given
+void printLoadedCelestialStats(const vector<shared_ptr<SolarSystem>> &systems, ostream &out = cout, LazyCatalog *lazy = nullptr);
+
+/// @brief Output the heap bytes held by the loaded data, by category
+void printMemoryUsage(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, ostream &out = cout);
+
+#endif
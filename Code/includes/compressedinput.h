@@ -0,0 +1,68 @@
+/// @file compressedinput.h
+/// @brief Reading data files that may be gzip or zstd compressed. The
+///        format is detected from the file's first bytes; compressed files
+///        are inflated on a separate thread in large blocks while the
+///        loader parses the blocks already done, so the uncompressed file
+///        is never written out or held whole in memory.
+///        zstd needs a build with -DINTERSTELLAR_ZSTD and -lzstd, which
+///        the makefile adds when libzstd is installed or with make ZSTD=1;
+///        gzip uses zlib (-lz).
+///        Utilized by the Interstellar Travel App.
+
+#ifndef COMPRESSEDINPUT_H
+#define COMPRESSEDINPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+enum class Compression { None, Gzip, Zstd };
+
+/// @return the compression a file starting with these bytes uses
+Compression detectCompression(const unsigned char *bytes, size_t length);
+
+/// @return "plain", "gzip" or "zstd"
+string compressionName(Compression compression);
+
+class DecompressBuffer;
+
+/// @brief An input stream over a data file of any supported compression,
+///        opened like an ifstream. Corrupt or truncated compressed data
+///        throws FileException out of the read that reaches it.
+class DataFileStream : public istream
+{
+    public:
+        DataFileStream();
+        explicit DataFileStream(const string &fileName);
+        ~DataFileStream();
+
+        /// @brief Open a file, detecting its compression. is_open stays
+        ///        false when the file cannot be read; throws FileException
+        ///        for zstd files in a build without zstd support.
+        void open(const string &fileName);
+
+        /// @return true after a successful open until close
+        bool is_open() const;
+
+        /// @brief Stop any decompression and close the file.
+        void close();
+
+        /// @return the compression detected by open
+        Compression getCompression() const;
+
+        /// @return bytes of the file itself read so far; safe to call from
+        ///         another thread while this one reads
+        uint64_t getFileBytesRead() const;
+
+        /// @return size of the file itself in bytes
+        uint64_t getFileSize() const;
+
+    private:
+        unique_ptr<DecompressBuffer> buffer;
+};
+
+#endif
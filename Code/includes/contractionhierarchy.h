@@ -0,0 +1,98 @@
+/// @file contractionhierarchy.h
+/// @brief Contraction hierarchy over the connection graph for fast fewest
+///        hop routes. Preprocessing contracts systems one at a time in
+///        order of importance, adding shortcut connections that keep hop
+///        counts between the systems left; a query is then a pair of small
+///        searches, forward from the start and backward from the end, that
+///        only climb towards more important systems. Contraction stops
+///        once the systems left are densely connected (random graphs have
+///        no hierarchy to exploit), and that core is searched in full.
+///        Shortcuts remember the system they bypass so routes unpack back
+///        to every system along the way.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "systemindex.h"
+#include "routeplanner.h"
+
+using namespace std;
+
+/// @brief Size of a built hierarchy and what building it took
+struct HierarchyStats
+{
+    int systems = 0;
+    int coreSystems = 0;   // left uncontracted
+    long connections = 0;
+    long shortcuts = 0;
+    long upArcs = 0;       // forward search graph
+    long downArcs = 0;     // backward search graph
+    size_t bytes = 0;      // of the search graphs
+    double buildMs = 0.0;
+
+    /// @return one line summary
+    string toString() const;
+};
+
+/// @brief Per query work arrays, like RouteScratch. A hierarchy keeps one
+///        for its own calls; threads sharing one bring their own.
+struct HierarchyScratch
+{
+    vector<int> distance[2];  // forward, backward
+    vector<int> parent[2];    // previous system towards start or end
+    vector<int> arc[2];       // search graph arc that reached the system
+    vector<unsigned> stamp[2];
+    unsigned currentStamp = 0;
+};
+
+class ContractionHierarchy
+{
+    public:
+        /// @brief Contract the connections of the index.
+        /// @param maxCoreDegree contraction stops once the systems left
+        ///        average more connections each than this
+        void build(const SystemIndex &index, int maxCoreDegree = 12);
+
+        /// @return true when the index changed since the last build
+        bool isStale(const SystemIndex &index) const;
+
+        /// @brief Find a route with the fewest hops along connections.
+        /// @param route filled with every system id from start to end
+        /// @param stats optional work counters for the query
+        /// @return true when end can be reached from start
+        bool findRoute(int start, int end, vector<int> &route, RouteStats *stats = nullptr) const;
+
+        /// @brief findRoute using the caller's scratch, so any number of
+        ///        threads may search one built hierarchy at the same time.
+        bool findRoute(int start, int end, vector<int> &route, HierarchyScratch &scratch,
+                       RouteStats *stats = nullptr) const;
+
+        /// @return number of systems in the hierarchy
+        int size() const;
+
+        /// @return size of the hierarchy and its build time
+        HierarchyStats getStats() const;
+
+    private:
+        int middleOf(bool up, int node, int other) const;
+        void unpack(int from, int to, int middle, vector<int> &route) const;
+
+        // search graphs as compressed rows. up: arcs from a system to more
+        // important ones; down: arcs into a system from more important
+        // ones, stored at the less important end. Core systems keep every
+        // arc among the core in both.
+        vector<int> upOffsets, upEnds, upWeights, upMiddles;
+        vector<int> downOffsets, downEnds, downWeights, downMiddles;
+        HierarchyStats stats;
+        unsigned long builtVersion = 0;
+        bool built = false;
+
+        // per query scratch, reused through stamps instead of cleared
+        mutable HierarchyScratch scratch;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/// @file deltaloader.h
+/// @brief Incremental (delta) loading of celestial and connection changes
+///        on top of an already loaded set of Solar Systems.
+///        Utilized by the Interstellar Travel App.
+///
+/// A delta file mixes celestial and connection lines, one change per line:
+///   System,<name>[,<x>,<y>,<z>]
+///   Star,<name>,<system>,<spectralType>,<temperature>,<mass>
+///   Planet,<name>,<star>,<system>,<orbitalPeriod>,<radius>
+///   Satellite,<name>,<planet>,<system>,<radius>,<Yes|No>
+///   Connect,<source>,<target>[,<target>...]
+///   Disconnect,<source>,<target>[,<target>...]
+/// Blank lines and lines starting with # are skipped. Bodies that already
+/// exist in their system are updated in place instead of duplicated.
+
+#ifndef DELTALOADER_H
+#define DELTALOADER_H
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+
+using namespace std;
+
+/// @brief Summary of what a delta file changed
+struct DeltaReport
+{
+    int linesApplied = 0;
+    int systemsAdded = 0;
+    int systemsTouched = 0;
+    int bodiesAdded = 0;
+    int bodiesUpdated = 0;
+    int connectionsAdded = 0;
+    int connectionsRemoved = 0;
+    double elapsedMs = 0.0;
+
+    /// @brief multi-line human readable summary, not newline terminated
+    string toString() const;
+};
+
+/// @brief Apply every change in a delta stream. Only the Solar Systems named
+///        in the delta are looked at. Throws FileException on a bad line;
+///        the report then holds the changes applied before that line.
+/// @param in the delta file contents
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param report filled in with the changes applied
+void applyDelta(istream &in, vector<shared_ptr<SolarSystem>> &systems,
+                SystemIndex &index, DeltaReport &report);
+
+#endif
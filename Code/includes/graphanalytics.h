@@ -0,0 +1,56 @@
+/// @file graphanalytics.h
+/// @brief Centrality and structure of the connection graph, computed over
+///        a RoutePlanner's flat snapshot by worker threads: Brandes
+///        betweenness, exact or estimated from sampled sources, PageRank,
+///        and weakly connected component sizes.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef GRAPHANALYTICS_H
+#define GRAPHANALYTICS_H
+
+#include <utility>
+#include <vector>
+#include "routeplanner.h"
+
+using namespace std;
+
+class GraphAnalytics
+{
+    public:
+        /// @param graph a built planner whose connections are analysed
+        explicit GraphAnalytics(const RoutePlanner &graph);
+
+        /// @brief Use this many threads, 0 for one per hardware thread.
+        void setWorkers(int workers);
+
+        /// @brief Betweenness of every system: over ordered pairs of other
+        ///        systems, the share of fewest hop routes passing through
+        ///        it. One breadth first search per source, split across
+        ///        the workers.
+        /// @param samples sources to search, scaled up to estimate the
+        ///        whole; 0 or at least the number of systems for exact
+        /// @param seed picks the sampled sources
+        vector<double> betweenness(int samples = 0, unsigned long seed = 1) const;
+
+        /// @brief PageRank over the connections, a system without any
+        ///        sharing its rank with every system.
+        /// @param iterations optional count of iterations run
+        /// @return ranks summing to 1
+        vector<double> pageRank(double damping = 0.85, double tolerance = 1e-9, int maxIterations = 100,
+                                int *iterations = nullptr) const;
+
+        /// @brief Weakly connected components, following connections
+        ///        either way.
+        /// @param sizes filled with the size of each component, largest first
+        /// @return component number of each system, 0 the largest
+        vector<int> components(vector<int> &sizes) const;
+
+        /// @return the n highest scoring (system id, score), highest first
+        static vector<pair<int, double>> topN(const vector<double> &scores, int n);
+
+    private:
+        const RoutePlanner &graph;
+        int workers = 0;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/// @file itineraryplanner.h
+/// @brief Round trips that visit a set of Solar Systems in any order.
+///        Hop counts between every pair of stops come from one breadth
+///        first search per stop, split across worker threads. The visiting
+///        order is then solved exactly by dynamic programming over subsets
+///        for a few stops, or by nearest neighbour improved with 2-opt and
+///        Or-opt moves for many. Connections are one way, so every move is
+///        costed in the direction the trip travels.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef ITINERARYPLANNER_H
+#define ITINERARYPLANNER_H
+
+#include <string>
+#include <vector>
+#include "routeplanner.h"
+
+using namespace std;
+
+/// @brief A round trip from the first stop through the others and back
+struct Itinerary
+{
+    vector<int> order; // stop ids in visiting order, starting at the origin
+    vector<int> route; // every system along the trip, ending at the origin
+    int hops = 0;
+};
+
+/// @brief What planning an itinerary took
+struct ItineraryStats
+{
+    int stops = 0;
+    bool exact = false;
+    long firstHops = 0;  // nearest neighbour trip before improvement
+    long improvements = 0;
+    long settled = 0;    // systems reached by the matrix searches
+    double matrixMs = 0.0;
+    double orderMs = 0.0;
+    double expandMs = 0.0;
+
+    /// @return one line summary
+    string toString() const;
+};
+
+class ItineraryPlanner
+{
+    public:
+        /// @brief hop count standing in for "no route"; large enough that
+        ///        any trip using one is longer than every trip without
+        static constexpr int kNoRoute = 1 << 20;
+
+        /// @brief most stops solveExact takes; its tables hold
+        ///        2^(stops - 1) * (stops - 1) entries
+        static constexpr int kMaxExact = 20;
+
+        /// @param planner a built planner, searched by every worker
+        explicit ItineraryPlanner(const RoutePlanner &planner);
+
+        /// @brief Use this many threads, 0 for one per hardware thread.
+        void setWorkers(int workers);
+
+        /// @brief Solve the order exactly up to this many stops, at most
+        ///        kMaxExact.
+        void setExactLimit(int stops);
+
+        /// @brief Find a short round trip through every stop.
+        /// @param stops system ids, the first being the origin; repeats
+        ///        are visited once
+        /// @param itinerary filled with the order and the expanded route
+        /// @param stats optional work counters and timings
+        /// @return false for an unknown id, or when no order was found in
+        ///         which each stop can reach the next
+        bool plan(const vector<int> &stops, Itinerary &itinerary, ItineraryStats *stats = nullptr) const;
+
+        /// @return hops from stop i to stop j at [i * n + j], kNoRoute when
+        ///         there is no route
+        /// @param settled optional count of systems the searches reached
+        vector<int> hopMatrix(const vector<int> &stops, long *settled = nullptr) const;
+
+        /// @return positions 0..n-1 in the order of the shortest round trip
+        ///         from position 0, by dynamic programming over subsets
+        /// @throw invalid_argument when n is more than kMaxExact
+        vector<int> solveExact(const vector<int> &matrix, int n) const;
+
+        /// @return positions 0..n-1 in the order of a short round trip from
+        ///         position 0, by nearest neighbour, 2-opt and Or-opt
+        /// @param firstHops optional length of the nearest neighbour trip
+        /// @param improvements optional count of moves taken
+        vector<int> solveHeuristic(const vector<int> &matrix, int n, long *firstHops = nullptr,
+                                   long *improvements = nullptr) const;
+
+        /// @return hops of the round trip through positions in tour order
+        static long tripHops(const vector<int> &matrix, int n, const vector<int> &tour);
+
+    private:
+        const RoutePlanner &planner;
+        int workers = 0;
+        int exactLimit = 16;
+};
+
+#endif
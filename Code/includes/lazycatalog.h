@@ -0,0 +1,100 @@
+/// @file lazycatalog.h
+/// @brief Lazy loading of celestial data. A first pass over the data file
+///        creates Solar System shells and records where each system's
+///        lines are; stars, planets and satellites are read only when a
+///        system's details are needed, with a bound on how many systems
+///        keep their bodies resident.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef LAZYCATALOG_H
+#define LAZYCATALOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+
+using namespace std;
+
+/// @brief What the lazy catalog has done since it was opened
+struct LazyStats
+{
+    double indexMs = 0.0;           // first pass over the file
+    unsigned long loads = 0;        // systems whose bodies were read
+    unsigned long evictions = 0;    // systems whose bodies were dropped
+    unsigned long long bytesRead = 0;
+
+    /// @return one line summary
+    string toString() const;
+};
+
+class LazyCatalog
+{
+    public:
+        /// @brief Index a celestial data file and create a shell for every
+        ///        system in it. Throws FileException on a line without a
+        ///        keyword or system name; other errors surface when the
+        ///        system is loaded.
+        /// @param fileName the celestial data file, kept open for loads
+        /// @param systems the vector of loaded Solar Systems
+        /// @param index the index kept in step with systems
+        /// @param capacity most systems to keep bodies for, at least 1
+        void open(const string &fileName, vector<shared_ptr<SolarSystem>> &systems,
+                  SystemIndex &index, size_t capacity);
+
+        /// @return true while systems may be waiting for their bodies
+        bool isActive() const;
+
+        /// @brief Load a system's bodies if they are not resident, dropping
+        ///        the least recently used system's when over capacity.
+        ///        Systems the file did not name are always resident.
+        void ensureLoaded(int id);
+
+        /// @brief Load every listed system and keep them all resident until
+        ///        the next load, even past capacity.
+        void ensureLoaded(const vector<int> &ids);
+
+        /// @brief Load every system and leave lazy mode, for operations
+        ///        that change bodies or need all of them.
+        void materializeAll();
+
+        /// @brief Leave lazy mode without loading, for when the systems
+        ///        are cleared.
+        void clear();
+
+        /// @return number of systems with bodies resident
+        size_t residentCount() const;
+
+        /// @return counters since open
+        const LazyStats &getStats() const;
+
+    private:
+        struct Run
+        {
+            uint64_t offset; // start of the first line in the file
+            uint32_t length; // bytes of whole lines, newlines included
+        };
+
+        void load(int id);
+        void evictOver(size_t limit);
+        void touch(int id);
+
+        string fileName;
+        ifstream file;
+        vector<shared_ptr<SolarSystem>> *systems = nullptr;
+        SystemIndex *index = nullptr;
+        size_t capacity = 1;
+
+        vector<size_t> runStart; // runs of system id are runs[runStart[id] .. runStart[id + 1])
+        vector<Run> runs;
+        vector<char> resident;
+        list<int> recent;        // resident ids, most recently used first
+        vector<list<int>::iterator> position;
+        LazyStats stats;
+};
+
+#endif
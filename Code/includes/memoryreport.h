@@ -0,0 +1,107 @@
+/// @file memoryreport.h
+/// @brief Accounting of the heap bytes held by the loaded universe, split
+///        by what the bytes are for, and compaction of spare capacity.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class SolarSystem;
+class SystemIndex;
+
+/// @brief Heap bytes by category. Every allocation is charged at the size
+///        glibc malloc hands out, the rounding goes to allocatorBytes, and
+///        unused vector capacity goes to slackBytes.
+struct MemoryReport
+{
+    size_t systems = 0;
+    size_t stars = 0;
+    size_t planets = 0;
+    size_t satellites = 0;
+
+    size_t systemBytes = 0;       // SolarSystem objects less their names
+    size_t starBytes = 0;         // Star objects less their names
+    size_t planetBytes = 0;       // Planet objects less their names
+    size_t satelliteBytes = 0;    // Satellite objects less their names
+    size_t nameBytes = 0;         // name strings, inline and on the heap
+    size_t controlBlockBytes = 0; // shared_ptr reference counts
+    size_t bodyListBytes = 0;     // celestialBodies and Planet sats vectors
+    size_t connectionBytes = 0;   // connection vectors and index adjacency
+    size_t hashIndexBytes = 0;    // name lookup tables, keys included
+    size_t systemTableBytes = 0;  // the systems vector and index by id
+    size_t slackBytes = 0;        // reserved but unused vector capacity
+    size_t allocatorBytes = 0;    // malloc headers and rounding
+
+    /// @return sum of every byte category
+    size_t total() const;
+
+    /// @return one line per category with its share of the total
+    string toString() const;
+
+    /// @brief Charge one allocation of reserved bytes of which used are
+    ///        in use.
+    void addAllocation(size_t &category, size_t used, size_t reserved);
+
+    /// @brief Charge a string's own bytes and any heap buffer to names.
+    ///        Pass inlineToo false when the string object is already
+    ///        counted as part of something else.
+    void addName(const string &name, bool inlineToo = true);
+
+    /// @brief Charge a make_shared allocation of T: the object, less its
+    ///        name, to category and the reference counts to control blocks.
+    template <typename T>
+    void addShared(size_t &category, size_t nameBytes = sizeof(string)) {
+        this->controlBlockBytes += kControlBlock;
+        category += sizeof(T) - nameBytes;
+        this->allocatorBytes += heapChunk(kControlBlock + sizeof(T)) - (kControlBlock + sizeof(T));
+    }
+
+    /// @brief Charge a vector's buffer, used part to category.
+    template <typename T>
+    void addVector(size_t &category, const vector<T> &items) {
+        this->addAllocation(category, items.size() * sizeof(T), items.capacity() * sizeof(T));
+    }
+
+    /// @brief Charge an unordered_map's buckets, nodes and string keys to
+    ///        the hash index category.
+    template <typename V>
+    void addHashIndex(const unordered_map<string, V> &table) {
+        // libstdc++ nodes hold the next pointer, the pair and the cached hash
+        size_t node = sizeof(void *) + sizeof(pair<const string, V>) + sizeof(size_t);
+        for (const auto &entry : table) {
+            this->addAllocation(this->hashIndexBytes, node, node);
+            if (entry.first.capacity() > kInlineChars) {
+                this->addAllocation(this->hashIndexBytes, entry.first.size() + 1, entry.first.capacity() + 1);
+            }
+        }
+        if (table.bucket_count() > 1) {
+            size_t buckets = table.bucket_count() * sizeof(void *);
+            this->addAllocation(this->hashIndexBytes, buckets, buckets);
+        }
+    }
+
+    /// @return bytes glibc malloc sets aside for a request of n bytes
+    static size_t heapChunk(size_t n) {
+        return n == 0 ? 0 : max<size_t>(32, (n + 8 + 15) & ~static_cast<size_t>(15));
+    }
+
+    static const size_t kControlBlock = 16; // vtable pointer and two counts
+    static const size_t kInlineChars = 15;  // libstdc++ short string buffer
+};
+
+/// @brief Account every byte reachable from the systems and their index.
+MemoryReport measureMemory(const vector<shared_ptr<SolarSystem>> &systems, const SystemIndex &index);
+
+/// @brief Drop spare vector capacity and oversized hash tables after loading.
+void shrinkMemory(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+
+#endif
@@ -0,0 +1,78 @@
+/// @file nameindex.h
+/// @brief Sorted name table over Solar System and Celestial names giving
+///        exact lookup, prefix ranges and bounded edit distance search.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "systemindex.h"
+
+using namespace std;
+
+enum class NameKind : unsigned char { System, Star, Planet, Satellite };
+
+/// @return "System", "Star", "Planet" or "Satellite"
+string nameKindToString(NameKind kind);
+
+/// @brief One name found by a search
+struct NameMatch
+{
+    string name;
+    NameKind kind;
+    int systemId;
+    int distance; // edits from the query, 0 for exact and prefix matches
+};
+
+class NameIndex
+{
+    public:
+        /// @brief Build the table from every system, star, planet and
+        ///        satellite name.
+        void build(const SystemIndex &index);
+
+        /// @return true when systems or bodies changed since the last build
+        bool isStale(const SystemIndex &index) const;
+
+        /// @return number of names in the table
+        int size() const;
+
+        /// @return id of the system with exactly this name, -1 when none
+        int findSystem(const string &name) const;
+
+        /// @brief Names starting with prefix, in sorted order.
+        /// @param limit most matches to return
+        /// @param total when given, set to the number of names in the range
+        vector<NameMatch> withPrefix(const string &prefix, size_t limit, size_t *total = nullptr) const;
+
+        /// @brief Names within maxEdits insertions, deletions or
+        ///        substitutions of query, closest first.
+        /// @param systemsOnly only return Solar System names
+        vector<NameMatch> similar(const string &query, int maxEdits, size_t limit, bool systemsOnly = false) const;
+
+    private:
+        struct Entry
+        {
+            size_t offset;   // start of the name in chars
+            uint32_t length;
+            int systemId;
+            NameKind kind;
+        };
+
+        string_view nameOf(const Entry &entry) const;
+        size_t lowerBound(string_view name) const;
+        size_t prefixEnd(size_t from, string_view prefix) const;
+        void add(const string &name, NameKind kind, int systemId);
+
+        string chars;          // every name back to back
+        vector<Entry> entries; // sorted by name
+        unsigned long builtVersion = 0;
+        unsigned long builtBodiesVersion = 0;
+        bool built = false;
+};
+
+#endif
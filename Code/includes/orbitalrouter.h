@@ -0,0 +1,101 @@
+/// @file orbitalrouter.h
+/// @brief Departure time aware routing. Every connection takes a fixed
+///        number of days to fly, and entering a system then takes a
+///        transfer whose length follows the orbit of that system's
+///        reference planet: free when the planet is at phase zero, longest
+///        half an orbit later. A ship may also hold position for a better
+///        window, so each system's transfer is kept as the best of waiting
+///        or going now, sampled at fixed phases when the router is built.
+///        Queries read those tables and never compute trigonometry.
+///        Because waiting is allowed, leaving later never arrives earlier,
+///        and a Dijkstra search on arrival time finds the earliest arrival.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef ORBITALROUTER_H
+#define ORBITALROUTER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "systemindex.h"
+#include "routeplanner.h"
+
+using namespace std;
+
+/// @brief Which planet's orbit sets a system's transfer windows
+enum class ReferencePlanet { First, Fastest, Slowest };
+
+/// @brief Costs of the time dependent model, in days like orbitalPeriod
+struct OrbitalModel
+{
+    double hopDays = 30.0;      // flight along one connection
+    double transferDays = 60.0; // transfer at the worst phase
+    ReferencePlanet reference = ReferencePlanet::First;
+};
+
+class OrbitalRouter
+{
+    public:
+        /// @brief phase samples per system
+        static constexpr int kPhaseSteps = 32;
+
+        /// @brief Use this model from the next build.
+        void setModel(const OrbitalModel &model);
+
+        /// @return the model of the last build
+        const OrbitalModel &getModel() const;
+
+        /// @brief Snapshot the connections of the index and the phase table
+        ///        of every system from its reference planet.
+        void build(const SystemIndex &index);
+
+        /// @return true when systems, connections or bodies changed since
+        ///         the last build
+        bool isStale(const SystemIndex &index) const;
+
+        /// @brief Find the route arriving earliest when leaving start on a
+        ///        given day.
+        /// @param route filled with system ids from start to end
+        /// @param arriveDay set to the day the transfer into end completes
+        /// @param stats optional work counters for the query
+        /// @return true when end can be reached from start
+        bool findEarliestArrival(int start, int end, double departDay, vector<int> &route,
+                                 double &arriveDay, RouteStats *stats = nullptr) const;
+
+        /// @return the day a ship leaving on departDay completes a route,
+        ///         taking each transfer window as the tables do
+        double followRoute(const vector<int> &route, double departDay) const;
+
+        /// @return days from arriving at a system on a day until the
+        ///         transfer into it completes, waiting included
+        double transferDelay(int id, double day) const;
+
+        /// @return number of systems in the snapshot
+        int size() const;
+
+        /// @return bytes held by the phase tables
+        size_t tableBytes() const;
+
+    private:
+        // connections as compressed rows, as in RoutePlanner
+        vector<int> offsets;
+        vector<int> targets;
+
+        // kPhaseSteps delays per system, and 1 / period of its reference
+        // planet, 0 for systems without planets
+        vector<float> delays;
+        vector<double> frequencies;
+
+        OrbitalModel model;
+        unsigned long builtVersion = 0;
+        unsigned long builtBodiesVersion = 0;
+        bool built = false;
+
+        // per query scratch, reused through stamps instead of cleared
+        mutable vector<double> arrival;
+        mutable vector<int> parent;
+        mutable vector<unsigned> stamp;
+        mutable unsigned currentStamp = 0;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/// @file profiler.h
+/// @brief Lightweight instrumentation: scoped timers and counters that
+///        accumulate per thread and are merged when reported.
+///        Collection is switched on at run time (-profile) and the macros
+///        compile to nothing when INTERSTELLAR_NO_PROFILE is defined.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+using namespace std;
+
+/// @brief true while regions are being recorded
+inline atomic<bool> profilingEnabled{false};
+
+/// @brief Switch recording on or off.
+void setProfiling(bool enabled);
+
+/// @return true while regions are being recorded
+inline bool isProfiling() {
+    return profilingEnabled.load(memory_order_relaxed);
+}
+
+/// @brief Register a region by name, or find it if already registered.
+/// @param timed true for a timer, false for a counter
+/// @return the region's id, -1 once the region table is full
+int profileRegion(const char *name, bool timed);
+
+/// @brief Add one timed sample to a region for the calling thread.
+void profileRecord(int region, uint64_t nanoseconds);
+
+/// @brief Add to a counter region for the calling thread.
+void profileCount(int region, uint64_t amount);
+
+/// @brief Print count, total, mean, p50 and p99 of every region with
+///        samples, merged over every thread.
+void profileReport(ostream &out);
+
+/// @brief Zero every region on every thread.
+void profileReset();
+
+/// @brief Times the enclosing scope into a region.
+class ProfileScope
+{
+    public:
+        explicit ProfileScope(int region) : region(region) {
+            if (isProfiling()) {
+                this->started = chrono::steady_clock::now();
+                this->active = true;
+            }
+        }
+
+        ~ProfileScope() {
+            if (this->active) {
+                auto elapsed = chrono::steady_clock::now() - this->started;
+                profileRecord(this->region, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+            }
+        }
+
+        ProfileScope(const ProfileScope &) = delete;
+        ProfileScope &operator=(const ProfileScope &) = delete;
+
+    private:
+        int region;
+        bool active = false;
+        chrono::steady_clock::time_point started;
+};
+
+#ifdef INTERSTELLAR_NO_PROFILE
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, amount)
+
+#else
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/// @brief time from here to the end of the enclosing scope
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileRegion_, __LINE__) = profileRegion(name, true); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileRegion_, __LINE__))
+
+/// @brief add amount to a named counter
+#define PROFILE_COUNT(name, amount) \
+    do { \
+        static const int profileCounter = profileRegion(name, false); \
+        if (isProfiling()) { \
+            profileCount(profileCounter, amount); \
+        } \
+    } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+/// @file queryengine.h
+/// @brief Attribute queries over stars, planets and satellites using
+///        columnar tables with sorted indexes per attribute.
+///        Utilized by the Interstellar Travel App.
+///
+/// A query names a body type followed by filters that must all hold:
+///   star type=G* mass>1.2
+///   star temperature=5000..6000
+///   planet period<=400 radius>=0.5
+///   satellite natural=no
+/// Numeric filters take =, <, <=, >, >= or a range lo..hi (inclusive).
+/// type takes an exact spectral type or a prefix ending in *.
+/// natural takes yes or no.
+
+#ifndef QUERYENGINE_H
+#define QUERYENGINE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "celestial.h"
+#include "systemindex.h"
+
+using namespace std;
+
+enum class BodyType : unsigned char { Star, Planet, Satellite };
+
+/// @brief Bodies matching a query, as rows of the body type's table, and
+///        the ids of the systems they belong to
+struct QueryResult
+{
+    BodyType type = BodyType::Star;
+    vector<int> rows;      // ascending
+    vector<int> systemIds; // ascending, no repeats
+    size_t candidates = 0; // rows taken from the most selective index
+    double elapsedMs = 0.0;
+};
+
+class QueryEngine
+{
+    public:
+        /// @brief Build the tables and indexes from every loaded body.
+        void build(const SystemIndex &index);
+
+        /// @return true when systems or bodies changed since the last build
+        bool isStale(const SystemIndex &index) const;
+
+        /// @brief Run a query. Throws invalid_argument when the query
+        ///        does not follow the syntax above.
+        QueryResult run(const string &query) const;
+
+        /// @return the body at a row of a type's table
+        shared_ptr<Celestial> bodyAt(BodyType type, int row) const;
+
+        /// @return the id of the system the body at a row belongs to
+        int systemAt(BodyType type, int row) const;
+
+        /// @return number of rows in a type's table
+        int numRows(BodyType type) const;
+
+    private:
+        /// @brief one numeric attribute, stored by row and sorted
+        struct NumberColumn
+        {
+            vector<double> values;       // by row
+            vector<double> sortedValues; // ascending
+            vector<int> sortedRows;      // row of each sorted value
+        };
+
+        /// @brief one text attribute, stored by row and sorted
+        struct TextColumn
+        {
+            vector<string> values;  // by row
+            vector<int> sortedRows; // rows in order of their value
+        };
+
+        /// @brief one yes/no attribute with the rows holding each answer
+        struct FlagColumn
+        {
+            vector<char> values; // by row
+            vector<int> yesRows;
+            vector<int> noRows;
+        };
+
+        /// @brief all bodies of one type
+        struct Table
+        {
+            vector<int> systemIds;
+            vector<shared_ptr<Celestial>> bodies;
+            vector<pair<string, NumberColumn>> numbers;
+            vector<pair<string, TextColumn>> texts;
+            vector<pair<string, FlagColumn>> flags;
+        };
+
+        static void finish(NumberColumn &column);
+        static void finish(TextColumn &column);
+        static void finish(FlagColumn &column);
+        const Table &tableFor(BodyType type) const;
+
+        Table stars;
+        Table planets;
+        Table satellites;
+        unsigned long builtVersion = 0;
+        unsigned long builtBodiesVersion = 0;
+        bool built = false;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/// @file queryserver.h
+/// @brief Local query server answering route, path validation, stats and
+///        system detail requests over a Unix domain socket. One thread runs
+///        an epoll loop that accepts clients and moves frames in and out;
+///        a pool of workers answers requests from the published universe
+///        snapshot, so many clients are served at once. Requests on one
+///        connection are answered in order, one at a time.
+///        See serverprotocol.h for the wire format.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "universesnapshot.h"
+
+using namespace std;
+
+/// @brief What a server has done since it started
+struct ServerStats
+{
+    uint64_t clients = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0;        // requests answered with ERROR
+    uint64_t badFrames = 0;     // connections dropped for an oversized frame
+
+    /// @return one line summary
+    string toString() const;
+};
+
+class QueryServer
+{
+    public:
+        /// @param publisher where workers read the universe from
+        /// @param workers number of worker threads, at least 1
+        QueryServer(SnapshotPublisher &publisher, int workers);
+        ~QueryServer();
+        QueryServer(const QueryServer &) = delete;
+        QueryServer &operator=(const QueryServer &) = delete;
+
+        /// @brief Listen on the socket path and serve until stop is called.
+        ///        A stale socket file at the path is replaced. Throws
+        ///        runtime_error when the socket cannot be set up.
+        void run(const string &socketPath);
+
+        /// @brief Make run return. Safe to call from a signal handler.
+        void stop();
+
+        /// @return counters, complete once run has returned
+        ServerStats getStats() const;
+
+        /// @brief Answer one request payload from a snapshot.
+        /// @param scratch the calling thread's route search arrays
+        /// @return the response payload
+        static string answer(const UniverseSnapshot &snapshot, RouteScratch &scratch, const string &request);
+
+    private:
+        struct Connection
+        {
+            int fd = -1;
+            string in;           // bytes received, not yet taken as frames
+            string out;          // encoded responses not yet sent
+            bool busy = false;   // a request is with the workers
+            bool closing = false;
+            uint32_t events = 0; // epoll interest currently registered
+        };
+
+        struct Job
+        {
+            uint64_t connection;
+            string request;
+        };
+
+        void work();
+        void acceptClients();
+        void readClient(uint64_t id, Connection &client);
+        bool writeClient(uint64_t id, Connection &client);
+        void dispatch(uint64_t id, Connection &client);
+        void collectAnswers();
+        void watch(uint64_t id, Connection &client);
+        void drop(uint64_t id);
+        void shutDown();
+
+        SnapshotPublisher &publisher;
+        int numWorkers;
+        int listenFd = -1;
+        int epollFd = -1;
+        int wakeFd = -1;     // eventfd, written by workers and stop
+        string socketPath;
+        atomic<bool> stopping{false};
+
+        // loop thread only
+        unordered_map<uint64_t, Connection> connections;
+        uint64_t nextId = 2; // 0 and 1 tag the listening socket and wakeFd
+        ServerStats stats;
+
+        // handed between the loop and the workers
+        mutex jobsLock;
+        condition_variable jobsReady;
+        deque<Job> jobs;
+        mutex answersLock;
+        vector<Job> answers; // request replaced by the encoded response
+        atomic<uint64_t> errorCount{0};
+        vector<thread> workers;
+};
+
+#endif
@@ -0,0 +1,245 @@
+/// @file routeplanner.h
+/// @brief Automatic route generation between Solar Systems over a flat
+///        snapshot of the connection graph. Routes are A* searches on hop
+///        count, guided by straight line distance when positions are known
+///        and by landmark (ALT) bounds when landmarks are asked for: hop
+///        tables to and from a few landmark systems give lower bounds on
+///        the hops left through the triangle inequality. Ranged routes
+///        also carry the fuel left as search state. A build may renumber
+///        the systems so that neighbours sit close together in memory.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "systemindex.h"
+
+using namespace std;
+
+/// @brief Work done by one route query
+struct RouteStats
+{
+    int settled = 0;
+    double elapsedMs = 0.0;
+};
+
+/// @brief Per query work arrays. A planner keeps one for its own calls;
+///        threads sharing a built planner each bring their own.
+struct RouteScratch
+{
+    vector<unsigned> stamp;
+    vector<int> hops;
+    vector<int> parent;
+    unsigned currentStamp = 0;
+    vector<int> landmarks; // the landmarks guiding the current query
+    vector<double> fuel;   // most fuel left on reaching each system
+};
+
+/// @brief How landmarks are picked. Farthest spreads them to the edges of
+///        the graph, each the system farthest from those already picked;
+///        Degree takes the best connected systems, no two adjacent.
+enum class LandmarkChoice { Farthest, Degree };
+
+/// @brief How a build numbers the systems of its snapshot. Load keeps the
+///        index's ids. The others renumber so that systems searched
+///        together sit together in memory: Bfs in breadth first order over
+///        connections either way, Rcm in reverse Cuthill-McKee order, and
+///        Degree best connected first.
+enum class SystemOrder { Load, Bfs, Rcm, Degree };
+
+/// @brief Set of system ids as a bitset, one bit per system
+class SystemSet
+{
+    public:
+        /// @brief An empty set with room for ids below systems.
+        explicit SystemSet(int systems = 0);
+
+        /// @brief Add a system, growing the set as needed.
+        void insert(int id);
+
+        /// @return true when the system is in the set
+        bool contains(int id) const {
+            size_t word = static_cast<size_t>(id) >> 6;
+            return word < this->words.size() && (this->words[word] >> (id & 63) & 1) != 0;
+        }
+
+        /// @return number of systems in the set
+        int count() const;
+
+    private:
+        vector<uint64_t> words;
+};
+
+/// @brief What a constrained route must respect
+struct RouteConstraints
+{
+    SystemSet avoid;       // systems the route may not pass through
+    vector<int> waypoints; // visited in this order between start and end
+    int maxHops = -1;      // longest route allowed, -1 for no limit
+};
+
+/// @brief Which systems a ship can refuel at
+struct RefuelPolicy
+{
+    string starClasses = "FGK";       // spectral classes of suitable stars
+    bool artificialSatellites = true; // any artificial satellite will do
+};
+
+/// @brief Mark each system of the index with a suitable star, or with an
+///        artificial satellite when the policy allows them.
+/// @return the systems a ship can refuel at
+SystemSet findRefuelSystems(const SystemIndex &index, const RefuelPolicy &policy);
+
+class RoutePlanner
+{
+    public:
+        /// @brief Snapshot the connections and positions of the index, and
+        ///        compute landmark tables when landmarks were asked for.
+        void build(const SystemIndex &index);
+
+        /// @brief Snapshot a bare graph given as compressed rows, the
+        ///        targets of system v at targets[offsets[v]..offsets[v+1]).
+        ///        There are no positions, so the distance heuristic is off.
+        void build(vector<int> offsets, vector<int> targets);
+
+        /// @brief Have every build compute tables for this many landmarks,
+        ///        0 for none. Takes effect at the next build.
+        void setLandmarks(int count, LandmarkChoice choice = LandmarkChoice::Farthest);
+
+        /// @brief Have every build renumber the systems of its snapshot.
+        ///        Queries still take and give system ids; only neighbors
+        ///        works on the snapshot's own numbering. Takes effect at
+        ///        the next build.
+        void setOrder(SystemOrder order);
+
+        /// @return number of landmarks in the tables of the last build
+        int landmarkCount() const;
+
+        /// @return bytes held by the landmark tables
+        size_t landmarkBytes() const;
+
+        /// @return true when the index changed since the last build
+        bool isStale(const SystemIndex &index) const;
+
+        /// @return true when the distance heuristic is in use. It is only
+        ///         admissible when every connected system has a position.
+        bool usesHeuristic() const;
+
+        /// @brief Find a route with the fewest hops along connections,
+        ///        guided by distance and landmarks where available.
+        /// @param route filled with system ids from start to end
+        /// @param stats optional work counters for the query
+        /// @return true when end can be reached from start
+        bool findRoute(int start, int end, vector<int> &route, RouteStats *stats = nullptr) const;
+
+        /// @brief Same as findRoute with the heuristic switched off.
+        bool findRouteUninformed(int start, int end, vector<int> &route, RouteStats *stats = nullptr) const;
+
+        /// @brief Same as findRoute guided by the landmarks alone.
+        bool findRouteLandmarks(int start, int end, vector<int> &route, RouteStats *stats = nullptr) const;
+
+        /// @brief Find the route with the fewest hops that passes the
+        ///        waypoints in order, never enters an avoided system and
+        ///        takes at most maxHops hops. Systems may be passed more
+        ///        than once.
+        /// @param route filled with system ids from start to end
+        /// @param stats optional work counters summed over every leg
+        /// @return false when no route meets the constraints, including
+        ///         when start, end or a waypoint is avoided
+        bool findConstrainedRoute(int start, int end, const RouteConstraints &constraints,
+                                  vector<int> &route, RouteStats *stats = nullptr) const;
+
+        /// @brief Find the route with the fewest hops for a ship that can
+        ///        fly at most range between refuels. Each jump burns its
+        ///        straight line length, or one unit when the distance
+        ///        heuristic is off; the tank fills at every refuel system.
+        /// @param refuel systems where the tank fills, see findRefuelSystems
+        /// @param route filled with system ids from start to end
+        /// @param stats optional work counters; settled counts labels
+        /// @return true when end can be reached without running dry
+        bool findRangedRoute(int start, int end, double range, const SystemSet &refuel,
+                             vector<int> &route, RouteStats *stats = nullptr) const;
+
+        /// @brief Every system within maxHops of any origin, ring by ring,
+        ///        by a breadth first search one frontier at a time. Each
+        ///        system is reported once, in the ring of its nearest
+        ///        origin; the origins themselves are ring 0.
+        /// @param maxHops rings after the origins, -1 for no limit
+        /// @param ring called with each hop count and the systems first
+        ///        reached at it, as soon as the ring is complete
+        /// @return number of systems reached, origins included
+        long findReachable(const vector<int> &origins, int maxHops,
+                           const function<void(int hops, const vector<int> &systems)> &ring) const;
+
+        /// @return fuel a jump between two systems burns
+        double jumpLength(int from, int to) const;
+
+        /// @brief findRoute using the caller's scratch, so any number of
+        ///        threads may search one built planner at the same time.
+        bool findRoute(int start, int end, vector<int> &route, RouteScratch &scratch,
+                       RouteStats *stats = nullptr) const;
+
+        /// @return number of systems in the snapshot
+        int size() const;
+
+        /// @return vertices connected from a vertex, as a range of the
+        ///         snapshot's targets. Vertices are system ids unless the
+        ///         build was reordered, see vertexOf and systemOf.
+        pair<const int *, const int *> neighbors(int vertex) const;
+
+        /// @return the vertex numbering a system in the snapshot
+        int vertexOf(int id) const {
+            return this->vertices.empty() || id < 0 || id >= this->size() ? id : this->vertices[id];
+        }
+
+        /// @return the system id of a vertex in the snapshot
+        int systemOf(int vertex) const {
+            return this->systems.empty() || vertex < 0 || vertex >= this->size() ? vertex : this->systems[vertex];
+        }
+
+    private:
+        bool search(int start, int end, int guides, vector<int> &route, RouteScratch &scratch,
+                    RouteStats *stats, const SystemSet *avoid = nullptr, int hopLimit = -1) const;
+        int guess(int from, int end, int guides, const vector<int> &active) const;
+        int estimate(int from, int end) const;
+        int landmarkEstimate(int from, int end, const vector<int> &active) const;
+        void chooseActiveLandmarks(int start, int end, vector<int> &active) const;
+        void buildLandmarks();
+        int guidesAvailable() const;
+        double jump(int from, int to) const;
+        void renumber();
+
+        // connections as compressed rows: targets[offsets[v]..offsets[v+1])
+        vector<int> offsets;
+        vector<int> targets;
+        vector<double> coords; // x, y, z per system id
+        double maxJump = 0.0;  // longest single connection
+        bool heuristic = false;
+
+        // numbering of the snapshot, both empty when kept in load order
+        SystemOrder order = SystemOrder::Load;
+        vector<int> vertices; // vertex of each system id
+        vector<int> systems;  // system id of each vertex
+
+        // landmark tables, a row per system: hops from each landmark to the
+        // system and from the system to each landmark
+        int landmarksWanted = 0;
+        LandmarkChoice landmarkChoice = LandmarkChoice::Farthest;
+        vector<int> landmarks;
+        vector<uint16_t> fromLandmark;
+        vector<uint16_t> toLandmark;
+
+        unsigned long builtVersion = 0;
+        bool built = false;
+
+        // per query scratch, reused through stamps instead of cleared
+        mutable RouteScratch scratch;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/// @file serverprotocol.h
+/// @brief Wire format of the query server. Every message in either
+///        direction is a frame: a 4 byte big endian length followed by
+///        that many bytes of text. A request's lines are the command and
+///        then one argument per line, so system names may hold spaces:
+///
+///            PING
+///            ROUTE\n<start>\n<end>
+///            VALIDATE\n<system>\n<system>...
+///            DETAILS\n<system>
+///            STATS
+///            NAMES
+///
+///        A response's first line is OK or ERROR, the rest is the answer
+///        or the error message.
+///        Utilized by the Interstellar Travel App and the loadclient tool.
+
+#ifndef SERVERPROTOCOL_H
+#define SERVERPROTOCOL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// @brief largest frame either side accepts
+const uint32_t kMaxFrameBytes = 16u << 20;
+
+/// @return payload with its length prefix
+string encodeFrame(const string &payload);
+
+/// @brief Take one whole frame off the front of a receive buffer.
+/// @param buffer bytes received so far, the frame is erased from it
+/// @param payload set to the frame's text
+/// @return 1 when a frame was taken, 0 when more bytes are needed, -1
+///         when the length is over kMaxFrameBytes
+int decodeFrame(string &buffer, string &payload);
+
+/// @brief Split a request or response into its lines.
+vector<string> splitLines(const string &payload);
+
+/// @brief Connect a blocking socket to a server.
+/// @return the socket, -1 with errno set on failure
+int connectToServer(const string &socketPath);
+
+/// @brief Send one frame on a blocking socket.
+/// @return false when the connection failed
+bool sendFrame(int fd, const string &payload);
+
+/// @brief Receive one frame on a blocking socket.
+/// @return false when the connection closed or sent a bad frame
+bool receiveFrame(int fd, string &payload);
+
+#endif
@@ -0,0 +1,51 @@
+/// @file spatialindex.h
+/// @brief k-d tree over the positions of the Solar Systems, stored as flat
+///        arrays, answering nearest neighbour and radius queries.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <utility>
+#include <vector>
+#include "systemindex.h"
+
+using namespace std;
+
+class SpatialIndex
+{
+    public:
+        /// @brief Build the tree from every system that has a position.
+        void build(const SystemIndex &index);
+
+        /// @return true when the index changed since the last build
+        bool isStale(const SystemIndex &index) const;
+
+        /// @return number of systems in the tree
+        int size() const;
+
+        /// @brief Find the k systems closest to a point, at most size().
+        /// @return (system id, distance) pairs, closest first; empty when
+        ///         k is not positive
+        vector<pair<int, double>> nearest(double x, double y, double z, int k) const;
+
+        /// @brief Find every system within a distance of a point.
+        /// @return (system id, distance) pairs, closest first
+        vector<pair<int, double>> withinRadius(double x, double y, double z, double radius) const;
+
+    private:
+        void buildRange(int lo, int hi, int depth);
+        void nearestRange(int lo, int hi, int depth, const double *point, size_t k,
+                          vector<pair<double, int>> &heap) const;
+        void radiusRange(int lo, int hi, int depth, const double *point, double radiusSq,
+                         vector<pair<int, double>> &found) const;
+
+        // the tree is implicit: a range [lo, hi) has its splitting point at
+        // the middle and splits on axis depth % 3
+        vector<double> coords; // x, y, z of each point in tree order
+        vector<int> ids;       // system id of each point in tree order
+        unsigned long builtVersion = 0;
+        bool built = false;
+};
+
+#endif
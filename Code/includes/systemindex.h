@@ -0,0 +1,99 @@
+/// @file systemindex.h
+/// @brief Name and connection index over the loaded Solar Systems.
+///        Gives every system a stable integer id so loaders and
+///        queries can find systems without scanning the systems vector.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef SYSTEMINDEX_H
+#define SYSTEMINDEX_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "solarsystem.h"
+#include "memoryreport.h"
+
+using namespace std;
+
+class SystemIndex
+{
+    public:
+        /// @brief Index any systems appended to the vector since the last
+        ///        call, with the connections they already hold. Rebuilds
+        ///        from scratch if the vector was replaced.
+        /// @throw logic_error when a system connects to one not in the
+        ///        vector
+        void sync(const vector<shared_ptr<SolarSystem>> &systems);
+
+        /// @brief Forget every indexed system and connection.
+        void clear();
+
+        /// @brief Forget every connection, systems stay indexed.
+        void clearConnections();
+
+        /// @return the id of the named system, -1 when not indexed
+        int idOf(const string &name) const;
+
+        /// @return the named system, nullptr when not indexed
+        shared_ptr<SolarSystem> find(const string &name) const;
+
+        /// @return the system with the given id
+        shared_ptr<SolarSystem> at(int id) const;
+
+        /// @return number of indexed systems
+        int size() const;
+
+        /// @brief Find the named system, creating it at the back of
+        ///        systems when it does not exist yet.
+        /// @param created set to true when a new system was made
+        /// @return the id of the system
+        int findOrCreate(vector<shared_ptr<SolarSystem>> &systems,
+                         const string &name, bool &created);
+
+        /// @brief Add a from -> to connection to both the index and the
+        ///        SolarSystem object.
+        /// @return true when the connection did not exist before
+        bool connect(int from, int to);
+
+        /// @brief Remove a from -> to connection from both the index and
+        ///        the SolarSystem object.
+        /// @return true when the connection existed
+        bool disconnect(int from, int to);
+
+        /// @return ids of the systems the given system connects to
+        const vector<int> &neighbors(int id) const;
+
+        /// @brief Set the coordinates of a system through the index so
+        ///        structures built from it can tell they are stale.
+        void setPosition(int id, double x, double y, double z);
+
+        /// @return a counter that changes whenever systems, connections or
+        ///         positions change, used to rebuild derived structures
+        unsigned long getVersion() const;
+
+        /// @brief Note that celestial bodies are about to be added or
+        ///        changed, for structures built from body data.
+        void markBodiesChanged();
+
+        /// @return a counter that changes with markBodiesChanged
+        unsigned long getBodiesVersion() const;
+
+        /// @brief Charge the id table, name table and adjacency lists to
+        ///        a memory report.
+        void addMemoryUsage(MemoryReport &report) const;
+
+        /// @brief Release spare capacity left over from loading.
+        void shrink();
+
+    private:
+        int insert(const shared_ptr<SolarSystem> &system);
+
+        vector<shared_ptr<SolarSystem>> byId;
+        unordered_map<string, int> ids;
+        vector<vector<int>> adjacency;
+        unsigned long version = 0;
+        unsigned long bodiesVersion = 0;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/// @file universegen.h
+/// @brief Synthetic universe generator writing celestial and connection
+///        data in the formats the loaders read, for scale testing.
+///        Utilized by the Interstellar Travel App benchmarks and the
+///        genuniverse tool.
+
+#ifndef UNIVERSEGEN_H
+#define UNIVERSEGEN_H
+
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+/// @brief Size and shape of a generated universe. The same spec and seed
+///        always produce the same files.
+struct UniverseSpec
+{
+    long systems = 10000;
+    int starsPerSystem = 1;
+    int planetsPerSystem = 3;
+    int satellitesPerPlanet = 1;
+    double meanDegree = 4.0;        // average connections per system
+    string degreeModel = "uniform"; // uniform, powerlaw or smallworld
+    double rewire = 0.1;            // smallworld chance an edge is random
+    bool coordinates = true;        // write System,name,x,y,z
+    long commentEvery = 1000;       // blank line and comment per block, 0 for none
+    unsigned long seed = 42;
+};
+
+/// @return the name given to system i of a generated universe
+string generatedSystemName(long i);
+
+/// @brief Write System, Star, Planet and Satellite lines for a spec.
+/// @return bytes written
+unsigned long long writeCelestialData(ostream &out, const UniverseSpec &spec);
+
+/// @brief Write one connection line per system for a spec.
+/// @return bytes written
+unsigned long long writeConnectionData(ostream &out, const UniverseSpec &spec);
+
+#endif
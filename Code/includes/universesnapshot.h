@@ -0,0 +1,196 @@
+/// @file universesnapshot.h
+/// @brief Published snapshots of the universe for concurrent readers.
+///        A writer thread keeps changing the loaded systems as before and
+///        publishes an immutable copy of what queries need after each
+///        change; any number of reader threads pin the current snapshot
+///        without locks and old snapshots are freed once no reader can
+///        still hold them (epoch based reclamation).
+///        Utilized by the Interstellar Travel App.
+
+#ifndef UNIVERSESNAPSHOT_H
+#define UNIVERSESNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "routeplanner.h"
+
+using namespace std;
+
+/// @brief One immutable version of the universe: names, rendered system
+///        details and stats, and the connection graph with positions. Nothing in it
+///        changes after capture, so readers need no synchronisation.
+class UniverseSnapshot
+{
+    public:
+        /// @brief Copy what queries need out of the loaded systems. Names
+        ///        and details are shared with the previous snapshot when
+        ///        no system or body changed since it was captured, so a
+        ///        connection update only rebuilds the graph and stats.
+        /// @param sequence the publisher's number for this snapshot
+        /// @param previous the last snapshot, nullptr for the first
+        UniverseSnapshot(const vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                         uint64_t sequence, const UniverseSnapshot *previous);
+
+        /// @return publish order, one higher than the snapshot before
+        uint64_t getSequence() const;
+
+        /// @return number of systems
+        int size() const;
+
+        /// @return the id of the named system, -1 when there is none
+        int idOf(const string &name) const;
+
+        /// @return the name of a system
+        const string &nameOf(int id) const;
+
+        /// @return the system's name and bodies as SolarSystem::toString
+        ///         gave them when captured
+        const string &detailsOf(int id) const;
+
+        /// @return the stats report of printLoadedCelestialStats
+        const string &getStatsText() const;
+
+        /// @return the connection graph and positions
+        const RoutePlanner &getPlanner() const;
+
+        /// @brief Find a route with the fewest hops in this snapshot.
+        /// @param scratch the calling thread's work arrays
+        bool findRoute(int start, int end, vector<int> &route, RouteScratch &scratch) const;
+
+    private:
+        struct Names
+        {
+            vector<string> byId;
+            unordered_map<string, int> ids;
+            vector<string> details;
+        };
+
+        uint64_t sequence;
+        unsigned long bodiesVersion;
+        shared_ptr<const Names> names;
+        string statsText;
+        RoutePlanner planner;
+};
+
+class SnapshotPublisher;
+
+/// @brief A reader thread's registration with a publisher. Each reader
+///        thread owns one; it announces which epoch it is reading in so
+///        the publisher knows which old snapshots are still reachable.
+class SnapshotReader
+{
+    public:
+        /// @brief Claim a reader slot. Throws length_error when every slot
+        ///        is taken.
+        explicit SnapshotReader(SnapshotPublisher &publisher);
+        ~SnapshotReader();
+        SnapshotReader(const SnapshotReader &) = delete;
+        SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+        /// @brief Keeps the snapshot it was given alive until destroyed.
+        ///        A reader holds at most one pin at a time.
+        class Pin
+        {
+            public:
+                ~Pin();
+                Pin(const Pin &) = delete;
+                Pin &operator=(const Pin &) = delete;
+
+                const UniverseSnapshot *operator->() const { return this->snapshot; }
+                const UniverseSnapshot &operator*() const { return *this->snapshot; }
+
+                /// @return false before anything was published
+                explicit operator bool() const { return this->snapshot != nullptr; }
+
+            private:
+                friend class SnapshotReader;
+                Pin(atomic<uint64_t> &slot, const UniverseSnapshot *snapshot);
+
+                atomic<uint64_t> &slot;
+                const UniverseSnapshot *snapshot;
+        };
+
+        /// @brief Pin the current snapshot. Wait free: two stores and two
+        ///        loads, no lock and no reference count.
+        Pin pin();
+
+        /// @return this reader's work arrays for route searches
+        RouteScratch &getScratch();
+
+    private:
+        SnapshotPublisher &publisher;
+        int slot;
+        RouteScratch scratch;
+};
+
+/// @brief Counters for the snapshots a publisher has handled
+struct SnapshotStats
+{
+    uint64_t published = 0;
+    uint64_t reclaimed = 0;
+    uint64_t pending = 0;     // retired but possibly still pinned
+    double lastCaptureMs = 0.0;
+
+    /// @return one line summary
+    string toString() const;
+};
+
+class SnapshotPublisher
+{
+    public:
+        static constexpr int kMaxReaders = 64;
+
+        SnapshotPublisher() = default;
+        SnapshotPublisher(const SnapshotPublisher &) = delete;
+        SnapshotPublisher &operator=(const SnapshotPublisher &) = delete;
+
+        /// @brief Frees every snapshot. No reader may be registered.
+        ~SnapshotPublisher();
+
+        /// @brief Capture the loaded systems and make the capture current.
+        ///        Called by the single writer thread after each change;
+        ///        also frees retired snapshots no reader holds any more.
+        /// @return the published snapshot's sequence number
+        uint64_t publish(const vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+
+        /// @brief Free retired snapshots that no reader can still hold.
+        ///        Writer thread only.
+        void reclaim();
+
+        /// @return the current snapshot for the writer thread itself, which
+        ///         needs no pin; nullptr before the first publish
+        const UniverseSnapshot *current() const;
+
+        /// @return publish and reclaim counters. Writer thread only.
+        SnapshotStats getStats() const;
+
+    private:
+        friend class SnapshotReader;
+
+        /// @brief an epoch slot alone on its cache line, so readers on
+        ///        different cores do not contend
+        struct alignas(64) Slot
+        {
+            atomic<uint64_t> epoch{0}; // 0 when not reading
+            atomic<bool> claimed{false};
+        };
+
+        atomic<const UniverseSnapshot *> latest{nullptr};
+        atomic<uint64_t> epoch{1};
+        Slot slots[kMaxReaders];
+
+        // writer thread only
+        unique_ptr<const UniverseSnapshot> owned; // the one latest points at
+        vector<pair<uint64_t, unique_ptr<const UniverseSnapshot>>> retired;
+        uint64_t sequence = 0;
+        SnapshotStats stats;
+};
+
+#endif
@@ -0,0 +1,23 @@
+/// @file workerpool.h
+/// @brief Splitting numbered jobs across worker threads, for searches that
+///        share one read only graph snapshot.
+///        Utilized by the Interstellar Travel App.
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <functional>
+
+using namespace std;
+
+/// @return threads to use for some jobs: wanted, or one per hardware
+///         thread when wanted is 0, never more than the jobs nor below one
+int workerCount(int wanted, int jobs);
+
+/// @brief Hand out jobs 0..jobs-1 to workers threads, each taking the next
+///        job as it finishes one. The calling thread is worker 0; the
+///        others are started here and joined before returning.
+/// @param work called with the worker number and the job number
+void runJobs(int jobs, int workers, const function<void(int worker, int job)> &work);
+
+#endif
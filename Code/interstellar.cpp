@@ -17,6 +17,10 @@
 
 // These are all the libraries you need!
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <fstream>
@@ -24,6 +28,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 // CS 211 Spring 2024 Project Specific Header Files
@@ -31,6 +36,24 @@
 #include "solarsystem.h"
 #include "fileexception.h"
 #include "flightpath.h"
+#include "systemindex.h"
+#include "catalog.h"
+#include "deltaloader.h"
+#include "spatialindex.h"
+#include "routeplanner.h"
+#include "contractionhierarchy.h"
+#include "itineraryplanner.h"
+#include "orbitalrouter.h"
+#include "graphanalytics.h"
+#include "nameindex.h"
+#include "queryengine.h"
+#include "profiler.h"
+#include "memoryreport.h"
+#include "lazycatalog.h"
+#include "backgroundloader.h"
+#include "universesnapshot.h"
+#include "queryserver.h"
+#include "compressedinput.h"
 
 using namespace std;
 
@@ -41,24 +64,78 @@ extern void welcomeSplash(bool);
 string acquireOption();
 void printMenu();
 bool validChoice(const string &);
-void readCelestialObjectsDataFile(vector<shared_ptr<SolarSystem>> &systems);
-void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems);
-void printSystemsCelestialDetails(vector<shared_ptr<SolarSystem>> &systems);
-void printSystemsConnectionDetails(vector<shared_ptr<SolarSystem>> &systems);
-void printLoadedCelestialStats(vector<shared_ptr<SolarSystem>> &systems);
-void planFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems);
+void readCelestialObjectsDataFile(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+void readDeltaFile(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+void planFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, NameIndex &names);
 void validateFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems);
-void clearSystems(vector<shared_ptr<SolarSystem>> &systems);
+void clearSystems(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+void generateFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+void printNearestSystems(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, SpatialIndex &spatial);
+void printSystemsInRadius(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, SpatialIndex &spatial);
+void printPrefixMatches(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, NameIndex &names);
+void runCatalogQuery(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, QueryEngine &queries);
+void shrinkLoadedData(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+void readCelestialObjectsDataFileLazily(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, LazyCatalog &lazy, size_t lazyCache);
+bool loadAllLazyBodies(LazyCatalog &lazy);
+void startBackgroundLoad(BackgroundLoader &loader, LoadKind kind, vector<shared_ptr<SolarSystem>> &systems);
+void commitBackgroundLoad(BackgroundLoader &loader, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+bool changesSystems(const string &option);
+void printLazyCelestials(vector<shared_ptr<SolarSystem>> &systems, LazyCatalog &lazy, bool statsOnly);
+void printPathCelestials(FlightPath &flightPath, SystemIndex &index, LazyCatalog &lazy);
+bool loadFileNamed(const string &fileName, LoadKind kind, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+int serveQueries(const string &socketPath, const string &celestialFile, const string &connectionFile, int workers);
+void stopServing(int);
+void readDataFileTolerantly(LoadKind kind, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index);
+void generateFlightPathFast(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, ContractionHierarchy &hierarchy);
+void chooseRouteLandmarks(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+void generateConstrainedFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+bool readConstraints(const string &via, const string &avoid, const string &maxHops, char separator,
+                     SystemIndex &index, RouteConstraints &constraints, string &problem);
+bool readSystemList(const string &names, char separator, SystemIndex &index, vector<int> &ids, string &problem);
+string describeRoute(const vector<int> &route, SystemIndex &index);
+int runBatchRoutes(const string &batchFile, const string &celestialFile, const string &connectionFile);
+void planItinerary(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+void generateEarliestArrival(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                             OrbitalRouter &router, RoutePlanner &planner);
+void generateRangedFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+void printReachableRings(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+void printHubSystems(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner);
+
+// The running query server, for the signal handler. Read inside the
+// handler, so it must be a lock-free atomic.
+atomic<QueryServer *> activeServer{nullptr};
+static_assert(atomic<QueryServer *>::is_always_lock_free, "the signal handler needs a lock-free pointer");
 
 int main(int argc, char* argv[])
 { 
     // Command line argument flags   
     bool showSplash = false;
     bool hideMenu = false;
+    size_t lazyCache = 1024;
+    string socketPath, celestialFile, connectionFile, batchFile;
+    int workers = max(2u, thread::hardware_concurrency());
 
     // Vector of shared pointers to Solar Systems
     vector<shared_ptr<SolarSystem>> systems;
 
+    // Name and connection index kept in step with systems
+    SystemIndex index;
+
+    // Structures derived from the index, rebuilt when it changes
+    SpatialIndex spatial;
+    RoutePlanner planner;
+    ContractionHierarchy hierarchy;
+    OrbitalRouter orbital;
+    NameIndex names;
+    QueryEngine queries;
+
+    // Bodies read on demand after a lazy load
+    LazyCatalog lazy;
+
+    // Files parsed on a worker thread while the menu stays usable
+    BackgroundLoader loader;
+
     // Flight path through the Solar Systems
     FlightPath path;
 
@@ -69,8 +146,43 @@ int main(int argc, char* argv[])
             showSplash = true;
         } else if (arg == "-hidemenu") {
             hideMenu = true;
+        } else if (arg == "-profile") {
+            setProfiling(true);
+        } else if (arg == "-lazycache" && i + 1 < argc) {
+            lazyCache = max(1, atoi(argv[++i]));
+        } else if (arg == "-serve" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "-celestial" && i + 1 < argc) {
+            celestialFile = argv[++i];
+        } else if (arg == "-connections" && i + 1 < argc) {
+            connectionFile = argv[++i];
+        } else if (arg == "-batch" && i + 1 < argc) {
+            batchFile = argv[++i];
+        } else if (arg == "-workers" && i + 1 < argc) {
+            workers = max(1, atoi(argv[++i]));
+        } else if (arg == "-order" && i + 1 < argc) {
+            string order = argv[++i];
+            if (order == "bfs") {
+                planner.setOrder(SystemOrder::Bfs);
+            } else if (order == "rcm") {
+                planner.setOrder(SystemOrder::Rcm);
+            } else if (order == "degree") {
+                planner.setOrder(SystemOrder::Degree);
+            } else if (order != "load") {
+                cout << "Unknown order " << order << ", expected load, bfs, rcm or degree." << endl;
+            }
         }
     }
+
+    // answer queries over a socket instead of running the menu
+    if (!socketPath.empty()) {
+        return serveQueries(socketPath, celestialFile, connectionFile, workers);
+    }
+
+    // answer a file of constrained route requests instead of the menu
+    if (!batchFile.empty()) {
+        return runBatchRoutes(batchFile, celestialFile, connectionFile);
+    }
     
     // Display the welcome splash or the simple one depending on settings
     welcomeSplash(showSplash);
@@ -85,27 +197,35 @@ int main(int argc, char* argv[])
 
     while (option != "15")
     {
-        if (validChoice(option))
+        // a finished background load becomes visible between menu choices
+        commitBackgroundLoad(loader, systems, index);
+
+        if (loader.isBusy() && changesSystems(option)) {
+            cout << "A background load is running, check it with option 27 or cancel it with option 28 first." << endl;
+        }
+        else if (validChoice(option))
         {                
             switch (stoi(option))
             {
                 case 1:
-                    readCelestialObjectsDataFile(systems);
+                    if (loadAllLazyBodies(lazy)) {
+                        readCelestialObjectsDataFile(systems, index);
+                    }
                     break;           
                 case 2:
-                    readSolarSystemConnectionFile(systems);
+                    readSolarSystemConnectionFile(systems, index);
                     break;
                 case 3:
-                    printSystemsCelestialDetails(systems);
+                    printLazyCelestials(systems, lazy, false);
                     break;
                 case 4:
                     printSystemsConnectionDetails(systems);
                     break;
                 case 5:
-                    printLoadedCelestialStats(systems);
+                    printLazyCelestials(systems, lazy, true);
                     break;
                 case 6:
-                    planFlightPath(path, systems);
+                    planFlightPath(path, systems, index, names);
                     break;
                 case 7:
                     validateFlightPath(path, systems);
@@ -117,25 +237,108 @@ int main(int argc, char* argv[])
                     path.printConnections();
                     break;
                 case 10:
-                    path.printPathCelestials();
+                    printPathCelestials(path, index, lazy);
                     break;
                 case 11:
                     path.clear();
                     break;
                 case 12:
-                    clearSystems(systems);
+                    clearSystems(systems, index);
                     break;
                 case 13:
                     // clear system's data
                     systems.clear();
+                    index.clear();
+                    lazy.clear();
                     break;
                 case 14:
-                    // ignore this case
-                    cout << "***ERROR: NOT IMPLEMENTED***" << endl;
+                    generateFlightPath(path, systems, index, planner);
                     break;
                 case 15: 
                     // exit the application
                     return 0;
+                case 16:
+                    if (loadAllLazyBodies(lazy)) {
+                        readDeltaFile(systems, index);
+                    }
+                    break;
+                case 17:
+                    printNearestSystems(systems, index, spatial);
+                    break;
+                case 18:
+                    printSystemsInRadius(systems, index, spatial);
+                    break;
+                case 19:
+                    if (loadAllLazyBodies(lazy)) {
+                        printPrefixMatches(systems, index, names);
+                    }
+                    break;
+                case 20:
+                    if (loadAllLazyBodies(lazy)) {
+                        runCatalogQuery(systems, index, queries);
+                    }
+                    break;
+                case 21:
+                    profileReport(cout);
+                    break;
+                case 22:
+                    printMemoryUsage(systems, index);
+                    if (lazy.isActive()) {
+                        cout << lazy.residentCount() << " systems have bodies resident. "
+                            << lazy.getStats().toString() << endl;
+                    }
+                    break;
+                case 23:
+                    shrinkLoadedData(systems, index);
+                    break;
+                case 24:
+                    readCelestialObjectsDataFileLazily(systems, index, lazy, lazyCache);
+                    break;
+                case 25:
+                    startBackgroundLoad(loader, LoadKind::Celestial, systems);
+                    break;
+                case 26:
+                    startBackgroundLoad(loader, LoadKind::Connections, systems);
+                    break;
+                case 27:
+                    cout << loader.progress().toString() << endl;
+                    break;
+                case 28:
+                    loader.cancel();
+                    cout << loader.progress().toString() << endl;
+                    break;
+                case 29:
+                    if (loadAllLazyBodies(lazy)) {
+                        readDataFileTolerantly(LoadKind::Celestial, systems, index);
+                    }
+                    break;
+                case 30:
+                    readDataFileTolerantly(LoadKind::Connections, systems, index);
+                    break;
+                case 31:
+                    generateFlightPathFast(path, systems, index, hierarchy);
+                    break;
+                case 32:
+                    chooseRouteLandmarks(systems, index, planner);
+                    break;
+                case 33:
+                    generateConstrainedFlightPath(path, systems, index, planner);
+                    break;
+                case 34:
+                    planItinerary(path, systems, index, planner);
+                    break;
+                case 35:
+                    generateEarliestArrival(path, systems, index, orbital, planner);
+                    break;
+                case 36:
+                    generateRangedFlightPath(path, systems, index, planner);
+                    break;
+                case 37:
+                    printReachableRings(systems, index, planner);
+                    break;
+                case 38:
+                    printHubSystems(systems, index, planner);
+                    break;
                 default:
                     // invalid choice, do nothing
                     break;    
@@ -150,22 +353,28 @@ int main(int argc, char* argv[])
         option = acquireOption();        
     }
 
+    // leave the profile of the whole run behind when asked for one
+    if (isProfiling()) {
+        cout << endl;
+        profileReport(cout);
+    }
+
     cout << endl << "Thank you for using the Interstellar Travel App." 
         << endl << endl;
 
     return 0;
 }
 
-void readCelestialObjectsDataFile(vector<shared_ptr<SolarSystem>> &systems) {
+void readCelestialObjectsDataFile(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
     // get the filename
     string inputFileLocationAndName;
     cout << "Enter the file location and name:"; // structure is 'data/alldata.csv'
     getline(cin, inputFileLocationAndName);
     cout << endl << endl;
 
-    ifstream inFile;
+    DataFileStream inFile;
     try {
-        // open the file
+        // open the file, plain or compressed
         inFile.open(inputFileLocationAndName);
 
         // check if file opened correctly
@@ -174,294 +383,7 @@ void readCelestialObjectsDataFile(vector<shared_ptr<SolarSystem>> &systems) {
             throw FileException("Exception Caught: File Not Found - " + inputFileLocationAndName);
         } 
         else {
-            // get data from the file
-            string line; int lineNumber = 0;
-            while (getline(inFile, line)) {
-                lineNumber++;
-
-                // skip blank lines
-                if (line.empty()) {
-                    continue;
-                }
-
-                // skip lines starting with a #
-                if (line.at(0) == '#' || line == "#") {
-                    continue;
-                }
-
-                // find the position of the comma delimiter
-                size_t commaPos = line.find(',');
-
-                // no comma 
-                if (commaPos == string::npos) {
-                    throw FileException("Exception Caught: Bad Data Line - No Comma Found: " + line);
-                    continue;
-                }
-
-                // extract the keyword and keyword name from the line
-                string keyword = line.substr(0, commaPos);
-                string keywordName = line.substr(commaPos + 1);
-                
-                if (keyword == "System") {
-                    // if already exists dont create
-                    bool duplicate = false;
-                    for (const auto& system : systems) {
-                        if (keywordName == system->getName()) {
-                            duplicate = true;
-                            break;
-                        }
-                    }
-                    if (duplicate) {
-                        continue;
-                    }
-
-                    // create solar system object
-                    shared_ptr<SolarSystem> solarSystem = make_shared<SolarSystem>(keywordName);
-                    
-                    // add to systems vector
-                    systems.push_back(solarSystem);
-                } else if (keyword == "Star") {
-                    // get the name of the star, solarSystem, spectralType, temperature, and solarMass
-                    size_t pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string starName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string solarSystemName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string spectralType = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string temperatureStr = keywordName.substr(0, pos);
-                    double temperature = 0.0;
-                    if (temperatureStr != "") {
-                        temperature = stod(temperatureStr);
-                    }
-                    keywordName.erase(0, pos + 1);
-                    
-                    double solarMass = 0.0;
-                    if (keywordName != "") {
-                        solarMass = stod(keywordName);
-                    }
-
-                    // create star object
-                    shared_ptr<Celestial> star = make_shared<Star>(starName, spectralType, temperature, solarMass);
-
-                    // if already exists dont create
-                    bool duplicate = false;
-                    for (const auto& sys : systems) {
-                        if (sys->getName() == solarSystemName) {
-                            Star tempStar(starName, spectralType, temperature, solarMass);
-                            if (sys->celestialsSearch(tempStar, starName) != -1) {
-                                duplicate = true;
-                                break;
-                            }
-                        }
-                    }
-                    if (duplicate) {
-                        continue;
-                    }
-
-                    // add star to its solar system if it exists, if not create the solar system and add it
-                    bool added = false;
-                    for (const auto& solarsystem : systems) {
-                        if (solarsystem->getName() == solarSystemName) {
-                            solarsystem->insertCelestial(star);
-                            added = true;
-                        }
-                    }
-                    if (!added) {
-                        shared_ptr<SolarSystem> solarSystem = make_shared<SolarSystem>(solarSystemName);
-                        solarSystem->insertCelestial(star);
-                        systems.push_back(solarSystem);
-                    }
-                } else if (keyword == "Planet") {
-                    // get the name of the planet, starName, solarSystem, orbitalPeriod, and radius
-                    size_t pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string planetName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string starName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string solarSystemName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string orbitalPeriodStr = keywordName.substr(0, pos);
-                    double orbitalPeriod = 0.0;
-                    if (orbitalPeriodStr != "") {
-                        orbitalPeriod = stod(orbitalPeriodStr);
-                    }
-                    keywordName.erase(0, pos + 1);
-                    
-                    double radius = 0.0;
-                    if (keywordName != "") {
-                        radius = stod(keywordName);
-                    }
-                    // create planet object
-                    shared_ptr<Celestial> planet = make_shared<Planet>(planetName, orbitalPeriod, radius);
-
-                    // find the solar system
-                    shared_ptr<SolarSystem> solarSystem;
-                    for (const auto& sys : systems) {
-                        if (sys->getName() == solarSystemName) {
-                            solarSystem = sys;
-                            break;
-                        }
-                    }
-
-                    // if the solar system doesn't exist, create it
-                    if (solarSystem == nullptr) {
-                        solarSystem = make_shared<SolarSystem>(solarSystemName);
-                        systems.push_back(solarSystem);
-                    }
-
-                    // find the star
-                    shared_ptr<Celestial> star;
-                    for (const auto& celestial : solarSystem->getCelestialBodies()) {
-                        if (celestial->getName() == starName) {
-                            star = celestial;
-                            break;
-                        }
-                    }
-
-                    // if the star doesn't exist, create it
-                    if (star == nullptr) {
-                        star = make_shared<Star>(starName, "unknown", 0.0, 0.0); // Spectral type, temperature, and solar mass are not specified in the data
-                        solarSystem->insertCelestial(star);
-                    }
-
-                    // add planet to the solar system
-                    solarSystem->insertCelestial(planet);
-                } else if (keyword == "Satellite") {
-                    // get the name of the satellite, planetName, solarSystemName, radius, and the isNaturalStr
-                    size_t pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string satelliteName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string planetName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string solarSystemName = keywordName.substr(0, pos);
-                    keywordName.erase(0, pos + 1);
-                    
-                    pos = keywordName.find(',');
-                    if (pos == string::npos) {
-                        throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
-                        continue;
-                    }
-                    string radiusStr = keywordName.substr(0, pos);
-                    double radius = 0.0;
-                    if (radiusStr != "") {
-                        radius = stod(radiusStr);
-                    }
-                    keywordName.erase(0, pos + 1);
-                    
-                    string isNaturalStr = keywordName;
-                    
-                    // get whether the satellite is natural or not
-                    bool isNatural = false;
-                    if (isNaturalStr == "Yes") {
-                        isNatural = true;
-                    }
-
-                    // find the solar system
-                    shared_ptr<SolarSystem> solarSystem;
-                    for (const auto& sys : systems) {
-                        if (sys->getName() == solarSystemName) {
-                            solarSystem = sys;
-                            break;
-                        }
-                    }
-
-                    // if the solar system doesn't exist, create it
-                    if (solarSystem == nullptr) {
-                        solarSystem = make_shared<SolarSystem>(solarSystemName);
-                        systems.push_back(solarSystem);
-                        isNatural = false;
-                    }
-
-                    // create satellite object
-                    shared_ptr<Celestial> satellite = make_shared<Satellite>(satelliteName, radius, isNatural);
-
-                    // find the planet
-                    shared_ptr<Celestial> planet;
-                    for (const auto& celestial : solarSystem->getCelestialBodies()) {
-                        if (celestial->getName() == planetName) {
-                            planet = celestial;
-                            break;
-                        }
-                    }
-
-                    // if the planet doesn't exist, create it
-                    if (planet == nullptr) {
-                        planet = make_shared<Planet>(planetName, 0.0, 0.0); // Orbital period and radius are not specified in the data
-                        solarSystem->insertCelestial(planet);
-                    }
-
-                    // add satellite to the planet
-                    shared_ptr<Planet> planetPtr = dynamic_pointer_cast<Planet>(planet);
-                    if (planetPtr != nullptr) {
-                        planetPtr->addSat(satellite);
-                    }
-                } else {
-                    // throw exception if the type of Celestial object is invalid
-                    throw FileException("Exception Caught: Bad Data Line - Invalid Celestial Type: " + line);
-                }
-                
-            }
+            loadCelestialObjects(inFile, systems, index);
 
             // close the file
             inFile.close();
@@ -476,7 +398,7 @@ void readCelestialObjectsDataFile(vector<shared_ptr<SolarSystem>> &systems) {
     
 }
 
-void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems) {
+void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
     // get the filename
     string inputFileLocationAndName;
     cout << "Enter the file location and name:"; // structure is 'data/alldata_allconnections.csv'
@@ -484,8 +406,8 @@ void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems) {
     cout << endl << endl;
 
     try {
-        // open the file
-        ifstream inFile;
+        // open the file, plain or compressed
+        DataFileStream inFile;
         inFile.open(inputFileLocationAndName);
 
         // check if file opened correctly
@@ -493,98 +415,8 @@ void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems) {
             // throw FileException if the file couldn't be opened
             throw FileException("Exception Caught: File Not Found - " + inputFileLocationAndName);
         } else {
-            // get data from the file
-            string line; int lineNumber = 0;
-            while (getline(inFile, line)) {
-                lineNumber++;
-
-                // skip blank lines
-                if (line.empty()) {
-                    continue;
-                }
-
-                // skip lines starting with a #
-                if (line.at(0) == '#' || line == "#") {
-                    continue;
-                }
-
-                // get the first word of the line (every character before the comma)
-                size_t pos = line.find(',');
-                if (pos == string::npos) {
-                    // skip line without a comma
-                    continue;
-                }
-                string sourceSolarSystemName = line.substr(0, pos);
-                line.erase(0, pos + 1);
-
-                // create the source solar system object
-                shared_ptr<SolarSystem> sourceSolarSystem = make_shared<SolarSystem>(sourceSolarSystemName);
-
-                // check the source solar system exists in the systems vector
-                int ind = 0; bool found = false;
-                for (const auto& system : systems) {
-                    if (system->getName() == sourceSolarSystemName) {
-                        found = true;
-                        break;
-                    }
-                    ind++;
-                }
-
-                // if search failed skipped line
-                if (!found) {
-                    continue;
-                }
-
-                // add the connections to the collection of the current solar system
-                while (line.find(',') != string::npos) { // a comma exists
-                    //cout << "***Line: " << line << endl;
-                    // loop through line and build connection name
-                    int i = 0; string connection = "";
-                    for (const auto& c : line) {
-                        if (c != ',') {
-                            connection += line.at(i);
-                        } else {
-                            break;
-                        }
-                        i++;
-                    }
-                    //cout << "***Connection: " << connection << endl;
-
-                    // no data there
-                    if (connection == "") {
-                        continue;
-                    }
-                    
-                    // erase that part of the string
-                    line.erase(0, line.find(',') + 1);
-                    if (line == ",") {
-                        line = "";
-                    }
+            loadSolarSystemConnections(inFile, systems, index);
 
-                    // check if connection is in systems vector
-                    int index = 0;
-                    for (const auto& system : systems) {
-                        if (system->getName() == connection) {
-                            // add the connection
-                            systems.at(ind)->addConnection(system);
-                            //cout << "added: " << system->getName() << endl;
-                            break;
-                        }
-                        index++;
-                    }
-                }
-
-                // check if last word (or if line only had two words) is in the systems vector
-                int index = 0;
-                for (const auto& system : systems) {
-                    if (system->getName() == line) {
-                        // add the connection
-                        systems.at(ind)->addConnection(system);
-                        break;
-                    }
-                    index++;
-                }
-            }
             // close the file
             inFile.close();
         }
@@ -597,108 +429,942 @@ void readSolarSystemConnectionFile(vector<shared_ptr<SolarSystem>> &systems) {
     }
 }
 
-void printSystemsCelestialDetails(vector<shared_ptr<SolarSystem>> &systems) {
-    if (systems.empty()) {
-        cout << "No data loaded." << endl;
+void readDeltaFile(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    // get the filename
+    string inputFileLocationAndName;
+    cout << "Enter the delta file location and name:";
+    getline(cin, inputFileLocationAndName);
+    cout << endl << endl;
+
+    DeltaReport report;
+    try {
+        DataFileStream inFile(inputFileLocationAndName);
+        if (!inFile.is_open()) {
+            throw FileException("Exception Caught: File Not Found - " + inputFileLocationAndName);
+        }
+        applyDelta(inFile, systems, index, report);
+    } catch(const FileException& e) {
+        // changes before the bad line stay applied and are reported below
+        cout << e.what() << endl << endl;
+    } catch(const exception& e) {
+        cout << e.what() << endl << endl;
     }
-    // iterate through systems vector
-    for (const auto& solarsystem : systems) {
-        cout << solarsystem->toString() << endl;
+
+    cout << report.toString() << endl;
+}
+
+void planFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, NameIndex &names) {
+    cout << "Activating flight plan plotting system..." << endl;
+    cout << "Only valid solar systems can be added to the plan." << endl << endl;
+    cout << "Type DONE to terminate flight planning." << endl << endl;
+
+    index.sync(systems);
+    if (names.isStale(index)) {
+        names.build(index);
     }
+    flightPath.createPath(systems, names);
 }
 
-void printSystemsConnectionDetails(vector<shared_ptr<SolarSystem>> &systems) {
-    if (systems.empty()) {
-        cout << "No connections loaded." << endl;
+void validateFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems) {
+    if (flightPath.isValid(systems)) {
+        cout << "Path is valid, ready to explore!" << endl;
+    } else {
+        cout << "Invalid path, route not connected." << endl;
     }
-    // iterate through systems vector
-    for (const auto& solarsystem : systems) {
-        cout << solarsystem->getName() << " -> " << solarsystem->connectionsToString() << endl;
+}
+
+void clearSystems(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    for (const auto& system : systems) {
+        system->clearConnections();
     }
+    index.clearConnections();
 }
 
-void printLoadedCelestialStats(vector<shared_ptr<SolarSystem>> &systems) {
-    // Stats for Loaded Data
-    // =====================
-    // Number of Solar Systems: 3
-    // Number of Stars: 4
-    // Number of Planets: 4
-    // Number of Satellites: 1
-    // Minimum Number of Connections: 0
-    // Maximum Number of Connections: 0
-    // Average Number of Connections: 0
-    // Median Number of Connections: 0
+void generateFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string startName, endName;
+    cout << "Starting Solar System: ";
+    getline(cin, startName);
+    cout << endl << "Ending Solar System: ";
+    getline(cin, endName);
+    cout << endl;
 
-    int numSolarSystems = 0, totalNumStars = 0, totalNumPlanets = 0, totalNumSatellites = 0, minNumConnections = 0, maxNumConnections = 0; double avgNumConnections = 0.0, medNumConnections = 0.0;
-    vector<int> cons; int consSize = 0;
-    for (const auto& system : systems) {
-        numSolarSystems++;
-        totalNumStars += system->numStars();
-        totalNumPlanets += system->numPlanets();
-        totalNumSatellites += system->numSatellites();
-        avgNumConnections += system->numConnections();
-        cons.push_back(system->numConnections());
-        consSize++;
-    }
-
-    if (!cons.empty()) {
-        // calculate minimum and maximum number of connections
-        minNumConnections = *min_element(cons.begin(), cons.end());
-        maxNumConnections = *max_element(cons.begin(), cons.end());
-
-        // calculate average number of connections
-        avgNumConnections = avgNumConnections / consSize;
-
-        // calculate median number of connections
-        sort(cons.begin(), cons.end());
-        if (consSize % 2 == 0) {
-            // even number of elements
-            medNumConnections = cons[consSize / 2 - 1] + cons[consSize / 2] / 2.0;
+    index.sync(systems);
+    int start = index.idOf(startName);
+    int end = index.idOf(endName);
+    if (start == -1 || end == -1) {
+        cout << "Invalid system: No path generated." << endl;
+        return;
+    }
+
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
+
+    vector<int> route; RouteStats stats;
+    if (!planner.findRoute(start, end, route, &stats)) {
+        cout << "No route from " << startName << " to " << endName << "." << endl;
+        return;
+    }
+
+    vector<shared_ptr<SolarSystem>> steps;
+    for (int id : route) {
+        steps.push_back(index.at(id));
+    }
+    flightPath.setPath(steps);
+    flightPath.printPath();
+    cout << "Route of " << route.size() - 1 << " hops, " << stats.settled
+        << " systems searched in " << stats.elapsedMs << " ms." << endl;
+}
+
+/// @brief Like generateFlightPath, answered from the contraction
+///        hierarchy, which is rebuilt first when the connections changed.
+void generateFlightPathFast(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, ContractionHierarchy &hierarchy) {
+    string startName, endName;
+    cout << "Starting Solar System: ";
+    getline(cin, startName);
+    cout << endl << "Ending Solar System: ";
+    getline(cin, endName);
+    cout << endl;
+
+    index.sync(systems);
+    int start = index.idOf(startName);
+    int end = index.idOf(endName);
+    if (start == -1 || end == -1) {
+        cout << "Invalid system: No path generated." << endl;
+        return;
+    }
+
+    if (hierarchy.isStale(index)) {
+        hierarchy.build(index);
+        cout << hierarchy.getStats().toString() << endl;
+    }
+
+    vector<int> route; RouteStats stats;
+    if (!hierarchy.findRoute(start, end, route, &stats)) {
+        cout << "No route from " << startName << " to " << endName << "." << endl;
+        return;
+    }
+
+    vector<shared_ptr<SolarSystem>> steps;
+    for (int id : route) {
+        steps.push_back(index.at(id));
+    }
+    flightPath.setPath(steps);
+    flightPath.printPath();
+    cout << "Route of " << route.size() - 1 << " hops, " << stats.settled
+        << " systems searched in " << stats.elapsedMs << " ms." << endl;
+}
+
+/// @brief Set the landmarks guiding generated routes (option 14) and build
+///        their tables now.
+void chooseRouteLandmarks(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string countStr, choiceStr;
+    cout << "Number of landmarks (0 for none): ";
+    getline(cin, countStr);
+    cout << endl << "Pick landmarks by (F)arthest or (D)egree: ";
+    getline(cin, choiceStr);
+    cout << endl;
+
+    int count = 0;
+    try {
+        count = stoi(countStr);
+    } catch(const exception& e) {
+        cout << "Invalid number of landmarks." << endl;
+        return;
+    }
+    bool byDegree = choiceStr == "D" || choiceStr == "d";
+    planner.setLandmarks(count, byDegree ? LandmarkChoice::Degree : LandmarkChoice::Farthest);
+
+    index.sync(systems);
+    auto started = chrono::steady_clock::now();
+    planner.build(index);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    cout << planner.landmarkCount() << " landmarks, " << planner.landmarkBytes() / 1024
+        << " KB of tables, built in " << ms << " ms." << endl;
+}
+
+/// @brief Like generateFlightPath with waypoints to pass in order, systems
+///        to avoid and a hop limit.
+void generateConstrainedFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string startName, endName, via, avoid, maxHops;
+    cout << "Starting Solar System: ";
+    getline(cin, startName);
+    cout << endl << "Ending Solar System: ";
+    getline(cin, endName);
+    cout << endl << "Waypoints in order, comma separated (blank for none): ";
+    getline(cin, via);
+    cout << endl << "Solar Systems to avoid, comma separated (blank for none): ";
+    getline(cin, avoid);
+    cout << endl << "Most hops allowed (blank for no limit): ";
+    getline(cin, maxHops);
+    cout << endl;
+
+    index.sync(systems);
+    int start = index.idOf(startName);
+    int end = index.idOf(endName);
+    RouteConstraints constraints;
+    string problem;
+    if (start == -1 || end == -1) {
+        cout << "Invalid system: No path generated." << endl;
+        return;
+    }
+    if (!readConstraints(via, avoid, maxHops, ',', index, constraints, problem)) {
+        cout << problem << ": No path generated." << endl;
+        return;
+    }
+
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
+
+    vector<int> route; RouteStats stats;
+    if (!planner.findConstrainedRoute(start, end, constraints, route, &stats)) {
+        cout << "No route from " << startName << " to " << endName << " meets the constraints." << endl;
+        return;
+    }
+
+    vector<shared_ptr<SolarSystem>> steps;
+    for (int id : route) {
+        steps.push_back(index.at(id));
+    }
+    flightPath.setPath(steps);
+    flightPath.printPath();
+    cout << "Route of " << route.size() - 1 << " hops, " << stats.settled
+        << " systems searched in " << stats.elapsedMs << " ms." << endl;
+}
+
+/// @brief Turn waypoint and avoid lists of names and a hop limit into
+///        route constraints.
+/// @param separator what separates the names in a list
+/// @param problem set to what was wrong when returning false
+/// @return false for an unknown name or a bad hop limit
+bool readConstraints(const string &via, const string &avoid, const string &maxHops, char separator,
+                     SystemIndex &index, RouteConstraints &constraints, string &problem) {
+    vector<int> avoided;
+    if (!readSystemList(via, separator, index, constraints.waypoints, problem) ||
+        !readSystemList(avoid, separator, index, avoided, problem)) {
+        return false;
+    }
+    for (int id : avoided) {
+        constraints.avoid.insert(id);
+    }
+    if (!maxHops.empty()) {
+        try {
+            constraints.maxHops = stoi(maxHops);
+        } catch(const exception& e) {
+            constraints.maxHops = -1;
+        }
+        if (constraints.maxHops < 0) {
+            problem = "Invalid hop limit " + maxHops;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Append the id of each name in a list to ids.
+/// @param problem set to the first unknown name when returning false
+bool readSystemList(const string &names, char separator, SystemIndex &index, vector<int> &ids, string &problem) {
+    stringstream list(names);
+    string name;
+    while (getline(list, name, separator)) {
+        if (name.empty()) {
+            continue;
+        }
+        int id = index.idOf(name);
+        if (id == -1) {
+            problem = "Unknown Solar System " + name;
+            return false;
+        }
+        ids.push_back(id);
+    }
+    return true;
+}
+
+/// @return the names along a route joined by arrows
+string describeRoute(const vector<int> &route, SystemIndex &index) {
+    string text;
+    for (size_t i = 0; i < route.size(); i++) {
+        text += (i == 0 ? "" : " -> ") + index.at(route[i])->getName();
+    }
+    return text;
+}
+
+/// @brief Load the given files, then answer each line of a batch file:
+///          start,end[,via=A|B][,avoid=C|D][,maxhops=N]
+///        Blank lines and lines starting with # are skipped. Each answer
+///        goes to standard output as the request, then "=>" and either the
+///        hop count and route, "no route" or what was wrong with the line.
+/// @return the process exit status, 1 when the files could not be read
+int runBatchRoutes(const string &batchFile, const string &celestialFile, const string &connectionFile) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    if ((!celestialFile.empty() && !loadFileNamed(celestialFile, LoadKind::Celestial, systems, index)) ||
+        (!connectionFile.empty() && !loadFileNamed(connectionFile, LoadKind::Connections, systems, index))) {
+        return 1;
+    }
+    ifstream requests(batchFile);
+    if (!requests.is_open()) {
+        cout << "Exception Caught: File Not Found - " << batchFile << endl;
+        return 1;
+    }
+
+    // many requests pay back the landmark tables
+    RoutePlanner planner;
+    planner.setLandmarks(16);
+    index.sync(systems);
+    planner.build(index);
+
+    string line;
+    long answered = 0, routed = 0;
+    double totalMs = 0.0;
+    while (getline(requests, line)) {
+        if (line.empty() || line.at(0) == '#') {
+            continue;
+        }
+        stringstream fields(line);
+        string startName, endName, field, via, avoid, maxHops, problem;
+        getline(fields, startName, ',');
+        getline(fields, endName, ',');
+        while (getline(fields, field, ',')) {
+            size_t equals = field.find('=');
+            string key = field.substr(0, equals);
+            string value = equals == string::npos ? "" : field.substr(equals + 1);
+            if (key == "via") {
+                via = value;
+            } else if (key == "avoid") {
+                avoid = value;
+            } else if (key == "maxhops") {
+                maxHops = value;
+            } else {
+                problem = "Unknown constraint " + key;
+            }
+        }
+
+        RouteConstraints constraints;
+        int start = index.idOf(startName);
+        int end = index.idOf(endName);
+        if (problem.empty() && (start == -1 || end == -1)) {
+            problem = "Unknown Solar System " + (start == -1 ? startName : endName);
+        }
+        if (problem.empty()) {
+            readConstraints(via, avoid, maxHops, '|', index, constraints, problem);
+        }
+
+        cout << line << " => ";
+        answered++;
+        if (!problem.empty()) {
+            cout << problem << endl;
+            continue;
+        }
+        vector<int> route; RouteStats stats;
+        if (planner.findConstrainedRoute(start, end, constraints, route, &stats)) {
+            cout << route.size() - 1 << " hops: " << describeRoute(route, index) << endl;
+            routed++;
         } else {
-            // odd number of elements
-            medNumConnections = cons[consSize / 2.0];
+            cout << "no route" << endl;
         }
-    } else {
-        // no connections found
-        minNumConnections = 0;
-        maxNumConnections = 0;
-        avgNumConnections = 0;
-        medNumConnections = 0;
+        totalMs += stats.elapsedMs;
+    }
+    cout << answered << " requests, " << routed << " routed, " << totalMs << " ms searching." << endl;
+    return 0;
+}
+
+/// @brief Plan a round trip from an origin through a list of systems in
+///        whatever order is shortest, and make it the flight path.
+void planItinerary(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string originName, visits, problem;
+    cout << "Origin Solar System: ";
+    getline(cin, originName);
+    cout << endl << "Solar Systems to visit, comma separated: ";
+    getline(cin, visits);
+    cout << endl;
+
+    index.sync(systems);
+    vector<int> stops;
+    if (!readSystemList(originName, ',', index, stops, problem) || stops.size() != 1 ||
+        !readSystemList(visits, ',', index, stops, problem)) {
+        cout << (problem.empty() ? "Invalid system" : problem) << ": No path generated." << endl;
+        return;
     }
 
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
 
+    ItineraryPlanner itineraries(planner);
+    Itinerary itinerary;
+    ItineraryStats stats;
+    if (!itineraries.plan(stops, itinerary, &stats)) {
+        cout << "No round trip visits every system, some cannot be reached from the others." << endl;
+        return;
+    }
 
-    cout << "Stats for Loaded Data" << endl;
-    cout << "=====================" << endl;
-    cout << "Number of Solar Systems: " << numSolarSystems << endl;
-    cout << "Number of Stars: " << totalNumStars << endl;
-    cout << "Number of Planets: " << totalNumPlanets << endl;
-    cout << "Number of Satellites: " << totalNumSatellites << endl;
-    cout << "Minimum Number of Connections: " << minNumConnections << endl;
-    cout << "Maximum Number of Connections: " << maxNumConnections << endl;
-    cout << "Average Number of Connections: " << avgNumConnections << endl;
-    cout << "Median Number of Connections: " << medNumConnections << endl;
+    vector<shared_ptr<SolarSystem>> steps;
+    for (int id : itinerary.route) {
+        steps.push_back(index.at(id));
+    }
+    flightPath.setPath(steps);
+    cout << "Visiting order: " << describeRoute(itinerary.order, index) << " -> " << originName << endl;
+    flightPath.printPath();
+    cout << "Round trip of " << itinerary.hops << " hops. " << stats.toString() << endl;
 }
 
-void planFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems) {
-    cout << "Activating flight plan plotting system..." << endl;
-    cout << "Only valid solar systems can be added to the plan." << endl << endl;
-    cout << "Type DONE to terminate flight planning." << endl << endl;
+/// @brief Find the route arriving soonest for a departure day, with
+///        transfers timed by each system's reference planet, and compare
+///        it with the route of fewest hops flown on the same day.
+void generateEarliestArrival(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                             OrbitalRouter &router, RoutePlanner &planner) {
+    string startName, endName, dayText;
+    cout << "Starting Solar System: ";
+    getline(cin, startName);
+    cout << endl << "Ending Solar System: ";
+    getline(cin, endName);
+    cout << endl << "Departure day: ";
+    getline(cin, dayText);
+    cout << endl;
+
+    index.sync(systems);
+    int start = index.idOf(startName);
+    int end = index.idOf(endName);
+    if (start == -1 || end == -1) {
+        cout << "Invalid system: No path generated." << endl;
+        return;
+    }
+    double departDay = 0.0;
+    try {
+        departDay = stod(dayText);
+    } catch(const exception& e) {
+        cout << "Invalid departure day " << dayText << ": No path generated." << endl;
+        return;
+    }
+
+    if (router.isStale(index)) {
+        router.build(index);
+    }
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
+
+    vector<int> route; RouteStats stats;
+    double arriveDay = 0.0;
+    if (!router.findEarliestArrival(start, end, departDay, route, arriveDay, &stats)) {
+        cout << "No path from " << startName << " to " << endName << "." << endl;
+        return;
+    }
 
-    flightPath.createPath(systems);
+    vector<shared_ptr<SolarSystem>> steps;
+    for (int id : route) {
+        steps.push_back(index.at(id));
+    }
+    flightPath.setPath(steps);
+    flightPath.printPath();
+    cout << "Leaving on day " << departDay << ", " << route.size() - 1 << " hops arriving on day "
+        << arriveDay << " (" << arriveDay - departDay << " days); " << stats.settled
+        << " systems searched in " << stats.elapsedMs << " ms." << endl;
+
+    vector<int> fewest;
+    if (planner.findRoute(start, end, fewest)) {
+        cout << "The fewest hop route, " << fewest.size() - 1 << " hops, would arrive on day "
+            << router.followRoute(fewest, departDay) << "." << endl;
+    }
 }
 
-void validateFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems) {
-    if (flightPath.isValid(systems)) {
-        cout << "Path is valid, ready to explore!" << endl;
-    } else {
-        cout << "Invalid path, route not connected." << endl;
+/// @brief Like generateFlightPath for a ship that must refuel within its
+///        range, at systems with a suitable star or artificial satellite.
+void generateRangedFlightPath(FlightPath &flightPath, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string startName, endName, rangeText, classes, satellites;
+    cout << "Starting Solar System: ";
+    getline(cin, startName);
+    cout << endl << "Ending Solar System: ";
+    getline(cin, endName);
+    cout << endl << "Range between refuels: ";
+    getline(cin, rangeText);
+    cout << endl << "Star classes to refuel at (blank for FGK): ";
+    getline(cin, classes);
+    cout << endl << "Refuel at artificial satellites (Y/N): ";
+    getline(cin, satellites);
+    cout << endl;
+
+    index.sync(systems);
+    int start = index.idOf(startName);
+    int end = index.idOf(endName);
+    if (start == -1 || end == -1) {
+        cout << "Invalid system: No path generated." << endl;
+        return;
     }
+    double range = -1.0;
+    try {
+        range = stod(rangeText);
+    } catch(const exception& e) {
+        range = -1.0;
+    }
+    if (range < 0.0) {
+        cout << "Invalid range " << rangeText << ": No path generated." << endl;
+        return;
+    }
+
+    RefuelPolicy policy;
+    if (!classes.empty()) {
+        policy.starClasses = classes;
+    }
+    policy.artificialSatellites = satellites != "N" && satellites != "n";
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
+    SystemSet refuel = findRefuelSystems(index, policy);
+
+    vector<int> route; RouteStats stats;
+    if (!planner.findRangedRoute(start, end, range, refuel, route, &stats)) {
+        cout << "No route from " << startName << " to " << endName << " stays within range; "
+            << refuel.count() << " of " << index.size() << " systems can refuel." << endl;
+        return;
+    }
+
+    vector<shared_ptr<SolarSystem>> steps;
+    vector<string> stops;
+    for (size_t i = 0; i < route.size(); i++) {
+        steps.push_back(index.at(route[i]));
+        if (i > 0 && i + 1 < route.size() && refuel.contains(route[i])) {
+            stops.push_back(index.at(route[i])->getName());
+        }
+    }
+    flightPath.setPath(steps);
+    flightPath.printPath();
+    cout << "Route of " << route.size() - 1 << " hops refuelling at " << stops.size() << " systems";
+    for (size_t i = 0; i < stops.size(); i++) {
+        cout << (i == 0 ? ": " : ", ") << stops[i];
+    }
+    cout << "." << endl << stats.settled << " labels searched in " << stats.elapsedMs << " ms"
+        << (planner.usesHeuristic() ? "" : ", range counted in jumps") << "." << endl;
 }
 
-void clearSystems(vector<shared_ptr<SolarSystem>> &systems) {
-    for (const auto& system : systems) {
-        system->clearConnections();
+/// @brief Count the systems within some jumps of one or more origins, ring
+///        by ring, and optionally write every one to a file as hops,name
+///        lines, each ring written as soon as it is found.
+void printReachableRings(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string originNames, jumpText, fileName, problem;
+    cout << "Origin Solar Systems, comma separated: ";
+    getline(cin, originNames);
+    cout << endl << "Most jumps: ";
+    getline(cin, jumpText);
+    cout << endl << "File to write the systems to (blank for counts only): ";
+    getline(cin, fileName);
+    cout << endl;
+
+    index.sync(systems);
+    vector<int> origins;
+    if (!readSystemList(originNames, ',', index, origins, problem) || origins.empty()) {
+        cout << (problem.empty() ? "No origin given" : problem) << "." << endl;
+        return;
+    }
+    int maxHops = -1;
+    try {
+        maxHops = stoi(jumpText);
+    } catch(const exception& e) {
+        maxHops = -1;
+    }
+    if (maxHops < 0) {
+        cout << "Invalid number of jumps " << jumpText << "." << endl;
+        return;
+    }
+    ofstream outFile;
+    if (!fileName.empty()) {
+        outFile.open(fileName);
+        if (!outFile.is_open()) {
+            cout << "Exception Caught: Unable to write - " << fileName << endl;
+            return;
+        }
+        outFile << "Hops,System" << "\n";
+    }
+
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
+    auto started = chrono::steady_clock::now();
+    long reached = planner.findReachable(origins, maxHops, [&](int hops, const vector<int> &ring) {
+        cout << "Ring " << hops << ": " << ring.size() << " systems" << endl;
+        if (outFile.is_open()) {
+            for (int id : ring) {
+                outFile << hops << "," << index.at(id)->getName() << "\n";
+            }
+        }
+    });
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    cout << reached << " systems within " << maxHops << " jumps, found in " << ms << " ms";
+    if (outFile.is_open()) {
+        cout << " and written to " << fileName;
+    }
+    cout << "." << endl;
+}
+
+/// @brief Rank the systems by betweenness and PageRank, next to their
+///        connection counts, after a summary of the connected components.
+void printHubSystems(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, RoutePlanner &planner) {
+    string countText, sampleText;
+    cout << "How many systems to list: ";
+    getline(cin, countText);
+    cout << endl << "Betweenness sample sources (blank for exact): ";
+    getline(cin, sampleText);
+    cout << endl;
+
+    int count = 0, samples = 0;
+    try {
+        count = stoi(countText);
+        samples = sampleText.empty() ? 0 : stoi(sampleText);
+    } catch(const exception& e) {
+        count = -1;
+    }
+    if (count <= 0 || samples < 0) {
+        cout << "Invalid number: No ranking made." << endl;
+        return;
+    }
+
+    index.sync(systems);
+    if (planner.isStale(index)) {
+        planner.build(index);
+    }
+    GraphAnalytics analytics(planner);
+
+    auto started = chrono::steady_clock::now();
+    vector<int> sizes;
+    analytics.components(sizes);
+    cout << sizes.size() << " connected components, the largest with";
+    for (size_t i = 0; i < sizes.size() && i < 5; i++) {
+        cout << (i == 0 ? " " : ", ") << sizes[i];
+    }
+    cout << " systems." << endl << endl;
+
+    int iterations = 0;
+    vector<double> ranks = analytics.pageRank(0.85, 1e-9, 100, &iterations);
+    vector<double> between = analytics.betweenness(samples);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+
+    cout << "Betweenness" << (samples > 0 && samples < planner.size() ? " (estimated)" : "") << ":" << endl;
+    for (const auto &[id, score] : GraphAnalytics::topN(between, count)) {
+        cout << "  " << index.at(id)->getName() << ": " << score << ", "
+            << index.at(id)->numConnections() << " connections" << endl;
+    }
+    cout << endl << "PageRank after " << iterations << " iterations:" << endl;
+    for (const auto &[id, score] : GraphAnalytics::topN(ranks, count)) {
+        cout << "  " << index.at(id)->getName() << ": " << score << ", "
+            << index.at(id)->numConnections() << " connections" << endl;
+    }
+    cout << endl << "Ranked " << planner.size() << " systems in " << ms << " ms." << endl;
+}
+
+void printNearestSystems(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, SpatialIndex &spatial) {
+    string name, countStr;
+    cout << "Name of a Solar System: ";
+    getline(cin, name);
+    cout << endl << "Number of nearest systems: ";
+    getline(cin, countStr);
+    cout << endl;
+
+    index.sync(systems);
+    shared_ptr<SolarSystem> origin = index.find(name);
+    if (origin == nullptr || !origin->hasPosition()) {
+        cout << "Invalid system: No position known for " << name << "." << endl;
+        return;
+    }
+
+    try {
+        int count = stoi(countStr);
+        if (spatial.isStale(index)) {
+            spatial.build(index);
+        }
+
+        // the origin is its own nearest system, so ask for one more
+        int originId = index.idOf(name);
+        for (const auto &[id, distance] : spatial.nearest(origin->getX(), origin->getY(), origin->getZ(), count + 1)) {
+            if (id != originId) {
+                cout << index.at(id)->getName() << " (" << distance << ")" << endl;
+            }
+        }
+    } catch(const exception& e) {
+        cout << e.what() << endl;
+    }
+}
+
+void printSystemsInRadius(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, SpatialIndex &spatial) {
+    string name, radiusStr;
+    cout << "Name of a Solar System: ";
+    getline(cin, name);
+    cout << endl << "Radius: ";
+    getline(cin, radiusStr);
+    cout << endl;
+
+    index.sync(systems);
+    shared_ptr<SolarSystem> origin = index.find(name);
+    if (origin == nullptr || !origin->hasPosition()) {
+        cout << "Invalid system: No position known for " << name << "." << endl;
+        return;
+    }
+
+    try {
+        double radius = stod(radiusStr);
+        if (spatial.isStale(index)) {
+            spatial.build(index);
+        }
+
+        int originId = index.idOf(name);
+        for (const auto &[id, distance] : spatial.withinRadius(origin->getX(), origin->getY(), origin->getZ(), radius)) {
+            if (id != originId) {
+                cout << index.at(id)->getName() << " (" << distance << ")" << endl;
+            }
+        }
+    } catch(const exception& e) {
+        cout << e.what() << endl;
+    }
+}
+
+void printPrefixMatches(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, NameIndex &names) {
+    string prefix;
+    cout << "Name prefix: ";
+    getline(cin, prefix);
+    cout << endl;
+
+    index.sync(systems);
+    if (names.isStale(index)) {
+        names.build(index);
+    }
+
+    size_t total = 0;
+    for (const auto &match : names.withPrefix(prefix, 25, &total)) {
+        cout << match.name << " (" << nameKindToString(match.kind);
+        if (match.kind != NameKind::System) {
+            cout << " in " << index.at(match.systemId)->getName();
+        }
+        cout << ")" << endl;
+    }
+    cout << total << " names start with \"" << prefix << "\"." << endl;
+}
+
+void runCatalogQuery(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, QueryEngine &queries) {
+    string query;
+    cout << "Query (e.g. star type=G* mass>1.2): ";
+    getline(cin, query);
+    cout << endl;
+
+    index.sync(systems);
+    if (queries.isStale(index)) {
+        queries.build(index);
+    }
+
+    try {
+        QueryResult result = queries.run(query);
+
+        // show the first line of the first few matches
+        size_t shown = 0;
+        for (int row : result.rows) {
+            if (shown++ == 25) {
+                cout << "..." << endl;
+                break;
+            }
+            string details = queries.bodyAt(result.type, row)->toString();
+            cout << details.substr(0, details.find('\n')) << " in "
+                << index.at(queries.systemAt(result.type, row))->getName() << endl;
+        }
+        cout << result.rows.size() << " bodies in " << result.systemIds.size() << " systems ("
+            << result.candidates << " candidates, " << result.elapsedMs << " ms)." << endl;
+    } catch(const exception& e) {
+        cout << e.what() << endl;
+    }
+}
+
+void shrinkLoadedData(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    index.sync(systems);
+    size_t before = measureMemory(systems, index).total();
+    shrinkMemory(systems, index);
+    size_t after = measureMemory(systems, index).total();
+    cout << "Loaded data shrunk from " << before << " to " << after << " bytes." << endl;
+}
+
+void readCelestialObjectsDataFileLazily(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index, LazyCatalog &lazy, size_t lazyCache) {
+    // get the filename
+    string inputFileLocationAndName;
+    cout << "Enter the file location and name:"; // structure is 'data/alldata.csv'
+    getline(cin, inputFileLocationAndName);
+    cout << endl << endl;
+
+    try {
+        lazy.open(inputFileLocationAndName, systems, index, lazyCache);
+        cout << index.size() << " systems indexed in " << lazy.getStats().indexMs
+            << " ms, bodies load on demand (" << lazyCache << " systems resident at most)." << endl;
+    } catch(const exception& e) {
+        cout << e.what() << endl << endl;
+    }
+}
+
+void startBackgroundLoad(BackgroundLoader &loader, LoadKind kind, vector<shared_ptr<SolarSystem>> &systems) {
+    // get the filename
+    string inputFileLocationAndName;
+    cout << "Enter the file location and name:"; // structure is 'data/alldata.csv'
+    getline(cin, inputFileLocationAndName);
+    cout << endl << endl;
+
+    try {
+        loader.start(kind, inputFileLocationAndName, systems);
+        cout << "Loading in the background, option 27 shows progress." << endl;
+    } catch(const exception& e) {
+        cout << e.what() << endl << endl;
+    }
+}
+
+void commitBackgroundLoad(BackgroundLoader &loader, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    string message;
+    if (loader.commit(systems, index, message)) {
+        cout << message << endl << endl;
+    }
+}
+
+/// @brief options that load, clear or replace systems, which must wait for
+///        a background load so its names and ids still match when it commits
+bool changesSystems(const string &option) {
+    return option == "1" || option == "2" || option == "12" || option == "13" ||
+           option == "16" || option == "24" || option == "25" || option == "26" ||
+           option == "29" || option == "30";
+}
+
+/// @brief read every body still waiting after a lazy load
+/// @return false when the data file had a bad line
+bool loadAllLazyBodies(LazyCatalog &lazy) {
+    try {
+        lazy.materializeAll();
+        return true;
+    } catch(const exception& e) {
+        cout << e.what() << endl << endl;
+        return false;
+    }
+}
+
+void printLazyCelestials(vector<shared_ptr<SolarSystem>> &systems, LazyCatalog &lazy, bool statsOnly) {
+    LazyCatalog *bodies = lazy.isActive() ? &lazy : nullptr;
+    try {
+        if (statsOnly) {
+            printLoadedCelestialStats(systems, cout, bodies);
+        } else {
+            printSystemsCelestialDetails(systems, cout, bodies);
+        }
+    } catch(const exception& e) {
+        cout << e.what() << endl << endl;
+    }
+}
+
+void printPathCelestials(FlightPath &flightPath, SystemIndex &index, LazyCatalog &lazy) {
+    try {
+        if (lazy.isActive()) {
+            vector<int> ids;
+            for (const auto &step : flightPath.getPath()) {
+                ids.push_back(index.idOf(step->getName()));
+            }
+            lazy.ensureLoaded(ids);
+        }
+        flightPath.printPathCelestials();
+    } catch(const exception& e) {
+        cout << e.what() << endl << endl;
+    }
+}
+
+/// @brief Load a celestial or connection file given on the command line.
+/// @return false when the file could not be read
+bool loadFileNamed(const string &fileName, LoadKind kind, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    try {
+        DataFileStream inFile(fileName);
+        if (!inFile.is_open()) {
+            throw FileException("Exception Caught: File Not Found - " + fileName);
+        }
+        if (kind == LoadKind::Celestial) {
+            loadCelestialObjects(inFile, systems, index);
+        } else {
+            loadSolarSystemConnections(inFile, systems, index);
+        }
+    } catch(const exception& e) {
+        cout << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+/// @brief Load a celestial or connection file past its bad lines, then
+///        list them. When asked for all or nothing, a file with any bad
+///        line changes nothing.
+void readDataFileTolerantly(LoadKind kind, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    string fileName, answer;
+    cout << "Enter the file location and name:";
+    getline(cin, fileName);
+    cout << endl << "Apply only if every line is good (Y/N): ";
+    getline(cin, answer);
+    cout << endl << endl;
+
+    LoadOptions options;
+    options.transactional = answer == "Y" || answer == "y";
+    LoadReport report;
+    try {
+        DataFileStream inFile(fileName);
+        if (!inFile.is_open()) {
+            throw FileException("Exception Caught: File Not Found - " + fileName);
+        }
+        if (kind == LoadKind::Celestial) {
+            loadCelestialObjects(inFile, systems, index, options, report);
+        } else {
+            loadSolarSystemConnections(inFile, systems, index, options, report);
+        }
+    } catch(const exception& e) {
+        cout << e.what() << endl;
+        return;
+    }
+    cout << report.toString() << endl;
+}
+
+/// @brief Load the given files once, publish them and answer queries on a
+///        Unix domain socket until interrupted.
+/// @return the process exit status
+int serveQueries(const string &socketPath, const string &celestialFile, const string &connectionFile, int workers) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    if ((!celestialFile.empty() && !loadFileNamed(celestialFile, LoadKind::Celestial, systems, index)) ||
+        (!connectionFile.empty() && !loadFileNamed(connectionFile, LoadKind::Connections, systems, index))) {
+        return 1;
+    }
+
+    SnapshotPublisher publisher;
+    publisher.publish(systems, index);
+    QueryServer server(publisher, workers);
+    activeServer.store(&server);
+    signal(SIGINT, stopServing);
+    signal(SIGTERM, stopServing);
+
+    cout << "Serving " << index.size() << " Solar Systems on " << socketPath << " with "
+        << workers << " workers. Interrupt to stop." << endl;
+    int status = 0;
+    try {
+        server.run(socketPath);
+    } catch(const exception& e) {
+        cout << e.what() << endl;
+        status = 1;
+    }
+    // restore the default handlers first, so a late signal never sees the
+    // server once it is cleared
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    activeServer.store(nullptr);
+    if (status != 0) {
+        return status;
+    }
+
+    cout << server.getStats().toString() << endl;
+    if (isProfiling()) {
+        profileReport(cout);
+    }
+    return 0;
+}
+
+/// @brief SIGINT and SIGTERM handler of the query server
+void stopServing(int) {
+    QueryServer *server = activeServer.load();
+    if (server != nullptr) {
+        server->stop();
     }
 }
 
@@ -0,0 +1,372 @@
+/// @file itineraryplanner.cpp
+/// @brief Implementations for planning round trips through many systems.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "routeplanner.h"
+#include "profiler.h"
+#include "workerpool.h"
+#include "itineraryplanner.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @return milliseconds since a time point
+static double msSince(chrono::steady_clock::time_point started) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+}
+
+/// @brief One pass of 2-opt: reverse tour[i..j] whenever that shortens
+///        the trip. Reversing turns the segment around, so its hops are
+///        taken from prefix sums in both directions.
+/// @return number of reversals made
+static long twoOptPass(const vector<int> &matrix, int n, vector<int> &tour) {
+    auto hops = [&](int a, int b) { return static_cast<long>(matrix[a * n + b]); };
+    auto at = [&](int k) { return tour[k % n]; };
+    vector<long> forward(n + 1, 0), backward(n + 1, 0);
+    auto sum = [&]() {
+        for (int k = 0; k < n; k++) {
+            forward[k + 1] = forward[k] + hops(at(k), at(k + 1));
+            backward[k + 1] = backward[k] + hops(at(k + 1), at(k));
+        }
+    };
+    sum();
+
+    long moves = 0;
+    for (int i = 1; i < n - 1; i++) {
+        for (int j = i + 1; j < n; j++) {
+            int before = at(i - 1), after = at(j + 1);
+            long change = hops(before, at(j)) + (backward[j] - backward[i]) + hops(at(i), after)
+                        - hops(before, at(i)) - (forward[j] - forward[i]) - hops(at(j), after);
+            if (change < 0) {
+                reverse(tour.begin() + i, tour.begin() + j + 1);
+                sum();
+                moves++;
+            }
+        }
+    }
+    return moves;
+}
+
+/// @brief One pass of Or-opt: move runs of one to three stops, in their
+///        own order, to wherever that shortens the trip.
+/// @return number of moves made
+static long orOptPass(const vector<int> &matrix, int n, vector<int> &tour) {
+    auto hops = [&](int a, int b) { return static_cast<long>(matrix[a * n + b]); };
+    auto at = [&](int k) { return tour[k % n]; };
+
+    long moves = 0;
+    for (int length = 1; length <= 3; length++) {
+        for (int i = 1; i + length <= n; i++) {
+            int last = i + length - 1;
+            int before = at(i - 1), after = at(last + 1);
+            long saved = hops(before, at(i)) + hops(at(last), after) - hops(before, after);
+            for (int p = 0; p < n; p++) {
+                if (p >= i - 1 && p <= last) {
+                    continue;
+                }
+                long added = hops(at(p), at(i)) + hops(at(last), at(p + 1)) - hops(at(p), at(p + 1));
+                if (added < saved) {
+                    vector<int> run(tour.begin() + i, tour.begin() + last + 1);
+                    tour.erase(tour.begin() + i, tour.begin() + last + 1);
+                    int to = p < i ? p + 1 : p + 1 - length;
+                    tour.insert(tour.begin() + to, run.begin(), run.end());
+                    moves++;
+                    break;
+                }
+            }
+        }
+    }
+    return moves;
+}
+
+
+/// @return one line summary
+string ItineraryStats::toString() const {
+    ostringstream out;
+    out << fixed << setprecision(2) << this->stops << " stops, ";
+    if (this->exact) {
+        out << "exact order";
+    } else {
+        out << "nearest neighbour trip of " << this->firstHops << " hops improved by "
+            << this->improvements << " moves";
+    }
+    out << ". Hop matrix " << this->matrixMs << " ms (" << this->settled << " systems reached), order "
+        << this->orderMs << " ms, route " << this->expandMs << " ms.";
+    return out.str();
+}
+
+/// @param planner a built planner, searched by every worker
+ItineraryPlanner::ItineraryPlanner(const RoutePlanner &planner) : planner(planner) {}
+
+/// @brief Use this many threads, 0 for one per hardware thread.
+void ItineraryPlanner::setWorkers(int workers) {
+    this->workers = max(0, workers);
+}
+
+/// @brief Solve the order exactly up to this many stops. The table grows
+///        as 2^stops, so the limit is held to 0..kMaxExact.
+void ItineraryPlanner::setExactLimit(int stops) {
+    this->exactLimit = max(0, min(stops, kMaxExact));
+}
+
+/// @brief Find a short round trip through every stop. The order is exact
+///        up to the exact limit and a local optimum beyond it; each leg is
+///        then expanded into a fewest hop route.
+/// @param stops system ids, the first being the origin; repeats are
+///        visited once
+/// @param itinerary filled with the order and the expanded route
+/// @param stats optional work counters and timings
+/// @return false for an unknown id, or when no order was found in which
+///         each stop can reach the next
+bool ItineraryPlanner::plan(const vector<int> &stops, Itinerary &itinerary, ItineraryStats *stats) const {
+    PROFILE_SCOPE("itinerary.plan");
+    itinerary = Itinerary();
+    ItineraryStats local;
+    ItineraryStats &work = stats != nullptr ? *stats : local;
+    work = ItineraryStats();
+
+    vector<int> distinct;
+    SystemSet seen;
+    for (int id : stops) {
+        if (id < 0 || id >= this->planner.size()) {
+            return false;
+        }
+        if (!seen.contains(id)) {
+            seen.insert(id);
+            distinct.push_back(id);
+        }
+    }
+    int n = distinct.size();
+    work.stops = n;
+    if (n == 0) {
+        return false;
+    }
+
+    auto started = chrono::steady_clock::now();
+    vector<int> matrix = this->hopMatrix(distinct, &work.settled);
+    work.matrixMs = msSince(started);
+
+    started = chrono::steady_clock::now();
+    vector<int> tour;
+    work.exact = n <= this->exactLimit;
+    if (work.exact) {
+        tour = this->solveExact(matrix, n);
+    } else {
+        tour = this->solveHeuristic(matrix, n, &work.firstHops, &work.improvements);
+    }
+    work.orderMs = msSince(started);
+    if (tripHops(matrix, n, tour) >= kNoRoute) {
+        return false;
+    }
+
+    // expand every leg, the last one back to the origin
+    started = chrono::steady_clock::now();
+    for (int position : tour) {
+        itinerary.order.push_back(distinct[position]);
+    }
+    int legs = n > 1 ? n : 0;
+    int count = workerCount(this->workers, legs);
+    vector<RouteScratch> scratch(count);
+    vector<vector<int>> legRoutes(legs);
+    runJobs(legs, count, [&](int worker, int leg) {
+        this->planner.findRoute(itinerary.order[leg], itinerary.order[(leg + 1) % n], legRoutes[leg], scratch[worker]);
+    });
+    itinerary.route.push_back(itinerary.order.front());
+    for (const vector<int> &legRoute : legRoutes) {
+        itinerary.route.insert(itinerary.route.end(), legRoute.begin() + 1, legRoute.end());
+    }
+    itinerary.hops = itinerary.route.size() - 1;
+    work.expandMs = msSince(started);
+    return true;
+}
+
+/// @brief One breadth first search from each stop, stopping once every
+///        stop has been reached. Searches run on the worker threads.
+/// @return hops from stop i to stop j at [i * n + j], kNoRoute when there
+///         is no route
+/// @param settled optional count of systems the searches reached
+vector<int> ItineraryPlanner::hopMatrix(const vector<int> &stops, long *settled) const {
+    PROFILE_SCOPE("itinerary.matrix");
+    int n = stops.size();
+    int systems = this->planner.size();
+    vector<int> matrix(static_cast<size_t>(n) * n, kNoRoute);
+    vector<int> vertices(n);
+    SystemSet isStop;
+    for (int i = 0; i < n; i++) {
+        vertices[i] = this->planner.vertexOf(stops[i]);
+        isStop.insert(vertices[i]);
+    }
+    int distinct = isStop.count();
+
+    int count = workerCount(this->workers, n);
+    vector<vector<int>> hops(count, vector<int>(systems, -1));
+    vector<vector<int>> queues(count);
+    vector<long> reached(count, 0);
+    runJobs(n, count, [&](int worker, int row) {
+        vector<int> &hopsTo = hops[worker];
+        vector<int> &queue = queues[worker];
+        queue.clear();
+        queue.push_back(vertices[row]);
+        hopsTo[vertices[row]] = 0;
+        int found = 1;
+        for (size_t head = 0; head < queue.size() && found < distinct; head++) {
+            int from = queue[head];
+            auto next = this->planner.neighbors(from);
+            for (const int *to = next.first; to != next.second; to++) {
+                if (hopsTo[*to] == -1) {
+                    hopsTo[*to] = hopsTo[from] + 1;
+                    queue.push_back(*to);
+                    found += isStop.contains(*to);
+                }
+            }
+        }
+        for (int column = 0; column < n; column++) {
+            if (hopsTo[vertices[column]] != -1) {
+                matrix[static_cast<size_t>(row) * n + column] = hopsTo[vertices[column]];
+            }
+        }
+        // put back only what this search touched
+        for (int id : queue) {
+            hopsTo[id] = -1;
+        }
+        reached[worker] += queue.size();
+    });
+
+    if (settled != nullptr) {
+        *settled = 0;
+        for (long part : reached) {
+            *settled += part;
+        }
+    }
+    return matrix;
+}
+
+/// @brief Held-Karp: the shortest trip from position 0 through each subset
+///        of the other stops, ending at each of them, built up from
+///        smaller subsets. O(2^n n^2) time and O(2^n n) space.
+/// @return positions 0..n-1 in the order of the shortest round trip
+vector<int> ItineraryPlanner::solveExact(const vector<int> &matrix, int n) const {
+    PROFILE_SCOPE("itinerary.exact");
+    if (n > kMaxExact) {
+        throw invalid_argument("solveExact takes at most " + to_string(kMaxExact) + " stops, not " + to_string(n) + ".");
+    }
+    if (n <= 2) {
+        vector<int> tour(n);
+        for (int i = 0; i < n; i++) {
+            tour[i] = i;
+        }
+        return tour;
+    }
+
+    // subsets of stops 1..n-1 as bits 0..others-1
+    int others = n - 1;
+    size_t subsets = size_t(1) << others;
+    vector<long> best(subsets * others, LONG_MAX);
+    vector<signed char> previous(subsets * others, -1);
+    for (int j = 0; j < others; j++) {
+        best[(size_t(1) << j) * others + j] = matrix[j + 1];
+    }
+    for (size_t subset = 1; subset < subsets; subset++) {
+        for (int j = 0; j < others; j++) {
+            long sofar = best[subset * others + j];
+            if (!(subset >> j & 1) || sofar == LONG_MAX) {
+                continue;
+            }
+            for (int k = 0; k < others; k++) {
+                if (subset >> k & 1) {
+                    continue;
+                }
+                size_t grown = (subset | size_t(1) << k) * others + k;
+                long hops = sofar + matrix[(j + 1) * n + k + 1];
+                if (hops < best[grown]) {
+                    best[grown] = hops;
+                    previous[grown] = j;
+                }
+            }
+        }
+    }
+
+    size_t all = subsets - 1;
+    int last = 0;
+    long shortest = LONG_MAX;
+    for (int j = 0; j < others; j++) {
+        long hops = best[all * others + j] + matrix[(j + 1) * n];
+        if (hops < shortest) {
+            shortest = hops;
+            last = j;
+        }
+    }
+
+    vector<int> tour;
+    for (size_t subset = all; subset != 0; ) {
+        tour.push_back(last + 1);
+        int before = previous[subset * others + last];
+        subset &= ~(size_t(1) << last);
+        last = before;
+    }
+    tour.push_back(0);
+    reverse(tour.begin(), tour.end());
+    return tour;
+}
+
+/// @brief Start from the nearest neighbour trip and apply 2-opt and
+///        Or-opt passes until neither finds a shorter trip.
+/// @return positions 0..n-1 in the order of a short round trip
+/// @param firstHops optional length of the nearest neighbour trip
+/// @param improvements optional count of moves taken
+vector<int> ItineraryPlanner::solveHeuristic(const vector<int> &matrix, int n, long *firstHops,
+                                             long *improvements) const {
+    PROFILE_SCOPE("itinerary.heuristic");
+    vector<int> tour;
+    vector<bool> visited(n, false);
+    if (n > 0) {
+        tour.push_back(0);
+        visited[0] = true;
+    }
+    while (static_cast<int>(tour.size()) < n) {
+        int from = tour.back(), nearest = -1;
+        for (int j = 0; j < n; j++) {
+            if (!visited[j] && (nearest == -1 || matrix[from * n + j] < matrix[from * n + nearest])) {
+                nearest = j;
+            }
+        }
+        visited[nearest] = true;
+        tour.push_back(nearest);
+    }
+    if (firstHops != nullptr) {
+        *firstHops = tripHops(matrix, n, tour);
+    }
+
+    // every move shortens the trip, so the passes end
+    long moves = 0;
+    while (n > 3) {
+        long made = twoOptPass(matrix, n, tour);
+        made += orOptPass(matrix, n, tour);
+        if (made == 0) {
+            break;
+        }
+        moves += made;
+    }
+    if (improvements != nullptr) {
+        *improvements = moves;
+    }
+    return tour;
+}
+
+/// @return hops of the round trip through positions in tour order
+long ItineraryPlanner::tripHops(const vector<int> &matrix, int n, const vector<int> &tour) {
+    long hops = 0;
+    for (size_t k = 0; k < tour.size(); k++) {
+        hops += matrix[tour[k] * n + tour[(k + 1) % tour.size()]];
+    }
+    return hops;
+}
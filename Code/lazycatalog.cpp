@@ -0,0 +1,344 @@
+/// @file lazycatalog.cpp
+/// @brief Implementations for lazy loading of celestial data.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "solarsystem.h"
+#include "fileexception.h"
+#include "systemindex.h"
+#include "catalog.h"
+#include "compressedinput.h"
+#include "lazycatalog.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief the system name field of a data line: System,name[,x,y,z],
+///        Star,name,system,..., Planet,name,star,system,...,
+///        Satellite,name,planet,system,...
+/// @return false when the line has too few fields
+static bool systemField(const string &line, size_t keywordEnd, string &systemName) {
+    string keyword = line.substr(0, keywordEnd);
+    int field;
+    if (keyword == "System") {
+        field = 1;
+    } else if (keyword == "Star") {
+        field = 2;
+    } else if (keyword == "Planet" || keyword == "Satellite") {
+        field = 3;
+    } else {
+        throw FileException("Exception Caught: Bad Data Line - Invalid Celestial Type: " + line);
+    }
+
+    size_t start = keywordEnd + 1;
+    for (int f = 1; f < field; f++) {
+        start = line.find(',', start);
+        if (start == string::npos) {
+            return false;
+        }
+        start++;
+    }
+    size_t end = line.find(',', start);
+    if (end == string::npos) {
+        // the System name may end the line, every other name is followed by data
+        if (field != 1) {
+            return false;
+        }
+        end = line.size();
+    }
+    systemName = line.substr(start, end - start);
+    return true;
+}
+
+
+/// @return one line summary
+string LazyStats::toString() const {
+    ostringstream out;
+    out << "Indexed in " << this->indexMs << " ms, " << this->loads << " systems loaded, "
+        << this->evictions << " evicted, " << this->bytesRead << " bytes read on demand.";
+    return out.str();
+}
+
+/// @brief Index a celestial data file and create a shell for every system
+///        in it. Systems that already existed, and the coordinates of new
+///        ones, are loaded straight away so lazy loads never drop bodies
+///        that came from elsewhere.
+/// @param fileName the celestial data file, kept open for loads
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param capacity most systems to keep bodies for, at least 1
+void LazyCatalog::open(const string &fileName, vector<shared_ptr<SolarSystem>> &systems,
+                       SystemIndex &index, size_t capacity) {
+    auto started = chrono::steady_clock::now();
+    if (this->isActive()) {
+        this->materializeAll();
+    }
+
+    ifstream in(fileName, ios::binary);
+    if (!in.is_open()) {
+        throw FileException("Exception Caught: File Not Found - " + fileName);
+    }
+
+    // bodies are read back by file offset, which a compressed file lacks
+    unsigned char magic[4] = {0, 0, 0, 0};
+    in.read(reinterpret_cast<char *>(magic), sizeof(magic));
+    if (detectCompression(magic, in.gcount()) != Compression::None) {
+        throw FileException("Exception Caught: Lazy Loading Needs An Uncompressed File - " + fileName);
+    }
+    in.clear();
+    in.seekg(0, ios::beg);
+
+    index.sync(systems);
+    const int existing = index.size();
+
+    // runs in file order, tagged with their system, and the latest run of
+    // each system so consecutive lines join into one run
+    vector<pair<int, Run>> found;
+    vector<long> latest;
+    string immediate; // lines the loader must see now
+
+    const size_t kBlock = 1 << 20;
+    string buffer;
+    uint64_t bufferOffset = 0; // file offset of buffer[0]
+    vector<char> block(kBlock);
+    while (in) {
+        in.read(block.data(), kBlock);
+        buffer.append(block.data(), in.gcount());
+
+        size_t lineStart = 0;
+        size_t newline;
+        while ((newline = buffer.find('\n', lineStart)) != string::npos ||
+               (in.eof() && lineStart < buffer.size())) {
+            size_t lineEnd = newline == string::npos ? buffer.size() : newline;
+            size_t next = newline == string::npos ? buffer.size() : newline + 1;
+            string line = buffer.substr(lineStart, lineEnd - lineStart);
+            uint64_t offset = bufferOffset + lineStart;
+            lineStart = next;
+
+            // blank lines and comments belong to no system
+            if (line.empty() || line.at(0) == '#') {
+                continue;
+            }
+
+            size_t commaPos = line.find(',');
+            if (commaPos == string::npos) {
+                throw FileException("Exception Caught: Bad Data Line - No Comma Found: " + line);
+            }
+            string systemName;
+            if (!systemField(line, commaPos, systemName)) {
+                throw FileException("Exception Caught: Bad Data Line - Mismatched Data Amount: " + line);
+            }
+
+            bool created = false;
+            int id = index.findOrCreate(systems, systemName, created);
+            if (id < existing) {
+                immediate += line + "\n";
+                continue;
+            }
+            if (line.compare(0, commaPos, "System") == 0) {
+                if (line.find(',', commaPos + 1) != string::npos) {
+                    immediate += line + "\n"; // coordinates
+                }
+                continue;
+            }
+
+            if (latest.size() <= static_cast<size_t>(id)) {
+                latest.resize(id + 1, -1);
+            }
+            uint32_t length = static_cast<uint32_t>(next - (offset - bufferOffset));
+            long last = latest[id];
+            if (last != -1 && found[last].second.offset + found[last].second.length == offset) {
+                found[last].second.length += length;
+            } else {
+                latest[id] = found.size();
+                found.push_back({id, {offset, length}});
+            }
+        }
+        buffer.erase(0, lineStart);
+        bufferOffset += lineStart;
+    }
+
+    if (!immediate.empty()) {
+        istringstream lines(immediate);
+        loadCelestialObjects(lines, systems, index);
+    }
+
+    // group the runs by system, keeping file order within a system
+    int numSystems = index.size();
+    this->runStart.assign(numSystems + 1, 0);
+    for (const auto &[id, run] : found) {
+        this->runStart[id + 1]++;
+    }
+    for (int id = 0; id < numSystems; id++) {
+        this->runStart[id + 1] += this->runStart[id];
+    }
+    this->runs.resize(found.size());
+    vector<size_t> fill(this->runStart.begin(), this->runStart.end() - 1);
+    for (const auto &[id, run] : found) {
+        this->runs[fill[id]++] = run;
+    }
+
+    this->fileName = fileName;
+    this->file.close();
+    this->file.clear();
+    this->file.open(fileName, ios::binary);
+    this->systems = &systems;
+    this->index = &index;
+    this->capacity = max<size_t>(1, capacity);
+    this->resident.assign(numSystems, 0);
+    this->position.assign(numSystems, this->recent.end());
+    this->recent.clear();
+    this->stats = LazyStats();
+    this->stats.indexMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+}
+
+/// @return true while systems may be waiting for their bodies
+bool LazyCatalog::isActive() const {
+    return this->systems != nullptr;
+}
+
+/// @brief Load a system's bodies if they are not resident, dropping the
+///        least recently used system's when over capacity.
+/// @param id the system's id in the index
+void LazyCatalog::ensureLoaded(int id) {
+    if (!this->isActive() || id < 0 || static_cast<size_t>(id) + 1 >= this->runStart.size()) {
+        return;
+    }
+    if (this->resident[id]) {
+        this->touch(id);
+        return;
+    }
+    if (this->runStart[id] == this->runStart[id + 1]) {
+        return; // a shell with no bodies in the file
+    }
+    this->evictOver(this->capacity - 1);
+    this->load(id);
+}
+
+/// @brief Load every listed system and keep them all resident until the
+///        next load, even past capacity.
+/// @param ids the systems' ids in the index
+void LazyCatalog::ensureLoaded(const vector<int> &ids) {
+    if (!this->isActive()) {
+        return;
+    }
+    for (int id : ids) {
+        if (id < 0 || static_cast<size_t>(id) + 1 >= this->runStart.size()) {
+            continue;
+        }
+        if (this->resident[id]) {
+            this->touch(id);
+        } else if (this->runStart[id] != this->runStart[id + 1]) {
+            this->load(id);
+        }
+    }
+    this->evictOver(max(this->capacity, ids.size()));
+}
+
+/// @brief Load every system and leave lazy mode. Systems are read in
+///        batches so the loader runs once per few megabytes.
+void LazyCatalog::materializeAll() {
+    if (!this->isActive()) {
+        return;
+    }
+
+    const size_t kBatch = 8 << 20;
+    string batch;
+    int numSystems = this->runStart.size() - 1;
+    for (int id = 0; id < numSystems; id++) {
+        if (this->resident[id]) {
+            continue;
+        }
+        for (size_t r = this->runStart[id]; r < this->runStart[id + 1]; r++) {
+            size_t at = batch.size();
+            batch.resize(at + this->runs[r].length);
+            this->file.clear();
+            this->file.seekg(this->runs[r].offset);
+            this->file.read(&batch[at], this->runs[r].length);
+            this->stats.bytesRead += this->runs[r].length;
+        }
+        this->resident[id] = 1;
+        this->stats.loads++;
+        if (batch.size() >= kBatch) {
+            istringstream lines(batch);
+            loadCelestialObjects(lines, *this->systems, *this->index);
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) {
+        istringstream lines(batch);
+        loadCelestialObjects(lines, *this->systems, *this->index);
+    }
+    this->clear();
+}
+
+/// @brief Leave lazy mode without loading, for when the systems are cleared.
+void LazyCatalog::clear() {
+    this->file.close();
+    this->fileName.clear();
+    this->systems = nullptr;
+    this->index = nullptr;
+    this->runStart.clear();
+    this->runs.clear();
+    this->resident.clear();
+    this->recent.clear();
+    this->position.clear();
+}
+
+/// @return number of systems with bodies resident
+size_t LazyCatalog::residentCount() const {
+    return this->recent.size();
+}
+
+/// @return counters since open
+const LazyStats &LazyCatalog::getStats() const {
+    return this->stats;
+}
+
+/// @brief read a system's lines and hand them to the loader
+void LazyCatalog::load(int id) {
+    string lines;
+    for (size_t r = this->runStart[id]; r < this->runStart[id + 1]; r++) {
+        size_t at = lines.size();
+        lines.resize(at + this->runs[r].length);
+        this->file.clear();
+        this->file.seekg(this->runs[r].offset);
+        this->file.read(&lines[at], this->runs[r].length);
+        this->stats.bytesRead += this->runs[r].length;
+    }
+
+    // resident before parsing so a bad line is not read again every time
+    this->resident[id] = 1;
+    this->recent.push_front(id);
+    this->position[id] = this->recent.begin();
+    this->stats.loads++;
+
+    istringstream in(lines);
+    loadCelestialObjects(in, *this->systems, *this->index);
+}
+
+/// @brief drop the bodies of least recently used systems until at most
+///        limit stay resident
+void LazyCatalog::evictOver(size_t limit) {
+    while (this->recent.size() > limit) {
+        int id = this->recent.back();
+        this->recent.pop_back();
+        this->resident[id] = 0;
+        this->position[id] = this->recent.end();
+        this->systems->at(id)->clearCelestials();
+        this->index->markBodiesChanged();
+        this->stats.evictions++;
+    }
+}
+
+/// @brief mark a resident system as the most recently used
+void LazyCatalog::touch(int id) {
+    this->recent.splice(this->recent.begin(), this->recent, this->position[id]);
+}
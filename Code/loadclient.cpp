@@ -0,0 +1,247 @@
+/// @file loadclient.cpp
+/// @brief Load testing client for the query server (program.out -serve).
+///        Opens one connection per client thread, sends a weighted mix of
+///        route, detail, path validation and stats requests between random
+///        systems, and reports throughput and latency percentiles.
+///
+/// Usage: loadclient.out [-socket path] [-clients N] [-requests N]
+///                       [-mix route:6,details:3,validate:1,stats:0]
+///                       [-seed S]
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "serverprotocol.h"
+
+using namespace std;
+
+/// @brief request kinds in the mix, in the order they are reported
+const char *const kKinds[] = {"route", "details", "validate", "stats"};
+const int kNumKinds = 4;
+
+/// @brief what one client thread saw
+struct ClientResult
+{
+    vector<double> latencies[kNumKinds]; // milliseconds
+    long errors[kNumKinds] = {0, 0, 0, 0};
+    bool failed = false;
+};
+
+// Local Function Prototypes
+bool parseMix(const string &text, int weights[]);
+void runClient(const string &socketPath, const vector<string> &names, const int weights[],
+               long requests, unsigned long seed, ClientResult &result);
+double percentile(const vector<double> &sorted, double p);
+
+int main(int argc, char* argv[])
+{
+    string socketPath = "interstellar.sock";
+    int clients = 8;
+    long requests = 2000;
+    unsigned long seed = 42;
+    int weights[kNumKinds] = {6, 3, 1, 0};
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cout << "Missing value for " << arg << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        try {
+            if (arg == "-socket") {
+                socketPath = value;
+            } else if (arg == "-clients") {
+                clients = max(1, stoi(value));
+            } else if (arg == "-requests") {
+                requests = max(1L, stol(value));
+            } else if (arg == "-seed") {
+                seed = stoul(value);
+            } else if (arg == "-mix") {
+                if (!parseMix(value, weights)) {
+                    cout << "Invalid mix " << value << ", expected e.g. route:6,details:3,validate:1,stats:0" << endl;
+                    return 1;
+                }
+            } else {
+                cout << "Unknown option " << arg << endl;
+                return 1;
+            }
+        } catch (const exception &) {
+            cout << "Invalid value for " << arg << ": " << value << endl;
+            return 1;
+        }
+    }
+
+    // the system names to pick requests from
+    int fd = connectToServer(socketPath);
+    if (fd < 0) {
+        cout << "Unable to connect to " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    string response;
+    bool listed = sendFrame(fd, "NAMES") && receiveFrame(fd, response);
+    close(fd);
+    vector<string> names = splitLines(response);
+    if (!listed || names.empty() || names.front() != "OK" || names.size() < 2) {
+        cout << "The server has no Solar Systems to query." << endl;
+        return 1;
+    }
+    names.erase(names.begin());
+
+    cout << clients << " clients x " << requests << " requests over " << names.size()
+        << " Solar Systems" << endl;
+    vector<ClientResult> results(clients);
+    vector<thread> threads;
+    auto started = chrono::steady_clock::now();
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back(runClient, cref(socketPath), cref(names), weights, requests,
+                             seed + c, ref(results[c]));
+    }
+    for (thread &client : threads) {
+        client.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    // merge and report per kind, then overall
+    vector<double> all;
+    long totalErrors = 0;
+    bool failed = false;
+    cout << fixed;
+    for (int k = 0; k < kNumKinds; k++) {
+        vector<double> latencies;
+        long errors = 0;
+        for (const ClientResult &result : results) {
+            latencies.insert(latencies.end(), result.latencies[k].begin(), result.latencies[k].end());
+            errors += result.errors[k];
+        }
+        if (latencies.empty()) {
+            continue;
+        }
+        sort(latencies.begin(), latencies.end());
+        cout << left << setw(10) << kKinds[k] << right << " n=" << setw(8) << latencies.size()
+            << setprecision(3) << " p50=" << setw(9) << percentile(latencies, 50)
+            << " p90=" << setw(9) << percentile(latencies, 90)
+            << " p99=" << setw(9) << percentile(latencies, 99)
+            << " max=" << setw(9) << latencies.back() << " ms  errors=" << errors << endl;
+        all.insert(all.end(), latencies.begin(), latencies.end());
+        totalErrors += errors;
+    }
+    for (const ClientResult &result : results) {
+        failed = failed || result.failed;
+    }
+
+    sort(all.begin(), all.end());
+    cout << left << setw(10) << "all" << right << " n=" << setw(8) << all.size()
+        << setprecision(3) << " p50=" << setw(9) << percentile(all, 50)
+        << " p90=" << setw(9) << percentile(all, 90)
+        << " p99=" << setw(9) << percentile(all, 99)
+        << " max=" << setw(9) << (all.empty() ? 0.0 : all.back()) << " ms  errors=" << totalErrors << endl;
+    cout << setprecision(0) << all.size() / seconds << " requests/s over " << setprecision(2)
+        << seconds << " s" << defaultfloat << endl;
+    if (failed) {
+        cout << "Some clients lost their connection." << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/// @brief Read weights like route:6,details:3 into the kinds' slots;
+///        kinds not named get weight 0.
+/// @return false on an unknown kind or when every weight is 0
+bool parseMix(const string &text, int weights[]) {
+    fill(weights, weights + kNumKinds, 0);
+    stringstream in(text);
+    string item;
+    int total = 0;
+    while (getline(in, item, ',')) {
+        size_t colon = item.find(':');
+        string kind = item.substr(0, colon);
+        int weight = colon == string::npos ? 1 : stoi(item.substr(colon + 1));
+        int k = find(kKinds, kKinds + kNumKinds, kind) - kKinds;
+        if (k == kNumKinds || weight < 0) {
+            return false;
+        }
+        weights[k] = weight;
+        total += weight;
+    }
+    return total > 0;
+}
+
+/// @brief one client thread: its own connection, requests sent one at a
+///        time, each timed from send to whole response
+void runClient(const string &socketPath, const vector<string> &names, const int weights[],
+               long requests, unsigned long seed, ClientResult &result) {
+    int fd = connectToServer(socketPath);
+    if (fd < 0) {
+        result.failed = true;
+        return;
+    }
+
+    mt19937_64 rng(seed);
+    discrete_distribution<int> pickKind(weights, weights + kNumKinds);
+    uniform_int_distribution<size_t> pickName(0, names.size() - 1);
+    vector<string> lastRoute; // validated when there is one, so most paths are valid
+    string response;
+
+    for (long r = 0; r < requests; r++) {
+        int kind = pickKind(rng);
+        string request;
+        if (kind == 0) {
+            request = "ROUTE\n" + names[pickName(rng)] + "\n" + names[pickName(rng)];
+        } else if (kind == 1) {
+            request = "DETAILS\n" + names[pickName(rng)];
+        } else if (kind == 2) {
+            request = "VALIDATE";
+            if (lastRoute.empty()) {
+                lastRoute = {names[pickName(rng)], names[pickName(rng)]};
+            }
+            for (const string &name : lastRoute) {
+                request += "\n" + name;
+            }
+        } else {
+            request = "STATS";
+        }
+
+        auto sent = chrono::steady_clock::now();
+        if (!sendFrame(fd, request) || !receiveFrame(fd, response)) {
+            result.failed = true;
+            break;
+        }
+        result.latencies[kind].push_back(
+            chrono::duration<double, milli>(chrono::steady_clock::now() - sent).count());
+
+        if (response.compare(0, 2, "OK") != 0) {
+            result.errors[kind]++;
+        } else if (kind == 0) {
+            // second line is A -> B -> C
+            size_t start = 3, end = response.find('\n', start);
+            string path = response.substr(start, end == string::npos ? string::npos : end - start);
+            lastRoute.clear();
+            for (size_t at = 0; at <= path.size();) {
+                size_t arrow = path.find(" -> ", at);
+                lastRoute.push_back(path.substr(at, arrow == string::npos ? string::npos : arrow - at));
+                at = arrow == string::npos ? path.size() + 1 : arrow + 4;
+            }
+        }
+    }
+    close(fd);
+}
+
+/// @brief nearest rank percentile of ascending samples
+double percentile(const vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size());
+    return sorted.at(min(rank, sorted.size() - 1));
+}
@@ -0,0 +1,315 @@
+/// @file loadingtests.cpp
+/// @brief Test suite cases for the tolerant and transactional loaders, delta
+///        files and rebuilding the system index.
+///        Utilized by the Interstellar Travel App.
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "fileexception.h"
+#include "systemindex.h"
+#include "catalog.h"
+#include "deltaloader.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief three systems, SYS0 -> SYS1 -> SYS2, with a star and a planet in SYS0
+static const string kCelestial =
+    "System,SYS0,1.0,0.0,0.0\n"
+    "System,SYS1,2.0,0.0,0.0\n"
+    "System,SYS2,3.0,0.0,0.0\n"
+    "Star,S0_0,SYS0,G2V,5778,1.0\n"
+    "Planet,P0_0,S0_0,SYS0,365.25,1.0\n";
+static const string kConnections =
+    "SYS0,SYS1\n"
+    "SYS1,SYS2\n";
+
+/// @brief load text through the tolerant loader
+static LoadReport loadCelestial(const string &text, vector<shared_ptr<SolarSystem>> &systems,
+                                SystemIndex &index, bool transactional) {
+    istringstream in(text);
+    LoadOptions options;
+    options.transactional = transactional;
+    LoadReport report;
+    loadCelestialObjects(in, systems, index, options, report);
+    return report;
+}
+
+/// @brief load the three systems and their connections
+static void loadSmallUniverse(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    istringstream celestial(kCelestial);
+    loadCelestialObjects(celestial, systems, index);
+    istringstream connections(kConnections);
+    loadSolarSystemConnections(connections, systems, index);
+}
+
+/// @return true when from has a connection to to
+static bool connected(const SystemIndex &index, const string &from, const string &to) {
+    const vector<int> &targets = index.neighbors(index.idOf(from));
+    return find(targets.begin(), targets.end(), index.idOf(to)) != targets.end();
+}
+
+
+TEST(DeltaLoader, AppliesEveryKindOfChange) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    istringstream delta(
+        "# a comment and a blank line are skipped\n"
+        "\n"
+        "System,SYS3,4.0,0.0,0.0\n"
+        "Star,S0_0,SYS0,K1V,5000,0.8\n"
+        "Planet,P3_0,S3_0,SYS3,100,2.0\n"
+        "Connect,SYS2,SYS3,SYS0\n"
+        "Disconnect,SYS0,SYS1\n");
+    DeltaReport report;
+    applyDelta(delta, systems, index, report);
+
+    EXPECT_EQ(report.linesApplied, 5);
+    EXPECT_EQ(report.systemsAdded, 1);
+    EXPECT_EQ(report.bodiesUpdated, 1);
+    EXPECT_EQ(report.bodiesAdded, 2); // P3_0 and the missing star S3_0
+    EXPECT_EQ(report.connectionsAdded, 2);
+    EXPECT_EQ(report.connectionsRemoved, 1);
+    ASSERT_EQ(index.size(), 4);
+    EXPECT_TRUE(connected(index, "SYS2", "SYS3"));
+    EXPECT_TRUE(connected(index, "SYS2", "SYS0"));
+    EXPECT_FALSE(connected(index, "SYS0", "SYS1"));
+    EXPECT_NE(index.find("SYS3")->find<Planet>("P3_0"), nullptr);
+}
+
+TEST(DeltaLoader, BadLineKeepsEarlierChanges) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    istringstream delta(
+        "System,SYS3\n"
+        "Connect,SYS2,SYS3\n"
+        "Planet,P9,SYS0\n"
+        "System,SYS4\n");
+    DeltaReport report;
+    EXPECT_THROW(applyDelta(delta, systems, index, report), FileException);
+
+    EXPECT_EQ(report.linesApplied, 2);
+    EXPECT_EQ(report.systemsAdded, 1);
+    EXPECT_EQ(report.connectionsAdded, 1);
+    EXPECT_NE(index.idOf("SYS3"), -1);
+    EXPECT_TRUE(connected(index, "SYS2", "SYS3"));
+    EXPECT_EQ(index.idOf("SYS4"), -1);
+}
+
+TEST(DeltaLoader, UnknownSystemsInConnectionsAreSkipped) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    istringstream delta(
+        "Connect,NOWHERE,SYS1\n"
+        "Connect,SYS2,NOWHERE,SYS0\n"
+        "Disconnect,SYS1,NOWHERE\n");
+    DeltaReport report;
+    applyDelta(delta, systems, index, report);
+
+    EXPECT_EQ(report.connectionsAdded, 1);
+    EXPECT_EQ(report.connectionsRemoved, 0);
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_TRUE(connected(index, "SYS2", "SYS0"));
+}
+
+TEST(DeltaLoader, BadNumberIsAFileException) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    const vector<string> lines = {"System,SYS3,1.0,north,2.0", "Star,S0_1,SYS0,G2V,5778,1e999",
+                                  "Planet,P0_1,S0_0,SYS0,long,1.0", "Satellite,M0,P0_0,SYS0,wide,Yes"};
+    for (const string &line : lines) {
+        istringstream delta(line + "\n");
+        DeltaReport report;
+        try {
+            applyDelta(delta, systems, index, report);
+            ADD_FAILURE() << "no exception for " << line;
+        } catch (const FileException &e) {
+            EXPECT_NE(string(e.what()).find(line), string::npos);
+        }
+        EXPECT_EQ(report.linesApplied, 0);
+        EXPECT_EQ(report.systemsAdded, 0);
+        EXPECT_EQ(report.bodiesAdded, 0);
+    }
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_EQ(index.idOf("SYS3"), -1);
+}
+
+TEST(SystemIndex, RebuildKeepsConnections) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    SystemIndex rebuilt;
+    rebuilt.sync(systems);
+    ASSERT_EQ(rebuilt.size(), 3);
+    EXPECT_TRUE(connected(rebuilt, "SYS0", "SYS1"));
+    EXPECT_TRUE(connected(rebuilt, "SYS1", "SYS2"));
+    EXPECT_FALSE(connected(rebuilt, "SYS2", "SYS0"));
+}
+
+TEST(SystemIndex, RebuildRefusesConnectionsLeavingTheSystems) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    // SYS1 still connects to SYS2, which is no longer loaded
+    systems.pop_back();
+    SystemIndex rebuilt;
+    EXPECT_THROW(rebuilt.sync(systems), logic_error);
+}
+
+TEST(SystemIndex, FailedRebuildLeavesTheIndexAsItWas) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+    unsigned long version = index.getVersion();
+
+    // replacing the vector rebuilds, and SYS0 connects to a stray system
+    vector<shared_ptr<SolarSystem>> replaced = systems;
+    shared_ptr<SolarSystem> stray = make_shared<SolarSystem>("STRAY");
+    replaced.at(2) = make_shared<SolarSystem>("SYS2");
+    replaced.push_back(make_shared<SolarSystem>("SYS3"));
+    replaced.back()->addConnection(stray);
+    EXPECT_THROW(index.sync(replaced), logic_error);
+
+    EXPECT_EQ(index.getVersion(), version);
+    ASSERT_EQ(index.size(), 3);
+    EXPECT_EQ(index.at(2), systems.at(2));
+    EXPECT_EQ(index.idOf("SYS3"), -1);
+    EXPECT_TRUE(connected(index, "SYS0", "SYS1"));
+
+    // appending a system with a stray connection changes nothing either
+    systems.push_back(replaced.back());
+    EXPECT_THROW(index.sync(systems), logic_error);
+    EXPECT_EQ(index.getVersion(), version);
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_EQ(index.idOf("SYS3"), -1);
+}
+
+TEST(TolerantLoad, SkipsBadLinesAndCountsThem) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    LoadReport report = loadCelestial(
+        "System,SYS0\n"
+        "no comma here\n"
+        "Star,S0_0,SYS0,G2V,hot,1.0\n"
+        "System,SYS1\n", systems, index, false);
+
+    EXPECT_EQ(report.linesRead, 4);
+    EXPECT_EQ(report.linesApplied, 2);
+    EXPECT_EQ(report.errorCount, 2);
+    ASSERT_EQ(report.errors.size(), 2u);
+    EXPECT_EQ(report.errors[0].lineNumber, 2);
+    EXPECT_EQ(report.errors[0].byteOffset, 12u);
+    EXPECT_EQ(report.errors[1].lineNumber, 3);
+    EXPECT_FALSE(report.readFailed);
+    EXPECT_TRUE(report.committed);
+    EXPECT_EQ(index.size(), 2);
+}
+
+TEST(TolerantLoad, KeepsDetailsOfTheFirstErrorsOnly) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    istringstream in("bad\nbad\nbad\nSystem,SYS0\n");
+    LoadOptions options;
+    options.maxErrors = 1;
+    LoadReport report;
+    loadCelestialObjects(in, systems, index, options, report);
+
+    EXPECT_EQ(report.errorCount, 3);
+    EXPECT_EQ(report.errors.size(), 1u);
+    EXPECT_EQ(report.linesApplied, 1);
+}
+
+TEST(TransactionalLoad, BadLineChangesNothing) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    loadSmallUniverse(systems, index);
+
+    LoadReport report = loadCelestial(
+        "System,SYS3\n"
+        "Star,S0_1,SYS0,G2V,5778,1.0\n"
+        "Planet,P0_1,S0_0\n", systems, index, true);
+
+    EXPECT_EQ(report.linesRead, 3);
+    EXPECT_EQ(report.linesApplied, 0);
+    EXPECT_EQ(report.errorCount, 1);
+    EXPECT_FALSE(report.committed);
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_EQ(index.idOf("SYS3"), -1);
+    EXPECT_EQ(index.find("SYS0")->find<Star>("S0_1"), nullptr);
+}
+
+TEST(TransactionalLoad, GoodFileIsCommitted) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    LoadReport report = loadCelestial(kCelestial, systems, index, true);
+
+    EXPECT_EQ(report.linesRead, 5);
+    EXPECT_EQ(report.linesApplied, 5);
+    EXPECT_EQ(report.errorCount, 0);
+    EXPECT_TRUE(report.committed);
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_NE(index.find("SYS0")->find<Planet>("P0_0"), nullptr);
+}
+
+TEST(TolerantLoad, ConnectionsToUnknownSystems) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    istringstream celestial(kCelestial);
+    loadCelestialObjects(celestial, systems, index);
+    const string text = "SYS0,SYS1,NOWHERE\nSYS1,SYS2\n";
+
+    // tolerant: the known connection of the first line is still added
+    istringstream tolerantIn(text);
+    LoadReport tolerant;
+    loadSolarSystemConnections(tolerantIn, systems, index, LoadOptions(), tolerant);
+    EXPECT_EQ(tolerant.linesRead, 2);
+    EXPECT_EQ(tolerant.linesApplied, 2);
+    EXPECT_EQ(tolerant.errorCount, 1);
+    EXPECT_TRUE(tolerant.committed);
+    EXPECT_TRUE(connected(index, "SYS0", "SYS1"));
+    EXPECT_TRUE(connected(index, "SYS1", "SYS2"));
+
+    // transactional: nothing is added
+    index.clearConnections();
+    istringstream transactionalIn(text);
+    LoadOptions options;
+    options.transactional = true;
+    LoadReport transactional;
+    loadSolarSystemConnections(transactionalIn, systems, index, options, transactional);
+    EXPECT_EQ(transactional.linesApplied, 0);
+    EXPECT_EQ(transactional.errorCount, 1);
+    EXPECT_FALSE(transactional.committed);
+    EXPECT_FALSE(connected(index, "SYS0", "SYS1"));
+    EXPECT_FALSE(connected(index, "SYS1", "SYS2"));
+}
+
+TEST(TolerantLoad, EmptyInput) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    LoadReport report = loadCelestial("", systems, index, true);
+
+    EXPECT_EQ(report.linesRead, 0);
+    EXPECT_EQ(report.errorCount, 0);
+    EXPECT_TRUE(report.committed);
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_EQ(index.idOf("SYS0"), -1);
+    EXPECT_EQ(index.find("SYS0"), nullptr);
+}
@@ -0,0 +1,103 @@
+/// @file memoryreport.cpp
+/// @brief Implementations for memory accounting of the loaded universe.
+///        Utilized by the Interstellar Travel App.
+
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "memoryreport.h"
+
+using namespace std;
+
+/// @return sum of every byte category
+size_t MemoryReport::total() const {
+    return this->systemBytes + this->starBytes + this->planetBytes + this->satelliteBytes +
+           this->nameBytes + this->controlBlockBytes + this->bodyListBytes +
+           this->connectionBytes + this->hashIndexBytes + this->systemTableBytes +
+           this->slackBytes + this->allocatorBytes;
+}
+
+/// @return one line per category with its bytes and share of the total
+string MemoryReport::toString() const {
+    const pair<const char *, size_t> categories[] = {
+        {"Solar Systems", this->systemBytes},
+        {"Stars", this->starBytes},
+        {"Planets", this->planetBytes},
+        {"Satellites", this->satelliteBytes},
+        {"Names", this->nameBytes},
+        {"Control blocks", this->controlBlockBytes},
+        {"Body lists", this->bodyListBytes},
+        {"Connection lists", this->connectionBytes},
+        {"Name lookup tables", this->hashIndexBytes},
+        {"System tables", this->systemTableBytes},
+        {"Vector slack", this->slackBytes},
+        {"Allocator overhead", this->allocatorBytes},
+    };
+
+    size_t all = this->total();
+    ostringstream out;
+    out << this->systems << " systems, " << this->stars << " stars, " << this->planets
+        << " planets, " << this->satellites << " satellites" << endl;
+    out << fixed << setprecision(1);
+    for (const auto &[category, bytes] : categories) {
+        out << left << setw(20) << category << right << setw(14) << bytes << " bytes"
+            << setw(7) << (all == 0 ? 0.0 : 100.0 * bytes / all) << "%" << endl;
+    }
+    out << left << setw(20) << "Total" << right << setw(14) << all << " bytes";
+    return out.str();
+}
+
+/// @brief Charge one allocation of reserved bytes of which used are in use.
+/// @param category where the used bytes go
+/// @param used bytes holding data
+/// @param reserved bytes requested from the allocator
+void MemoryReport::addAllocation(size_t &category, size_t used, size_t reserved) {
+    if (reserved == 0) {
+        return;
+    }
+    category += used;
+    this->slackBytes += reserved - used;
+    this->allocatorBytes += heapChunk(reserved) - reserved;
+}
+
+/// @brief Charge a string's own bytes and any heap buffer to names.
+/// @param name the string
+/// @param inlineToo false when the string object is already counted
+void MemoryReport::addName(const string &name, bool inlineToo) {
+    if (inlineToo) {
+        this->nameBytes += sizeof(string);
+    }
+    if (name.capacity() > kInlineChars) {
+        this->addAllocation(this->nameBytes, name.size() + 1, name.capacity() + 1);
+    }
+}
+
+/// @brief Account every byte reachable from the systems and their index.
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @return bytes by category
+MemoryReport measureMemory(const vector<shared_ptr<SolarSystem>> &systems, const SystemIndex &index) {
+    MemoryReport report;
+    report.addVector(report.systemTableBytes, systems);
+    for (const auto &system : systems) {
+        system->addMemoryUsage(report);
+    }
+    index.addMemoryUsage(report);
+    return report;
+}
+
+/// @brief Drop spare vector capacity and oversized hash tables after
+///        loading. Later loads grow them again as needed.
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+void shrinkMemory(vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    systems.shrink_to_fit();
+    for (const auto &system : systems) {
+        system->shrink();
+    }
+    index.shrink();
+}
@@ -0,0 +1,207 @@
+/// @file nameindex.cpp
+/// @brief Implementations for the NameIndex sorted name table used for
+///        name suggestions and prefix search.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "nameindex.h"
+
+using namespace std;
+
+/// @return "System", "Star", "Planet" or "Satellite"
+string nameKindToString(NameKind kind) {
+    switch (kind) {
+        case NameKind::System:
+            return "System";
+        case NameKind::Star:
+            return "Star";
+        case NameKind::Planet:
+            return "Planet";
+        default:
+            return "Satellite";
+    }
+}
+
+/// @brief Build the table from every system and celestial body.
+///        Names are stored back to back in one string and the entries
+///        pointing into it are sorted, so a prefix is a contiguous range.
+/// @param index the system index to read systems from
+void NameIndex::build(const SystemIndex &index) {
+    this->chars.clear();
+    this->entries.clear();
+    for (int id = 0; id < index.size(); id++) {
+        shared_ptr<SolarSystem> system = index.at(id);
+        this->add(system->getName(), NameKind::System, id);
+        for (const auto &celestial : system->getCelestialBodies()) {
+            if (dynamic_pointer_cast<Star>(celestial) != nullptr) {
+                this->add(celestial->getName(), NameKind::Star, id);
+            } else if (shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(celestial)) {
+                this->add(celestial->getName(), NameKind::Planet, id);
+                for (const auto &sat : planet->getSats()) {
+                    this->add(sat->getName(), NameKind::Satellite, id);
+                }
+            }
+        }
+    }
+
+    sort(this->entries.begin(), this->entries.end(), [this](const Entry &a, const Entry &b) {
+        return this->nameOf(a) < this->nameOf(b);
+    });
+    this->builtVersion = index.getVersion();
+    this->builtBodiesVersion = index.getBodiesVersion();
+    this->built = true;
+}
+
+/// @return true when systems or bodies changed since the last build
+bool NameIndex::isStale(const SystemIndex &index) const {
+    return !this->built || this->builtVersion != index.getVersion() ||
+           this->builtBodiesVersion != index.getBodiesVersion();
+}
+
+/// @return number of names in the table
+int NameIndex::size() const {
+    return this->entries.size();
+}
+
+/// @return id of the system with exactly this name, -1 when none
+int NameIndex::findSystem(const string &name) const {
+    for (size_t i = this->lowerBound(name); i < this->entries.size(); i++) {
+        const Entry &entry = this->entries[i];
+        if (this->nameOf(entry) != name) {
+            break;
+        }
+        if (entry.kind == NameKind::System) {
+            return entry.systemId;
+        }
+    }
+    return -1;
+}
+
+/// @brief Names starting with prefix, in sorted order
+vector<NameMatch> NameIndex::withPrefix(const string &prefix, size_t limit, size_t *total) const {
+    size_t first = this->lowerBound(prefix);
+    size_t last = this->prefixEnd(first, prefix);
+    if (total != nullptr) {
+        *total = last - first;
+    }
+
+    vector<NameMatch> found;
+    for (size_t i = first; i < last && found.size() < limit; i++) {
+        const Entry &entry = this->entries[i];
+        found.push_back({string(this->nameOf(entry)), entry.kind, entry.systemId, 0});
+    }
+    return found;
+}
+
+/// @brief Names within maxEdits of query, closest first. The sorted table
+///        is walked like a trie: one edit distance row per character of
+///        the current name, rows shared with the previous name are reused,
+///        and once every value in a row is over maxEdits the whole range
+///        of names sharing that prefix is skipped.
+vector<NameMatch> NameIndex::similar(const string &query, int maxEdits, size_t limit, bool systemsOnly) const {
+    vector<NameMatch> found;
+    const size_t m = query.size();
+    const size_t width = m + 1;
+
+    // rows[d * width + j] is the distance between the first d characters of
+    // the current name and the first j characters of the query
+    vector<int> rows(width);
+    for (size_t j = 0; j <= m; j++) {
+        rows[j] = j;
+    }
+
+    string_view previous;
+    size_t validDepth = 0;
+    size_t i = 0;
+    while (i < this->entries.size()) {
+        const Entry &entry = this->entries[i];
+        string_view name = this->nameOf(entry);
+
+        // rows for the prefix shared with the previous name are still valid
+        size_t depth = 0;
+        size_t shared = min(validDepth, name.size());
+        while (depth < shared && name[depth] == previous[depth]) {
+            depth++;
+        }
+        if (rows.size() < (name.size() + 1) * width) {
+            rows.resize((name.size() + 1) * width);
+        }
+
+        bool pruned = false;
+        while (depth < name.size()) {
+            const int *above = &rows[depth * width];
+            int *row = &rows[(depth + 1) * width];
+            row[0] = depth + 1;
+            int best = row[0];
+            for (size_t j = 1; j <= m; j++) {
+                int cost = (query[j - 1] == name[depth]) ? 0 : 1;
+                row[j] = min({above[j] + 1, row[j - 1] + 1, above[j - 1] + cost});
+                best = min(best, row[j]);
+            }
+            depth++;
+
+            if (best > maxEdits) {
+                pruned = true;
+                break;
+            }
+        }
+
+        previous = name;
+        validDepth = depth;
+        if (pruned) {
+            i = this->prefixEnd(i + 1, name.substr(0, depth));
+            continue;
+        }
+
+        int distance = rows[name.size() * width + m];
+        if (distance <= maxEdits && (!systemsOnly || entry.kind == NameKind::System)) {
+            found.push_back({string(name), entry.kind, entry.systemId, distance});
+        }
+        i++;
+    }
+
+    stable_sort(found.begin(), found.end(), [](const NameMatch &a, const NameMatch &b) {
+        return a.distance < b.distance;
+    });
+    if (found.size() > limit) {
+        found.resize(limit);
+    }
+    return found;
+}
+
+/// @brief the name an entry points at
+string_view NameIndex::nameOf(const Entry &entry) const {
+    return string_view(this->chars.data() + entry.offset, entry.length);
+}
+
+/// @return position of the first entry not less than name
+size_t NameIndex::lowerBound(string_view name) const {
+    auto it = lower_bound(this->entries.begin(), this->entries.end(), name,
+                          [this](const Entry &entry, string_view key) {
+        return this->nameOf(entry) < key;
+    });
+    return it - this->entries.begin();
+}
+
+/// @return position of the first entry at or after from that does not
+///         start with prefix, entries from..that position all do
+size_t NameIndex::prefixEnd(size_t from, string_view prefix) const {
+    auto it = partition_point(this->entries.begin() + from, this->entries.end(),
+                              [this, prefix](const Entry &entry) {
+        return this->nameOf(entry).substr(0, prefix.size()) == prefix;
+    });
+    return it - this->entries.begin();
+}
+
+/// @brief append a name to the table, sorted later by build
+void NameIndex::add(const string &name, NameKind kind, int systemId) {
+    this->entries.push_back({this->chars.size(), static_cast<uint32_t>(name.size()), systemId, kind});
+    this->chars += name;
+}
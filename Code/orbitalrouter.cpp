@@ -0,0 +1,240 @@
+/// @file orbitalrouter.cpp
+/// @brief Implementations for departure time aware routing over the
+///        Solar System connection graph.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "orbitalrouter.h"
+#include "profiler.h"
+
+using namespace std;
+
+// Local Helper Functions
+static const int kFineSteps = 8; // samples between phase table entries
+
+/// @return (1 - cos) / 2 over one orbit, kPhaseSteps * kFineSteps samples
+///         from 0 at phase zero to 1 half an orbit later
+static const vector<double> &transferShape() {
+    static const vector<double> shape = []() {
+        int samples = OrbitalRouter::kPhaseSteps * kFineSteps;
+        vector<double> values(samples);
+        for (int i = 0; i < samples; i++) {
+            values[i] = (1.0 - cos(2.0 * M_PI * i / samples)) / 2.0;
+        }
+        return values;
+    }();
+    return shape;
+}
+
+/// @return orbital period of the planet setting a system's transfer
+///         windows, 0 when it has no planet
+static double referencePeriod(const SolarSystem &system, ReferencePlanet reference) {
+    double period = 0.0;
+    for (const auto &body : system.getCelestialBodies()) {
+        shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(body);
+        if (planet == nullptr || planet->getOrbitalPeriod() <= 0.0) {
+            continue;
+        }
+        double next = planet->getOrbitalPeriod();
+        if (period == 0.0 || (reference == ReferencePlanet::Fastest && next < period) ||
+            (reference == ReferencePlanet::Slowest && next > period)) {
+            period = next;
+        }
+        if (reference == ReferencePlanet::First) {
+            break;
+        }
+    }
+    return period;
+}
+
+
+/// @brief Use this model from the next build.
+void OrbitalRouter::setModel(const OrbitalModel &model) {
+    this->model = model;
+    this->built = false;
+}
+
+/// @return the model of the last build
+const OrbitalModel &OrbitalRouter::getModel() const {
+    return this->model;
+}
+
+/// @brief Snapshot the connections of the index and fill the phase tables.
+///        Each table entry is the least of waiting w days and then taking
+///        the transfer, over every w, found by one sweep backwards over two
+///        orbits of the finer samples: going now or waiting one more
+///        sample for whatever is best from there.
+/// @param index the system index to snapshot
+void OrbitalRouter::build(const SystemIndex &index) {
+    PROFILE_SCOPE("orbital.build");
+    int n = index.size();
+    this->offsets.assign(n + 1, 0);
+    this->targets.clear();
+    for (int id = 0; id < n; id++) {
+        const vector<int> &next = index.neighbors(id);
+        this->targets.insert(this->targets.end(), next.begin(), next.end());
+        this->offsets[id + 1] = this->targets.size();
+    }
+
+    const vector<double> &shape = transferShape();
+    int samples = shape.size();
+    this->delays.assign(static_cast<size_t>(n) * kPhaseSteps, 0.0f);
+    this->frequencies.assign(n, 0.0);
+    for (int id = 0; id < n; id++) {
+        double period = referencePeriod(*index.at(id), this->model.reference);
+        if (period <= 0.0 || this->model.transferDays <= 0.0) {
+            continue;
+        }
+        this->frequencies[id] = 1.0 / period;
+        double step = period / samples;
+        double best = numeric_limits<double>::infinity();
+        float *row = &this->delays[static_cast<size_t>(id) * kPhaseSteps];
+        for (int i = 2 * samples - 1; i >= 0; i--) {
+            best = min(this->model.transferDays * shape[i % samples], best + step);
+            if (i < samples && i % kFineSteps == 0) {
+                row[i / kFineSteps] = static_cast<float>(best);
+            }
+        }
+    }
+
+    this->arrival.clear();
+    this->parent.clear();
+    this->stamp.clear();
+    this->currentStamp = 0;
+    this->builtVersion = index.getVersion();
+    this->builtBodiesVersion = index.getBodiesVersion();
+    this->built = true;
+}
+
+/// @return true when systems, connections or bodies changed since the
+///         last build
+bool OrbitalRouter::isStale(const SystemIndex &index) const {
+    return !this->built || this->builtVersion != index.getVersion() ||
+           this->builtBodiesVersion != index.getBodiesVersion();
+}
+
+/// @brief Dijkstra on arrival day. Flying a connection from v on day t
+///        reaches the next system on t + hopDays, and the transfer into it
+///        follows from its phase table.
+/// @param route filled with system ids from start to end
+/// @param arriveDay set to the day the transfer into end completes
+/// @param stats optional work counters for the query
+/// @return true when end can be reached from start
+bool OrbitalRouter::findEarliestArrival(int start, int end, double departDay, vector<int> &route,
+                                        double &arriveDay, RouteStats *stats) const {
+    PROFILE_SCOPE("route.orbital");
+    auto started = chrono::steady_clock::now();
+    route.clear();
+    arriveDay = departDay;
+    int n = this->size();
+    if (start < 0 || end < 0 || start >= n || end >= n) {
+        return false;
+    }
+
+    if (this->stamp.size() != static_cast<size_t>(n)) {
+        this->stamp.assign(n, 0);
+        this->arrival.assign(n, 0.0);
+        this->parent.assign(n, -1);
+        this->currentStamp = 0;
+    }
+    if (++this->currentStamp == 0) {
+        fill(this->stamp.begin(), this->stamp.end(), 0);
+        this->currentStamp = 1;
+    }
+    const unsigned seen = this->currentStamp;
+
+    using Entry = pair<double, int>;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> open;
+    this->stamp[start] = seen;
+    this->arrival[start] = departDay;
+    this->parent[start] = -1;
+    open.emplace(departDay, start);
+    int settled = 0;
+    bool found = false;
+    while (!open.empty()) {
+        auto [day, v] = open.top();
+        open.pop();
+        if (day != this->arrival[v]) {
+            continue; // stale queue entry
+        }
+        settled++;
+        if (v == end) {
+            found = true;
+            break;
+        }
+
+        double flown = day + this->model.hopDays;
+        for (int i = this->offsets[v]; i < this->offsets[v + 1]; i++) {
+            int to = this->targets[i];
+            double reached = flown + this->transferDelay(to, flown);
+            if (this->stamp[to] != seen || reached < this->arrival[to]) {
+                this->stamp[to] = seen;
+                this->arrival[to] = reached;
+                this->parent[to] = v;
+                open.emplace(reached, to);
+            }
+        }
+    }
+
+    if (found) {
+        for (int v = end; v != -1; v = this->parent[v]) {
+            route.push_back(v);
+        }
+        reverse(route.begin(), route.end());
+        arriveDay = this->arrival[end];
+    }
+
+    PROFILE_COUNT("route.settled", settled);
+    if (stats != nullptr) {
+        stats->settled = settled;
+        stats->elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+    return found;
+}
+
+/// @return the day a ship leaving on departDay completes a route
+double OrbitalRouter::followRoute(const vector<int> &route, double departDay) const {
+    double day = departDay;
+    for (size_t i = 1; i < route.size(); i++) {
+        day += this->model.hopDays;
+        day += this->transferDelay(route[i], day);
+    }
+    return day;
+}
+
+/// @brief Read a phase table, interpolating between its entries. The
+///        entries never fall faster than a day per day, so neither does
+///        the interpolation, and arrivals keep their order.
+/// @return days from arriving at a system on a day until the transfer
+///         into it completes, waiting included
+double OrbitalRouter::transferDelay(int id, double day) const {
+    if (this->frequencies[id] == 0.0) {
+        return 0.0;
+    }
+    double orbits = day * this->frequencies[id];
+    double position = (orbits - floor(orbits)) * kPhaseSteps;
+    int entry = min(static_cast<int>(position), kPhaseSteps - 1);
+    double within = position - entry;
+    const float *row = &this->delays[static_cast<size_t>(id) * kPhaseSteps];
+    return row[entry] * (1.0 - within) + row[(entry + 1) % kPhaseSteps] * within;
+}
+
+/// @return number of systems in the snapshot
+int OrbitalRouter::size() const {
+    return this->offsets.empty() ? 0 : this->offsets.size() - 1;
+}
+
+/// @return bytes held by the phase tables
+size_t OrbitalRouter::tableBytes() const {
+    return this->delays.size() * sizeof(float) + this->frequencies.size() * sizeof(double);
+}
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include "celestial.h"
+#include "memoryreport.h"
 
 using namespace std;
 
@@ -71,6 +72,13 @@ int Planet::numSats() const {
     return this->sats.size();
 }
 
+/// @brief obtain the objects orbiting this Planet object
+/// @return the private data member sats, by reference to avoid copying
+///         large satellite lists
+const vector<shared_ptr<Celestial>> &Planet::getSats() const {
+    return this->sats;
+}
+
 /// @brief set the private data member double orbitalPeriod of this Planet object
 void Planet::setOrbitalPeriod(double oP) {
     this->orbitalPeriod = oP;
@@ -83,7 +91,9 @@ void Planet::setRadius(double r) {
 
 /// @brief add a ptr to a celestial object to the orbit of this Planet
 /// @param celestialObject ptr to the celestial object to be added to sats vector
+/// note: the name index keeps the first object added under a name
 void Planet::addSat(shared_ptr<Celestial> &celestialObject) {
+    this->satIndex.emplace(celestialObject->getName(), this->sats.size());
     this->sats.push_back(celestialObject);
 }
 
@@ -91,12 +101,18 @@ void Planet::addSat(shared_ptr<Celestial> &celestialObject) {
 /// @param name the name of the object we are searching for
 /// @return true if found, false otherwise
 bool Planet::satExists(const string &name) const {
-    for (const auto& sat : this->sats) {
-        if (sat->getName() == name) {
-            return true;
-        }
+    return this->satIndex.count(name) > 0;
+}
+
+/// @brief find an object orbiting this Planet by name
+/// @param name the name of the object we are searching for
+/// @return the object, nullptr if not found
+shared_ptr<Celestial> Planet::getSat(const string &name) const {
+    auto it = this->satIndex.find(name);
+    if (it == this->satIndex.end()) {
+        return nullptr;
     }
-    return false; // not found
+    return this->sats.at(it->second);
 }
 
 /// @brief output all the 'toString' details of every sat in sats
@@ -119,4 +135,28 @@ string Planet::toString() const {
     }
     
     return details;
-}
\ No newline at end of file
+}
+
+/// @brief Charge this Planet, its satellite list, name index and
+///        satellites to a memory report.
+/// @param report the report to add to
+void Planet::addMemoryUsage(MemoryReport &report) const {
+    report.planets++;
+    report.addShared<Planet>(report.planetBytes);
+    report.addName(this->name);
+    report.addVector(report.bodyListBytes, this->sats);
+    report.addHashIndex(this->satIndex);
+    for (const auto& sat : this->sats) {
+        if (dynamic_pointer_cast<Satellite>(sat)) {
+            report.satellites++;
+            report.addShared<Satellite>(report.satelliteBytes);
+            report.addName(sat->getName());
+        }
+    }
+}
+
+/// @brief release spare capacity of sats and shrink the name index
+void Planet::shrink() {
+    this->sats.shrink_to_fit();
+    this->satIndex.rehash(0);
+}
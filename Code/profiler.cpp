@@ -0,0 +1,274 @@
+/// @file profiler.cpp
+/// @brief Implementations for the instrumentation layer. Each thread
+///        records into its own table without locking; tables are merged
+///        under a lock only when reported or when their thread exits.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "profiler.h"
+
+using namespace std;
+
+// Local Helper Functions and Data
+
+static const int kMaxRegions = 64;
+// four buckets per power of two, covering up to 2^47 ns (about 39 hours),
+// so a percentile is within 12.5% of the true sample
+static const int kBuckets = 188;
+
+/// @brief samples of one region; only its owning thread writes it, so
+///        relaxed loads and stores are enough for a reader to see whole
+///        values
+struct RegionSlot
+{
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> totalNs{0};
+    atomic<uint64_t> buckets[kBuckets] = {};
+};
+
+struct ThreadTable
+{
+    RegionSlot slots[kMaxRegions];
+};
+
+/// @brief plain totals used while merging and for exited threads
+struct RegionTotals
+{
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t buckets[kBuckets] = {};
+};
+
+struct RegionInfo
+{
+    string name;
+    bool timed;
+};
+
+static mutex &profilerLock() {
+    static mutex lock;
+    return lock;
+}
+
+// guarded by profilerLock
+static vector<RegionInfo> &regionInfo() {
+    static vector<RegionInfo> info;
+    return info;
+}
+
+// guarded by profilerLock
+static vector<ThreadTable *> &liveTables() {
+    static vector<ThreadTable *> tables;
+    return tables;
+}
+
+// guarded by profilerLock, samples of threads that have exited
+static vector<RegionTotals> &retiredTotals() {
+    static vector<RegionTotals> totals(kMaxRegions);
+    return totals;
+}
+
+static int bucketOf(uint64_t ns) {
+    if (ns < 4) {
+        return static_cast<int>(ns);
+    }
+    int octave = 63 - __builtin_clzll(ns);
+    if (octave > 47) {
+        return kBuckets - 1;
+    }
+    int sub = static_cast<int>((ns >> (octave - 2)) & 3);
+    return (octave - 1) * 4 + sub;
+}
+
+/// @return middle of a bucket's range in nanoseconds
+static double bucketMiddle(int bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    int octave = bucket / 4 + 1;
+    int sub = bucket % 4;
+    double low = static_cast<double>(static_cast<uint64_t>(4 + sub) << (octave - 2));
+    double width = static_cast<double>(uint64_t(1) << (octave - 2));
+    return low + width / 2.0;
+}
+
+static void addInto(RegionTotals &totals, const RegionSlot &slot) {
+    totals.count += slot.count.load(memory_order_relaxed);
+    totals.totalNs += slot.totalNs.load(memory_order_relaxed);
+    for (int b = 0; b < kBuckets; b++) {
+        totals.buckets[b] += slot.buckets[b].load(memory_order_relaxed);
+    }
+}
+
+/// @brief nearest rank percentile from a bucket histogram, in nanoseconds
+static double percentileOf(const RegionTotals &totals, double p) {
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * (totals.count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; b++) {
+        seen += totals.buckets[b];
+        if (seen >= rank) {
+            return bucketMiddle(b);
+        }
+    }
+    return bucketMiddle(kBuckets - 1);
+}
+
+/// @brief Owns the calling thread's table, registering it on first use
+///        and folding it into the retired totals when the thread exits.
+class ThreadTableOwner
+{
+    public:
+        ThreadTableOwner() : table(make_unique<ThreadTable>()) {
+            lock_guard<mutex> guard(profilerLock());
+            // construct the retired totals first so they outlive this owner
+            retiredTotals();
+            liveTables().push_back(this->table.get());
+        }
+
+        ~ThreadTableOwner() {
+            lock_guard<mutex> guard(profilerLock());
+            vector<ThreadTable *> &tables = liveTables();
+            tables.erase(remove(tables.begin(), tables.end(), this->table.get()), tables.end());
+            vector<RegionTotals> &retired = retiredTotals();
+            for (int r = 0; r < kMaxRegions; r++) {
+                addInto(retired[r], this->table->slots[r]);
+            }
+        }
+
+        ThreadTable &get() {
+            return *this->table;
+        }
+
+    private:
+        unique_ptr<ThreadTable> table;
+};
+
+static ThreadTable &threadTable() {
+    thread_local ThreadTableOwner owner;
+    return owner.get();
+}
+
+static void bump(atomic<uint64_t> &value, uint64_t amount) {
+    value.store(value.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+
+/// @brief Switch recording on or off.
+/// @param enabled true to record regions
+void setProfiling(bool enabled) {
+    profilingEnabled.store(enabled, memory_order_relaxed);
+}
+
+/// @brief Register a region by name, or find it if already registered.
+/// @param name shown in the report, e.g. "load.celestial"
+/// @param timed true for a timer, false for a counter
+/// @return the region's id, -1 once the region table is full
+int profileRegion(const char *name, bool timed) {
+    lock_guard<mutex> guard(profilerLock());
+    vector<RegionInfo> &info = regionInfo();
+    for (size_t r = 0; r < info.size(); r++) {
+        if (info[r].name == name) {
+            return static_cast<int>(r);
+        }
+    }
+    if (info.size() >= static_cast<size_t>(kMaxRegions)) {
+        return -1;
+    }
+    info.push_back({name, timed});
+    return static_cast<int>(info.size() - 1);
+}
+
+/// @brief Add one timed sample to a region for the calling thread.
+void profileRecord(int region, uint64_t nanoseconds) {
+    if (region < 0) {
+        return;
+    }
+    RegionSlot &slot = threadTable().slots[region];
+    bump(slot.count, 1);
+    bump(slot.totalNs, nanoseconds);
+    bump(slot.buckets[bucketOf(nanoseconds)], 1);
+}
+
+/// @brief Add to a counter region for the calling thread.
+void profileCount(int region, uint64_t amount) {
+    if (region < 0) {
+        return;
+    }
+    bump(threadTable().slots[region].count, amount);
+}
+
+/// @brief Print count, total, mean, p50 and p99 of every region with
+///        samples, merged over every thread. Percentiles come from
+///        power of two buckets split in four.
+/// @param out where to write the report
+void profileReport(ostream &out) {
+    vector<RegionInfo> info;
+    vector<RegionTotals> totals;
+    {
+        lock_guard<mutex> guard(profilerLock());
+        info = regionInfo();
+        totals = retiredTotals();
+        for (ThreadTable *table : liveTables()) {
+            for (size_t r = 0; r < info.size(); r++) {
+                addInto(totals[r], table->slots[r]);
+            }
+        }
+    }
+
+    if (!isProfiling()) {
+        out << "Profiling is off, start with -profile to record regions." << endl;
+    }
+
+    bool any = false;
+    for (size_t r = 0; r < info.size(); r++) {
+        if (totals[r].count == 0) {
+            continue;
+        }
+        if (!any) {
+            out << left << setw(26) << "Region" << right << setw(12) << "Count"
+                << setw(14) << "Total ms" << setw(12) << "Mean us"
+                << setw(12) << "p50 us" << setw(12) << "p99 us" << endl;
+            any = true;
+        }
+
+        const RegionTotals &region = totals[r];
+        out << left << setw(26) << info[r].name << right << setw(12) << region.count;
+        if (info[r].timed) {
+            out << fixed << setprecision(3)
+                << setw(14) << region.totalNs / 1e6
+                << setw(12) << region.totalNs / 1e3 / region.count
+                << setw(12) << percentileOf(region, 50) / 1e3
+                << setw(12) << percentileOf(region, 99) / 1e3 << defaultfloat;
+        }
+        out << endl;
+    }
+    if (!any) {
+        out << "No profiled regions recorded." << endl;
+    }
+}
+
+/// @brief Zero every region on every thread. Samples a thread records
+///        while the reset runs may survive it.
+void profileReset() {
+    lock_guard<mutex> guard(profilerLock());
+    for (RegionTotals &totals : retiredTotals()) {
+        totals = RegionTotals();
+    }
+    for (ThreadTable *table : liveTables()) {
+        for (RegionSlot &slot : table->slots) {
+            slot.count.store(0, memory_order_relaxed);
+            slot.totalNs.store(0, memory_order_relaxed);
+            for (auto &bucket : slot.buckets) {
+                bucket.store(0, memory_order_relaxed);
+            }
+        }
+    }
+}
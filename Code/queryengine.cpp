@@ -0,0 +1,327 @@
+/// @file queryengine.cpp
+/// @brief Implementations for the QueryEngine attribute queries over
+///        stars, planets and satellites.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "queryengine.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief one parsed filter with the index range that satisfies it
+struct Filter
+{
+    const vector<double> *numbers = nullptr;
+    const vector<string> *texts = nullptr;
+    const vector<char> *flags = nullptr;
+    double low = 0.0;
+    double high = 0.0;
+    string text;
+    bool prefix = false;
+    char flag = 0;
+
+    // rows satisfying the filter, from its index
+    const int *first = nullptr;
+    const int *last = nullptr;
+
+    /// @brief check the filter against a row through the column values
+    bool holds(int row) const {
+        if (numbers != nullptr) {
+            double v = (*numbers)[row];
+            return v >= low && v <= high;
+        }
+        if (texts != nullptr) {
+            const string &v = (*texts)[row];
+            return prefix ? v.compare(0, text.size(), text) == 0 : v == text;
+        }
+        return (*flags)[row] == flag;
+    }
+};
+
+/// @brief find a named column in a table's column list
+template <typename Column>
+static const Column *findColumn(const vector<pair<string, Column>> &columns, const string &name) {
+    for (const auto &[columnName, column] : columns) {
+        if (columnName == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+
+/// @brief Build the tables and indexes from every loaded body
+/// @param index the system index to read systems from
+void QueryEngine::build(const SystemIndex &index) {
+    this->stars = Table();
+    this->planets = Table();
+    this->satellites = Table();
+    this->stars.numbers = {{"temperature", {}}, {"mass", {}}};
+    this->stars.texts = {{"type", {}}};
+    this->planets.numbers = {{"period", {}}, {"radius", {}}};
+    this->satellites.flags = {{"natural", {}}};
+
+    for (int id = 0; id < index.size(); id++) {
+        for (const auto &celestial : index.at(id)->getCelestialBodies()) {
+            shared_ptr<Star> star = dynamic_pointer_cast<Star>(celestial);
+            if (star != nullptr) {
+                this->stars.systemIds.push_back(id);
+                this->stars.bodies.push_back(celestial);
+                this->stars.numbers[0].second.values.push_back(star->getTemperature());
+                this->stars.numbers[1].second.values.push_back(star->getMass());
+                this->stars.texts[0].second.values.push_back(star->getSpectralType());
+                continue;
+            }
+
+            shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(celestial);
+            if (planet == nullptr) {
+                continue;
+            }
+            this->planets.systemIds.push_back(id);
+            this->planets.bodies.push_back(celestial);
+            this->planets.numbers[0].second.values.push_back(planet->getOrbitalPeriod());
+            this->planets.numbers[1].second.values.push_back(planet->getRadius());
+
+            for (const auto &sat : planet->getSats()) {
+                shared_ptr<Satellite> satellite = dynamic_pointer_cast<Satellite>(sat);
+                if (satellite != nullptr) {
+                    this->satellites.systemIds.push_back(id);
+                    this->satellites.bodies.push_back(sat);
+                    this->satellites.flags[0].second.values.push_back(satellite->isNatural());
+                }
+            }
+        }
+    }
+
+    for (Table *table : {&this->stars, &this->planets, &this->satellites}) {
+        for (auto &column : table->numbers) {
+            finish(column.second);
+        }
+        for (auto &column : table->texts) {
+            finish(column.second);
+        }
+        for (auto &column : table->flags) {
+            finish(column.second);
+        }
+    }
+
+    this->builtVersion = index.getVersion();
+    this->builtBodiesVersion = index.getBodiesVersion();
+    this->built = true;
+}
+
+/// @return true when systems or bodies changed since the last build
+bool QueryEngine::isStale(const SystemIndex &index) const {
+    return !this->built || this->builtVersion != index.getVersion() ||
+           this->builtBodiesVersion != index.getBodiesVersion();
+}
+
+/// @brief Run a query. Every filter is turned into a range of its sorted
+///        index; the smallest range supplies the candidate rows and the
+///        other filters are checked against their column values.
+/// @param query the body type and filters, see queryengine.h
+/// @return the matching rows and their systems
+QueryResult QueryEngine::run(const string &query) const {
+    auto started = chrono::steady_clock::now();
+    QueryResult result;
+
+    istringstream tokens(query);
+    string typeName;
+    tokens >> typeName;
+    if (typeName == "star") {
+        result.type = BodyType::Star;
+    } else if (typeName == "planet") {
+        result.type = BodyType::Planet;
+    } else if (typeName == "satellite") {
+        result.type = BodyType::Satellite;
+    } else {
+        throw invalid_argument("Unknown body type: " + typeName);
+    }
+    const Table &table = this->tableFor(result.type);
+
+    vector<Filter> filters;
+    string token;
+    while (tokens >> token) {
+        size_t opPos = token.find_first_of("<>=");
+        if (opPos == string::npos || opPos == 0) {
+            throw invalid_argument("Bad filter: " + token);
+        }
+        string field = token.substr(0, opPos);
+        size_t valuePos = (token.size() > opPos + 1 && token[opPos + 1] == '=') ? opPos + 2 : opPos + 1;
+        string op = token.substr(opPos, valuePos - opPos);
+        string value = token.substr(valuePos);
+        if (value.empty() || op == "==") {
+            throw invalid_argument("Bad filter: " + token);
+        }
+
+        Filter filter;
+        if (const NumberColumn *column = findColumn(table.numbers, field)) {
+            const double infinity = numeric_limits<double>::infinity();
+            filter.numbers = &column->values;
+            filter.low = -infinity;
+            filter.high = infinity;
+            size_t dots = value.find("..");
+            if (op == "=" && dots != string::npos) {
+                filter.low = stod(value.substr(0, dots));
+                filter.high = stod(value.substr(dots + 2));
+            } else if (op == "=") {
+                filter.low = filter.high = stod(value);
+            } else if (op == "<") {
+                filter.high = nextafter(stod(value), -infinity);
+            } else if (op == "<=") {
+                filter.high = stod(value);
+            } else if (op == ">") {
+                filter.low = nextafter(stod(value), infinity);
+            } else {
+                filter.low = stod(value);
+            }
+
+            auto lo = lower_bound(column->sortedValues.begin(), column->sortedValues.end(), filter.low);
+            auto hi = upper_bound(lo, column->sortedValues.end(), filter.high);
+            filter.first = column->sortedRows.data() + (lo - column->sortedValues.begin());
+            filter.last = column->sortedRows.data() + (hi - column->sortedValues.begin());
+        } else if (const TextColumn *column = findColumn(table.texts, field)) {
+            if (op != "=") {
+                throw invalid_argument("Text filters only take =: " + token);
+            }
+            filter.texts = &column->values;
+            filter.prefix = value.back() == '*';
+            filter.text = filter.prefix ? value.substr(0, value.size() - 1) : value;
+
+            const vector<string> &values = column->values;
+            const string &text = filter.text;
+            bool prefix = filter.prefix;
+            auto lo = lower_bound(column->sortedRows.begin(), column->sortedRows.end(), text,
+                                  [&values](int row, const string &key) { return values[row] < key; });
+            auto hi = partition_point(lo, column->sortedRows.end(), [&values, &text, prefix](int row) {
+                return prefix ? values[row].compare(0, text.size(), text) == 0 : values[row] == text;
+            });
+            filter.first = column->sortedRows.data() + (lo - column->sortedRows.begin());
+            filter.last = column->sortedRows.data() + (hi - column->sortedRows.begin());
+        } else if (const FlagColumn *column = findColumn(table.flags, field)) {
+            if (op != "=" || (value != "yes" && value != "no")) {
+                throw invalid_argument("Flag filters take =yes or =no: " + token);
+            }
+            filter.flags = &column->values;
+            filter.flag = value == "yes";
+            const vector<int> &rows = filter.flag ? column->yesRows : column->noRows;
+            filter.first = rows.data();
+            filter.last = rows.data() + rows.size();
+        } else {
+            throw invalid_argument("Unknown field for " + typeName + ": " + field);
+        }
+        filters.push_back(filter);
+    }
+
+    if (filters.empty()) {
+        result.candidates = table.bodies.size();
+        for (int row = 0; row < static_cast<int>(table.bodies.size()); row++) {
+            result.rows.push_back(row);
+        }
+    } else {
+        // the smallest range drives, the other filters are checked per row
+        size_t driver = 0;
+        for (size_t i = 1; i < filters.size(); i++) {
+            if (filters[i].last - filters[i].first < filters[driver].last - filters[driver].first) {
+                driver = i;
+            }
+        }
+
+        const Filter &drive = filters[driver];
+        result.candidates = drive.last - drive.first;
+        for (const int *row = drive.first; row != drive.last; row++) {
+            bool keep = true;
+            for (size_t i = 0; i < filters.size() && keep; i++) {
+                keep = (i == driver) || filters[i].holds(*row);
+            }
+            if (keep) {
+                result.rows.push_back(*row);
+            }
+        }
+        sort(result.rows.begin(), result.rows.end());
+    }
+
+    for (int row : result.rows) {
+        result.systemIds.push_back(table.systemIds[row]);
+    }
+    sort(result.systemIds.begin(), result.systemIds.end());
+    result.systemIds.erase(unique(result.systemIds.begin(), result.systemIds.end()), result.systemIds.end());
+
+    result.elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+/// @return the body at a row of a type's table
+shared_ptr<Celestial> QueryEngine::bodyAt(BodyType type, int row) const {
+    return this->tableFor(type).bodies.at(row);
+}
+
+/// @return the id of the system the body at a row belongs to
+int QueryEngine::systemAt(BodyType type, int row) const {
+    return this->tableFor(type).systemIds.at(row);
+}
+
+/// @return number of rows in a type's table
+int QueryEngine::numRows(BodyType type) const {
+    return this->tableFor(type).bodies.size();
+}
+
+/// @brief sort a numeric column, keeping the row of every value
+void QueryEngine::finish(NumberColumn &column) {
+    vector<int> order(column.values.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&column](int a, int b) {
+        return column.values[a] < column.values[b];
+    });
+
+    column.sortedRows = order;
+    column.sortedValues.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        column.sortedValues[i] = column.values[order[i]];
+    }
+}
+
+/// @brief sort the rows of a text column by their value
+void QueryEngine::finish(TextColumn &column) {
+    column.sortedRows.resize(column.values.size());
+    for (size_t i = 0; i < column.sortedRows.size(); i++) {
+        column.sortedRows[i] = i;
+    }
+    stable_sort(column.sortedRows.begin(), column.sortedRows.end(), [&column](int a, int b) {
+        return column.values[a] < column.values[b];
+    });
+}
+
+/// @brief split the rows of a flag column by their value
+void QueryEngine::finish(FlagColumn &column) {
+    for (size_t i = 0; i < column.values.size(); i++) {
+        (column.values[i] ? column.yesRows : column.noRows).push_back(i);
+    }
+}
+
+/// @return the table holding bodies of a type
+const QueryEngine::Table &QueryEngine::tableFor(BodyType type) const {
+    switch (type) {
+        case BodyType::Star:
+            return this->stars;
+        case BodyType::Planet:
+            return this->planets;
+        default:
+            return this->satellites;
+    }
+}
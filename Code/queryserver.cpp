@@ -0,0 +1,445 @@
+/// @file queryserver.cpp
+/// @brief Implementations for the Unix domain socket query server.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "universesnapshot.h"
+#include "serverprotocol.h"
+#include "profiler.h"
+#include "queryserver.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief wake the event loop; write is safe in a signal handler
+static void wake(int fd) {
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        // the counter is already non zero, the loop will wake anyway
+    }
+}
+
+/// @return the id of a named system, or sets error when there is none
+static int requireSystem(const UniverseSnapshot &snapshot, const string &name, string &error) {
+    int id = snapshot.idOf(name);
+    if (id == -1 && error.empty()) {
+        error = "ERROR\nUnknown system: " + name;
+    }
+    return id;
+}
+
+
+/// @return one line summary
+string ServerStats::toString() const {
+    ostringstream out;
+    out << "Served " << this->requests << " requests to " << this->clients << " clients, "
+        << this->errors << " answered with an error, " << this->badFrames << " bad frames.";
+    return out.str();
+}
+
+/// @param publisher where workers read the universe from
+/// @param workers number of worker threads, at least 1
+QueryServer::QueryServer(SnapshotPublisher &publisher, int workers)
+    : publisher(publisher), numWorkers(max(1, workers)) {}
+
+/// @brief Stop serving and release the socket
+QueryServer::~QueryServer() {
+    this->shutDown();
+}
+
+/// @brief Listen on the socket path and serve until stop is called.
+/// @param socketPath file system path of the socket
+void QueryServer::run(const string &socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Socket path is empty or too long: " + socketPath);
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    // only ever replace a socket a previous server left behind
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw runtime_error("Not replacing " + socketPath + ", it is not a socket.");
+        }
+        unlink(socketPath.c_str());
+    }
+
+    this->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (this->listenFd < 0 ||
+        bind(this->listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(this->listenFd, SOMAXCONN) < 0) {
+        string reason = strerror(errno);
+        this->shutDown();
+        throw runtime_error("Unable to listen on " + socketPath + ": " + reason);
+    }
+    this->socketPath = socketPath;
+
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    this->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event listenEvent{EPOLLIN, {.u64 = 0}};
+    epoll_event wakeEvent{EPOLLIN, {.u64 = 1}};
+    if (this->epollFd < 0 || this->wakeFd < 0 ||
+        epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->listenFd, &listenEvent) < 0 ||
+        epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->wakeFd, &wakeEvent) < 0) {
+        string reason = strerror(errno);
+        this->shutDown();
+        throw runtime_error("Unable to start the event loop: " + reason);
+    }
+
+    for (int w = 0; w < this->numWorkers; w++) {
+        this->workers.emplace_back(&QueryServer::work, this);
+    }
+
+    epoll_event events[64];
+    while (!this->stopping.load()) {
+        int ready = epoll_wait(this->epollFd, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int e = 0; e < ready; e++) {
+            uint64_t id = events[e].data.u64;
+            if (id == 0) {
+                this->acceptClients();
+                continue;
+            }
+            if (id == 1) {
+                uint64_t count;
+                while (read(this->wakeFd, &count, sizeof(count)) > 0) {
+                }
+                this->collectAnswers();
+                continue;
+            }
+
+            auto found = this->connections.find(id);
+            if (found == this->connections.end()) {
+                continue; // dropped earlier in this batch
+            }
+            Connection &client = found->second;
+            if (events[e].events & EPOLLOUT) {
+                if (!this->writeClient(id, client)) {
+                    continue;
+                }
+            }
+            if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                this->readClient(id, client);
+            }
+        }
+    }
+    this->shutDown();
+}
+
+/// @brief Make run return. Safe to call from a signal handler.
+void QueryServer::stop() {
+    this->stopping.store(true);
+    if (this->wakeFd >= 0) {
+        wake(this->wakeFd);
+    }
+}
+
+/// @return counters, complete once run has returned
+ServerStats QueryServer::getStats() const {
+    ServerStats stats = this->stats;
+    stats.errors = this->errorCount.load();
+    return stats;
+}
+
+/// @brief Answer one request payload from a snapshot.
+/// @param snapshot the universe to answer from
+/// @param scratch the calling thread's route search arrays
+/// @param request the request's lines, command first
+/// @return the response payload
+string QueryServer::answer(const UniverseSnapshot &snapshot, RouteScratch &scratch, const string &request) {
+    vector<string> lines = splitLines(request);
+    const string &command = lines.at(0);
+    string error;
+
+    if (command == "PING") {
+        return "OK\nPONG";
+    }
+
+    if (command == "ROUTE") {
+        PROFILE_SCOPE("serve.route");
+        if (lines.size() != 3) {
+            return "ERROR\nROUTE takes a start and an end system.";
+        }
+        int start = requireSystem(snapshot, lines[1], error);
+        int end = requireSystem(snapshot, lines[2], error);
+        if (!error.empty()) {
+            return error;
+        }
+        vector<int> route;
+        if (!snapshot.findRoute(start, end, route, scratch)) {
+            return "ERROR\nNo route from " + lines[1] + " to " + lines[2] + ".";
+        }
+        string response = "OK\n";
+        for (size_t i = 0; i < route.size(); i++) {
+            response += (i > 0 ? " -> " : "") + snapshot.nameOf(route[i]);
+        }
+        return response + "\n" + to_string(route.size() - 1) + " hops";
+    }
+
+    if (command == "VALIDATE") {
+        PROFILE_SCOPE("serve.validate");
+        if (lines.size() < 2) {
+            return "ERROR\nVALIDATE takes at least one system.";
+        }
+        vector<int> path;
+        for (size_t i = 1; i < lines.size(); i++) {
+            path.push_back(requireSystem(snapshot, lines[i], error));
+        }
+        if (!error.empty()) {
+            return error;
+        }
+        const RoutePlanner &planner = snapshot.getPlanner();
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            auto [first, last] = planner.neighbors(planner.vertexOf(path[i]));
+            if (find(first, last, planner.vertexOf(path[i + 1])) == last) {
+                return "OK\nInvalid path, route not connected.";
+            }
+        }
+        return "OK\nPath is valid, ready to explore!";
+    }
+
+    if (command == "DETAILS") {
+        PROFILE_SCOPE("serve.details");
+        if (lines.size() != 2) {
+            return "ERROR\nDETAILS takes one system.";
+        }
+        int id = requireSystem(snapshot, lines[1], error);
+        return error.empty() ? "OK\n" + snapshot.detailsOf(id) : error;
+    }
+
+    if (command == "STATS") {
+        return "OK\n" + snapshot.getStatsText();
+    }
+
+    if (command == "NAMES") {
+        string response = "OK";
+        for (int id = 0; id < snapshot.size(); id++) {
+            response += "\n" + snapshot.nameOf(id);
+        }
+        return response;
+    }
+
+    return "ERROR\nUnknown command: " + command;
+}
+
+/// @brief worker thread: answer jobs from the current snapshot
+void QueryServer::work() {
+    SnapshotReader reader(this->publisher);
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> lock(this->jobsLock);
+            this->jobsReady.wait(lock, [this]() { return this->stopping.load() || !this->jobs.empty(); });
+            if (this->stopping.load()) {
+                return;
+            }
+            job = move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+
+        string response;
+        {
+            SnapshotReader::Pin snapshot = reader.pin();
+            response = snapshot ? answer(*snapshot, reader.getScratch(), job.request) : "ERROR\nNo data loaded.";
+        }
+        if (response.compare(0, 5, "ERROR") == 0) {
+            this->errorCount.fetch_add(1, memory_order_relaxed);
+        }
+
+        job.request = encodeFrame(response);
+        {
+            lock_guard<mutex> lock(this->answersLock);
+            this->answers.push_back(move(job));
+        }
+        wake(this->wakeFd);
+    }
+}
+
+/// @brief accept every waiting client
+void QueryServer::acceptClients() {
+    while (true) {
+        int fd = accept4(this->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN, or out of descriptors until a client leaves
+        }
+        uint64_t id = this->nextId++;
+        epoll_event event{EPOLLIN, {.u64 = id}};
+        if (epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        Connection &client = this->connections[id];
+        client.fd = fd;
+        client.events = EPOLLIN;
+        this->stats.clients++;
+    }
+}
+
+/// @brief take what the client sent and hand on a whole request
+void QueryServer::readClient(uint64_t id, Connection &client) {
+    char block[1 << 16];
+    while (client.in.size() < kMaxFrameBytes + 4) {
+        ssize_t got = recv(client.fd, block, sizeof(block), 0);
+        if (got > 0) {
+            client.in.append(block, got);
+            continue;
+        }
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        // closed by the client; an answer still being worked is dropped
+        this->drop(id);
+        return;
+    }
+    this->dispatch(id, client);
+}
+
+/// @brief send as much of the pending output as the socket takes
+/// @return false when the connection was dropped
+bool QueryServer::writeClient(uint64_t id, Connection &client) {
+    size_t sent = 0;
+    while (sent < client.out.size()) {
+        ssize_t wrote = send(client.fd, client.out.data() + sent, client.out.size() - sent, MSG_NOSIGNAL);
+        if (wrote > 0) {
+            sent += wrote;
+            continue;
+        }
+        if (wrote < 0 && errno == EINTR) {
+            continue;
+        }
+        if (wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        this->drop(id);
+        return false;
+    }
+    client.out.erase(0, sent);
+    this->watch(id, client);
+    return true;
+}
+
+/// @brief hand the next whole request to the workers unless one is
+///        already out for this connection
+void QueryServer::dispatch(uint64_t id, Connection &client) {
+    if (!client.busy) {
+        string request;
+        int taken = decodeFrame(client.in, request);
+        if (taken < 0) {
+            this->stats.badFrames++;
+            this->drop(id);
+            return;
+        }
+        if (taken > 0) {
+            client.busy = true;
+            this->stats.requests++;
+            {
+                lock_guard<mutex> lock(this->jobsLock);
+                this->jobs.push_back({id, move(request)});
+            }
+            this->jobsReady.notify_one();
+        }
+    }
+    this->watch(id, client);
+}
+
+/// @brief queue finished answers for their connections
+void QueryServer::collectAnswers() {
+    vector<Job> finished;
+    {
+        lock_guard<mutex> lock(this->answersLock);
+        finished.swap(this->answers);
+    }
+    for (Job &job : finished) {
+        auto found = this->connections.find(job.connection);
+        if (found == this->connections.end()) {
+            continue; // the client left while it was being answered
+        }
+        Connection &client = found->second;
+        client.busy = false;
+        client.out += job.request;
+        if (this->writeClient(job.connection, client)) {
+            this->dispatch(job.connection, client);
+        }
+    }
+}
+
+/// @brief read while the input buffer has room, write while output waits
+void QueryServer::watch(uint64_t id, Connection &client) {
+    uint32_t wanted = 0;
+    if (client.in.size() < kMaxFrameBytes + 4) {
+        wanted |= EPOLLIN;
+    }
+    if (!client.out.empty()) {
+        wanted |= EPOLLOUT;
+    }
+    if (wanted != client.events) {
+        epoll_event event{wanted, {.u64 = id}};
+        epoll_ctl(this->epollFd, EPOLL_CTL_MOD, client.fd, &event);
+        client.events = wanted;
+    }
+}
+
+/// @brief close a connection and forget it
+void QueryServer::drop(uint64_t id) {
+    auto found = this->connections.find(id);
+    if (found == this->connections.end()) {
+        return;
+    }
+    epoll_ctl(this->epollFd, EPOLL_CTL_DEL, found->second.fd, nullptr);
+    close(found->second.fd);
+    this->connections.erase(found);
+}
+
+/// @brief join the workers, close every descriptor and remove the socket
+void QueryServer::shutDown() {
+    {
+        lock_guard<mutex> lock(this->jobsLock);
+        this->stopping.store(true);
+        this->jobs.clear();
+    }
+    this->jobsReady.notify_all();
+    for (thread &worker : this->workers) {
+        worker.join();
+    }
+    this->workers.clear();
+
+    for (auto &[id, client] : this->connections) {
+        close(client.fd);
+    }
+    this->connections.clear();
+    for (int *fd : {&this->listenFd, &this->epollFd, &this->wakeFd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    if (!this->socketPath.empty()) {
+        unlink(this->socketPath.c_str());
+        this->socketPath.clear();
+    }
+}
@@ -0,0 +1,872 @@
+/// @file routeplanner.cpp
+/// @brief Implementations for the RoutePlanner A* search over the
+///        Solar System connection graph.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "routeplanner.h"
+#include "profiler.h"
+
+using namespace std;
+
+// Local Helper Functions
+static const uint16_t kUnreached = 0xFFFF; // no route between the two
+static const uint16_t kFarthest = 0xFFFE;  // longer routes are stored as this
+static const int kGuideDistance = 1;
+static const int kGuideLandmarks = 2;
+static const int kActiveLandmarks = 4;     // landmarks consulted per query
+static void hopsFrom(int source, const vector<int> &offsets, const vector<int> &targets,
+                     vector<uint16_t> &table, int column, int columns);
+static vector<int> orderSystems(const vector<int> &offsets, const vector<int> &targets, SystemOrder order);
+
+/// @brief Snapshot the connections and positions of the index. The
+///        heuristic is switched on only when every system taking part in a
+///        connection has a position, otherwise a hop through an unplaced
+///        system could cover any distance and the bound would not hold.
+/// @param index the system index to snapshot
+void RoutePlanner::build(const SystemIndex &index) {
+    int n = index.size();
+    this->offsets.assign(n + 1, 0);
+    this->targets.clear();
+    this->coords.assign(n * 3, 0.0);
+    this->maxJump = 0.0;
+    this->heuristic = true;
+
+    vector<bool> positioned(n);
+    for (int id = 0; id < n; id++) {
+        shared_ptr<SolarSystem> system = index.at(id);
+        positioned[id] = system->hasPosition();
+        this->coords[id * 3] = system->getX();
+        this->coords[id * 3 + 1] = system->getY();
+        this->coords[id * 3 + 2] = system->getZ();
+    }
+
+    for (int id = 0; id < n; id++) {
+        for (int to : index.neighbors(id)) {
+            this->targets.push_back(to);
+            if (!positioned[id] || !positioned[to]) {
+                this->heuristic = false;
+                continue;
+            }
+            double dx = this->coords[id * 3] - this->coords[to * 3];
+            double dy = this->coords[id * 3 + 1] - this->coords[to * 3 + 1];
+            double dz = this->coords[id * 3 + 2] - this->coords[to * 3 + 2];
+            this->maxJump = max(this->maxJump, sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        this->offsets[id + 1] = this->targets.size();
+    }
+    if (this->maxJump <= 0.0) {
+        this->heuristic = false;
+    }
+
+    this->renumber();
+    this->buildLandmarks();
+    this->scratch = RouteScratch();
+    this->builtVersion = index.getVersion();
+    this->built = true;
+}
+
+/// @brief Snapshot a bare graph given as compressed rows. Systems have no
+///        positions, so routes are guided by landmarks alone if any.
+void RoutePlanner::build(vector<int> offsets, vector<int> targets) {
+    this->offsets = move(offsets);
+    this->targets = move(targets);
+    if (this->offsets.empty()) {
+        this->offsets.push_back(0);
+    }
+    this->coords.assign((this->offsets.size() - 1) * 3, 0.0);
+    this->maxJump = 0.0;
+    this->heuristic = false;
+
+    this->renumber();
+    this->buildLandmarks();
+    this->scratch = RouteScratch();
+    this->builtVersion = 0;
+    this->built = true;
+}
+
+/// @brief Have every build compute landmark tables
+/// @param count landmarks to pick, 0 for none; a few dozen at most pay off
+/// @param choice how to pick them
+void RoutePlanner::setLandmarks(int count, LandmarkChoice choice) {
+    this->landmarksWanted = max(0, count);
+    this->landmarkChoice = choice;
+}
+
+/// @brief Have every build renumber the systems of its snapshot
+void RoutePlanner::setOrder(SystemOrder order) {
+    this->order = order;
+}
+
+/// @return number of landmarks in the tables of the last build
+int RoutePlanner::landmarkCount() const {
+    return this->landmarks.size();
+}
+
+/// @return bytes held by the landmark tables
+size_t RoutePlanner::landmarkBytes() const {
+    return (this->fromLandmark.size() + this->toLandmark.size()) * sizeof(uint16_t) +
+           this->landmarks.size() * sizeof(int);
+}
+
+/// @return true when the index changed since the last build
+bool RoutePlanner::isStale(const SystemIndex &index) const {
+    return !this->built || this->builtVersion != index.getVersion();
+}
+
+/// @return true when the distance heuristic is in use
+bool RoutePlanner::usesHeuristic() const {
+    return this->heuristic;
+}
+
+/// @brief Find a route with the fewest hops, guided by the heuristic
+bool RoutePlanner::findRoute(int start, int end, vector<int> &route, RouteStats *stats) const {
+    PROFILE_SCOPE("route.astar");
+    return this->search(start, end, this->guidesAvailable(), route, this->scratch, stats);
+}
+
+/// @brief Find a route with the fewest hops without the heuristic
+bool RoutePlanner::findRouteUninformed(int start, int end, vector<int> &route, RouteStats *stats) const {
+    PROFILE_SCOPE("route.uninformed");
+    return this->search(start, end, 0, route, this->scratch, stats);
+}
+
+/// @brief Find a route with the fewest hops guided by the landmarks alone,
+///        uninformed when there are none
+bool RoutePlanner::findRouteLandmarks(int start, int end, vector<int> &route, RouteStats *stats) const {
+    PROFILE_SCOPE("route.landmarks");
+    return this->search(start, end, this->guidesAvailable() & kGuideLandmarks, route, this->scratch, stats);
+}
+
+/// @brief Find a route with the fewest hops, guided by the heuristic, in
+///        the caller's scratch arrays
+bool RoutePlanner::findRoute(int start, int end, vector<int> &route, RouteScratch &scratch,
+                             RouteStats *stats) const {
+    PROFILE_SCOPE("route.astar");
+    return this->search(start, end, this->guidesAvailable(), route, scratch, stats);
+}
+
+/// @return number of systems in the snapshot
+int RoutePlanner::size() const {
+    return this->offsets.empty() ? 0 : this->offsets.size() - 1;
+}
+
+/// @return vertices connected from a vertex, empty when out of range
+pair<const int *, const int *> RoutePlanner::neighbors(int vertex) const {
+    if (vertex < 0 || vertex >= this->size()) {
+        return {nullptr, nullptr};
+    }
+    const int *first = this->targets.data();
+    return {first + this->offsets[vertex], first + this->offsets[vertex + 1]};
+}
+
+/// @brief Lower bound on the hops from a system to the end. No connection
+///        is longer than maxJump, so covering distance d takes at least
+///        ceil(d / maxJump) hops, and neighbouring systems differ by at most
+///        one which keeps the estimate consistent.
+int RoutePlanner::estimate(int from, int end) const {
+    double dx = this->coords[from * 3] - this->coords[end * 3];
+    double dy = this->coords[from * 3 + 1] - this->coords[end * 3 + 1];
+    double dz = this->coords[from * 3 + 2] - this->coords[end * 3 + 2];
+    // the small slack keeps rounding error from overestimating
+    return static_cast<int>(ceil(sqrt(dx * dx + dy * dy + dz * dz) / this->maxJump - 1e-9));
+}
+
+/// @brief Chain one search per leg, start to each waypoint in turn to end.
+///        Legs are independent since systems may be passed again, so the
+///        shortest legs make the shortest route. Before searching, the
+///        lower bounds of all legs are checked against the hop limit; each
+///        leg may then use only what the legs after it leave over, and
+///        drops any system whose bound would overrun that.
+bool RoutePlanner::findConstrainedRoute(int start, int end, const RouteConstraints &constraints,
+                                        vector<int> &route, RouteStats *stats) const {
+    PROFILE_SCOPE("route.constrained");
+    auto started = chrono::steady_clock::now();
+    route.clear();
+    if (stats != nullptr) {
+        *stats = RouteStats();
+    }
+
+    vector<int> stops = {start};
+    stops.insert(stops.end(), constraints.waypoints.begin(), constraints.waypoints.end());
+    stops.push_back(end);
+    int n = this->size();
+    for (int stop : stops) {
+        if (stop < 0 || stop >= n || constraints.avoid.contains(stop)) {
+            return false;
+        }
+    }
+
+    // lower bounds on every leg, and on all the legs after each one
+    int guides = this->guidesAvailable();
+    int legs = stops.size() - 1;
+    vector<int> boundAfter(legs + 1, 0);
+    if (guides & kGuideLandmarks) {
+        this->chooseActiveLandmarks(this->vertexOf(start), this->vertexOf(end), this->scratch.landmarks);
+    }
+    for (int leg = legs - 1; leg >= 0; leg--) {
+        int bound = this->guess(this->vertexOf(stops[leg]), this->vertexOf(stops[leg + 1]), guides,
+                                this->scratch.landmarks);
+        if (bound < 0) {
+            return false;
+        }
+        boundAfter[leg] = boundAfter[leg + 1] + bound;
+    }
+    if (constraints.maxHops >= 0 && boundAfter[0] > constraints.maxHops) {
+        return false;
+    }
+
+    vector<int> legRoute;
+    RouteStats legStats;
+    int hops = 0;
+    route.push_back(start);
+    for (int leg = 0; leg < legs; leg++) {
+        // a found leg stays within its limit, so what is left never
+        // drops below the bounds of the legs after it
+        int limit = -1;
+        if (constraints.maxHops >= 0) {
+            limit = max(0, constraints.maxHops - hops - boundAfter[leg + 1]);
+        }
+        bool found = this->search(stops[leg], stops[leg + 1], guides, legRoute, this->scratch,
+                                  &legStats, &constraints.avoid, limit);
+        if (stats != nullptr) {
+            stats->settled += legStats.settled;
+        }
+        if (!found) {
+            route.clear();
+            break;
+        }
+        route.insert(route.end(), legRoute.begin() + 1, legRoute.end());
+        hops += legRoute.size() - 1;
+    }
+
+    if (stats != nullptr) {
+        stats->elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+    return !route.empty();
+}
+
+/// @brief Breadth first over labels of (system, fuel left), so labels are
+///        made in order of hops. A new label is kept only when it reaches
+///        its system with more fuel than every label before it there:
+///        those have no more hops, so they dominate it otherwise. Since the
+///        tank fills at refuel systems, few labels survive per system.
+bool RoutePlanner::findRangedRoute(int start, int end, double range, const SystemSet &refuel,
+                                   vector<int> &route, RouteStats *stats) const {
+    PROFILE_SCOPE("route.ranged");
+    auto started = chrono::steady_clock::now();
+    route.clear();
+    int n = this->size();
+    if (start < 0 || end < 0 || start >= n || end >= n || range < 0.0) {
+        return false;
+    }
+    start = this->vertexOf(start);
+    end = this->vertexOf(end);
+
+    RouteScratch &scratch = this->scratch;
+    if (scratch.stamp.size() != static_cast<size_t>(n)) {
+        scratch.stamp.assign(n, 0);
+        scratch.hops.assign(n, 0);
+        scratch.parent.assign(n, -1);
+        scratch.currentStamp = 0;
+    }
+    if (scratch.fuel.size() != static_cast<size_t>(n)) {
+        scratch.fuel.assign(n, 0.0);
+    }
+    if (++scratch.currentStamp == 0) {
+        fill(scratch.stamp.begin(), scratch.stamp.end(), 0);
+        scratch.currentStamp = 1;
+    }
+    const unsigned seen = scratch.currentStamp;
+
+    struct Label
+    {
+        int system;
+        int parent; // label this one was reached from
+        double fuel;
+    };
+    vector<Label> labels = {{start, -1, range}};
+    scratch.stamp[start] = seen;
+    scratch.fuel[start] = range;
+    int reached = start == end ? 0 : -1;
+    size_t next = 0;
+    for (; next < labels.size() && reached == -1; next++) {
+        Label label = labels[next];
+        for (int i = this->offsets[label.system]; i < this->offsets[label.system + 1] && reached == -1; i++) {
+            int to = this->targets[i];
+            double left = label.fuel - this->jump(label.system, to);
+            if (left < 0.0) {
+                continue;
+            }
+            if (refuel.contains(this->systemOf(to))) {
+                left = range;
+            }
+            if (scratch.stamp[to] == seen && left <= scratch.fuel[to]) {
+                continue; // dominated
+            }
+            scratch.stamp[to] = seen;
+            scratch.fuel[to] = left;
+            labels.push_back({to, static_cast<int>(next), left});
+            if (to == end) {
+                reached = labels.size() - 1;
+            }
+        }
+    }
+
+    if (reached != -1) {
+        for (int at = reached; at != -1; at = labels[at].parent) {
+            route.push_back(this->systemOf(labels[at].system));
+        }
+        reverse(route.begin(), route.end());
+    }
+
+    PROFILE_COUNT("route.settled", next);
+    if (stats != nullptr) {
+        stats->settled = next;
+        stats->elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+    return reached != -1;
+}
+
+/// @brief Breadth first from every origin at once, keeping only the
+///        current frontier and a visited bitmap. Stops after maxHops rings,
+///        when a ring comes up empty, or once every system is reached.
+long RoutePlanner::findReachable(const vector<int> &origins, int maxHops,
+                                 const function<void(int hops, const vector<int> &systems)> &ring) const {
+    PROFILE_SCOPE("route.reachable");
+    int n = this->size();
+    SystemSet visited(n);
+    vector<int> frontier, next, ids;
+    for (int origin : origins) {
+        int vertex = this->vertexOf(origin);
+        if (origin >= 0 && origin < n && !visited.contains(vertex)) {
+            visited.insert(vertex);
+            frontier.push_back(vertex);
+        }
+    }
+
+    long reached = 0;
+    for (int hops = 0; !frontier.empty(); hops++) {
+        if (this->systems.empty()) {
+            ring(hops, frontier);
+        } else {
+            ids.resize(frontier.size());
+            for (size_t i = 0; i < frontier.size(); i++) {
+                ids[i] = this->systems[frontier[i]];
+            }
+            ring(hops, ids);
+        }
+        reached += frontier.size();
+        if (hops == maxHops || reached == n) {
+            break;
+        }
+        next.clear();
+        for (int from : frontier) {
+            for (int i = this->offsets[from]; i < this->offsets[from + 1]; i++) {
+                int to = this->targets[i];
+                if (!visited.contains(to)) {
+                    visited.insert(to);
+                    next.push_back(to);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+    return reached;
+}
+
+/// @return fuel a jump between two systems burns
+double RoutePlanner::jumpLength(int from, int to) const {
+    return this->jump(this->vertexOf(from), this->vertexOf(to));
+}
+
+/// @return straight line length of a jump between two vertices when the
+///         distance heuristic is on, which needs every connected system
+///         placed, otherwise 1
+double RoutePlanner::jump(int from, int to) const {
+    if (!this->heuristic) {
+        return 1.0;
+    }
+    double dx = this->coords[from * 3] - this->coords[to * 3];
+    double dy = this->coords[from * 3 + 1] - this->coords[to * 3 + 1];
+    double dz = this->coords[from * 3 + 2] - this->coords[to * 3 + 2];
+    return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/// @brief Mark each system with a star of a suitable spectral class, or
+///        with an artificial satellite when the policy allows them.
+/// @return the systems a ship can refuel at
+SystemSet findRefuelSystems(const SystemIndex &index, const RefuelPolicy &policy) {
+    PROFILE_SCOPE("route.refuel");
+    SystemSet refuel;
+    for (int id = 0; id < index.size(); id++) {
+        for (const auto &body : index.at(id)->getCelestialBodies()) {
+            bool suitable = false;
+            if (shared_ptr<Star> star = dynamic_pointer_cast<Star>(body)) {
+                string type = star->getSpectralType();
+                suitable = !type.empty() && policy.starClasses.find(type.at(0)) != string::npos;
+            } else if (shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(body)) {
+                for (const auto &sat : planet->getSats()) {
+                    shared_ptr<Satellite> satellite = dynamic_pointer_cast<Satellite>(sat);
+                    suitable = suitable || (policy.artificialSatellites && satellite != nullptr && !satellite->isNatural());
+                }
+            }
+            if (suitable) {
+                refuel.insert(id);
+                break;
+            }
+        }
+    }
+    return refuel;
+}
+
+/// @brief An empty set with room for ids below systems
+SystemSet::SystemSet(int systems) : words((max(0, systems) + 63) / 64, 0) {}
+
+/// @brief Add a system, growing the set as needed
+void SystemSet::insert(int id) {
+    size_t word = static_cast<size_t>(id) >> 6;
+    if (word >= this->words.size()) {
+        this->words.resize(word + 1, 0);
+    }
+    this->words[word] |= uint64_t(1) << (id & 63);
+}
+
+/// @return number of systems in the set
+int SystemSet::count() const {
+    int total = 0;
+    for (uint64_t word : this->words) {
+        total += __builtin_popcountll(word);
+    }
+    return total;
+}
+
+/// @brief Lower bound on the hops from a system to the end from the
+///        landmark tables. For a landmark L, hops(L, end) - hops(L, from)
+///        and hops(from, L) - hops(end, L) both bound hops(from, end) by
+///        the triangle inequality; the best over the active landmarks is
+///        taken. Each term moves by at most one along a connection, so the
+///        bound stays consistent. Hops stored as kFarthest may be more,
+///        which can only lower a term: the larger of the two is then
+///        kFarthest itself, and the smaller is exact or kFarthest too.
+/// @return the bound, -1 when the tables show end cannot be reached
+int RoutePlanner::landmarkEstimate(int from, int end, const vector<int> &active) const {
+    const size_t columns = this->landmarks.size();
+    const uint16_t *fromRow = &this->fromLandmark[from * columns];
+    const uint16_t *endFromRow = &this->fromLandmark[end * columns];
+    const uint16_t *toRow = &this->toLandmark[from * columns];
+    const uint16_t *endToRow = &this->toLandmark[end * columns];
+    int bound = 0;
+    for (int i : active) {
+        // L reaches from but not end, or end reaches L but from does not:
+        // either way nothing leads from there to end
+        if ((fromRow[i] != kUnreached && endFromRow[i] == kUnreached) ||
+            (endToRow[i] != kUnreached && toRow[i] == kUnreached)) {
+            return -1;
+        }
+        if (fromRow[i] != kUnreached) {
+            bound = max(bound, endFromRow[i] - fromRow[i]);
+        }
+        if (endToRow[i] != kUnreached) {
+            bound = max(bound, toRow[i] - endToRow[i]);
+        }
+    }
+    return bound;
+}
+
+/// @brief Pick the landmarks giving the best bounds between start and end,
+///        a few being nearly as tight as all of them and much cheaper
+void RoutePlanner::chooseActiveLandmarks(int start, int end, vector<int> &active) const {
+    int columns = this->landmarks.size();
+    vector<pair<int, int>> ranked; // (-bound, landmark), proofs of no route first
+    vector<int> one(1);
+    for (int i = 0; i < columns; i++) {
+        one[0] = i;
+        int bound = this->landmarkEstimate(start, end, one);
+        ranked.push_back({bound < 0 ? INT_MIN : -bound, i});
+    }
+    int keep = min(columns, kActiveLandmarks);
+    partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end());
+    active.clear();
+    for (int i = 0; i < keep; i++) {
+        active.push_back(ranked[i].second);
+    }
+}
+
+/// @return the estimate of the hops from a system to the end under the
+///         given guides, -1 when end cannot be reached from it
+int RoutePlanner::guess(int from, int end, int guides, const vector<int> &active) const {
+    int hops = 0;
+    if ((guides & kGuideDistance) != 0) {
+        hops = this->estimate(from, end);
+    }
+    if ((guides & kGuideLandmarks) != 0) {
+        int bound = this->landmarkEstimate(from, end, active);
+        if (bound < 0) {
+            return -1;
+        }
+        hops = max(hops, bound);
+    }
+    return hops;
+}
+
+/// @return the guides findRoute uses: distance when its bound holds,
+///         landmarks when there are tables
+int RoutePlanner::guidesAvailable() const {
+    return (this->heuristic ? kGuideDistance : 0) | (this->landmarks.empty() ? 0 : kGuideLandmarks);
+}
+
+/// @brief A* on hop count, or plain best first search on hops when
+///        uninformed. Ties on estimated total prefer more hops done,
+///        which settles fewer systems on long corridors. Systems the
+///        landmarks show cannot reach the end are never queued, nor are
+///        avoided systems or those whose hops plus estimate pass hopLimit.
+/// @param avoid systems not to enter, or nullptr
+/// @param hopLimit most hops allowed, -1 for no limit
+bool RoutePlanner::search(int start, int end, int guides, vector<int> &route, RouteScratch &scratch,
+                          RouteStats *stats, const SystemSet *avoid, int hopLimit) const {
+    auto started = chrono::steady_clock::now();
+    route.clear();
+    int n = this->offsets.size() - 1;
+    if (start < 0 || end < 0 || start >= n || end >= n) {
+        return false;
+    }
+    start = this->vertexOf(start);
+    end = this->vertexOf(end);
+
+    // scratch sized for another snapshot starts over
+    if (scratch.stamp.size() != static_cast<size_t>(n)) {
+        scratch.stamp.assign(n, 0);
+        scratch.hops.assign(n, 0);
+        scratch.parent.assign(n, -1);
+        scratch.currentStamp = 0;
+    }
+
+    // a fresh stamp marks every system unvisited without touching the arrays
+    if (++scratch.currentStamp == 0) {
+        fill(scratch.stamp.begin(), scratch.stamp.end(), 0);
+        scratch.currentStamp = 1;
+    }
+    const unsigned seen = scratch.currentStamp;
+    if ((guides & kGuideLandmarks) != 0) {
+        this->chooseActiveLandmarks(start, end, scratch.landmarks);
+    }
+
+    // entries are (estimated total, -hops so far, system id)
+    using Entry = tuple<int, int, int>;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> open;
+    scratch.stamp[start] = seen;
+    scratch.hops[start] = 0;
+    scratch.parent[start] = -1;
+    int settled = 0;
+    bool found = false;
+    if (hopLimit < 0) {
+        hopLimit = INT_MAX;
+    }
+    int h = this->guess(start, end, guides, scratch.landmarks);
+    if (h >= 0 && h <= hopLimit) {
+        open.emplace(h, 0, start);
+    }
+    while (!open.empty()) {
+        auto [f, negG, v] = open.top();
+        open.pop();
+        if (-negG != scratch.hops[v]) {
+            continue; // stale queue entry
+        }
+        settled++;
+        if (v == end) {
+            found = true;
+            break;
+        }
+
+        int g = scratch.hops[v] + 1;
+        for (int i = this->offsets[v]; i < this->offsets[v + 1]; i++) {
+            int to = this->targets[i];
+            if ((scratch.stamp[to] == seen && scratch.hops[to] <= g) ||
+                (avoid != nullptr && avoid->contains(this->systemOf(to)))) {
+                continue;
+            }
+            int toGo = this->guess(to, end, guides, scratch.landmarks);
+            scratch.stamp[to] = seen;
+            scratch.hops[to] = g;
+            scratch.parent[to] = v;
+            if (toGo >= 0 && g + toGo <= hopLimit) {
+                open.emplace(g + toGo, -g, to);
+            }
+        }
+    }
+
+    if (found) {
+        for (int v = end; v != -1; v = scratch.parent[v]) {
+            route.push_back(this->systemOf(v));
+        }
+        reverse(route.begin(), route.end());
+    }
+
+    PROFILE_COUNT("route.settled", settled);
+    if (stats != nullptr) {
+        stats->settled = settled;
+        stats->elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+    return found;
+}
+
+/// @brief Renumber the rows, targets and positions of the snapshot in the
+///        chosen order, the targets of each row ascending. Landmarks are
+///        picked afterwards, on the new numbering.
+void RoutePlanner::renumber() {
+    this->vertices.clear();
+    this->systems.clear();
+    int n = this->size();
+    if (this->order == SystemOrder::Load || n == 0) {
+        return;
+    }
+
+    this->systems = orderSystems(this->offsets, this->targets, this->order);
+    this->vertices.assign(n, 0);
+    for (int v = 0; v < n; v++) {
+        this->vertices[this->systems[v]] = v;
+    }
+    vector<int> offsets(n + 1, 0), targets(this->targets.size());
+    vector<double> coords(this->coords.size());
+    for (int v = 0; v < n; v++) {
+        int id = this->systems[v];
+        int at = offsets[v];
+        for (int i = this->offsets[id]; i < this->offsets[id + 1]; i++) {
+            targets[at++] = this->vertices[this->targets[i]];
+        }
+        sort(targets.begin() + offsets[v], targets.begin() + at);
+        offsets[v + 1] = at;
+        copy_n(&this->coords[static_cast<size_t>(id) * 3], 3, &coords[static_cast<size_t>(v) * 3]);
+    }
+    this->offsets.swap(offsets);
+    this->targets.swap(targets);
+    this->coords.swap(coords);
+}
+
+/// @brief Pick the landmarks and fill both hop tables with a breadth first
+///        search from each landmark, forward over the connections and
+///        backward over them reversed. Hop counts past kFarthest are
+///        stored as kFarthest, which only weakens the bounds; kUnreached
+///        is kept for systems no route joins to the landmark.
+void RoutePlanner::buildLandmarks() {
+    this->landmarks.clear();
+    this->fromLandmark.clear();
+    this->toLandmark.clear();
+    int n = this->size();
+    if (this->landmarksWanted == 0 || n == 0) {
+        return;
+    }
+
+    // the connections reversed, as compressed rows
+    vector<int> reverseOffsets(n + 1, 0), reverseTargets(this->targets.size());
+    for (int to : this->targets) {
+        reverseOffsets[to + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        reverseOffsets[v + 1] += reverseOffsets[v];
+    }
+    vector<int> slot(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (int v = 0; v < n; v++) {
+        for (int i = this->offsets[v]; i < this->offsets[v + 1]; i++) {
+            reverseTargets[slot[this->targets[i]]++] = v;
+        }
+    }
+
+    // only connected systems are worth a column
+    vector<int> degree(n);
+    for (int v = 0; v < n; v++) {
+        degree[v] = this->offsets[v + 1] - this->offsets[v] + reverseOffsets[v + 1] - reverseOffsets[v];
+    }
+    int candidates = n - count(degree.begin(), degree.end(), 0);
+    int columns = min(this->landmarksWanted, candidates);
+    if (columns == 0) {
+        return; // no connections, so nothing to measure from
+    }
+    this->fromLandmark.assign(static_cast<size_t>(n) * columns, kUnreached);
+    this->toLandmark.assign(static_cast<size_t>(n) * columns, kUnreached);
+
+    vector<int> picked;
+    if (this->landmarkChoice == LandmarkChoice::Degree) {
+        // best connected first, skipping neighbours of those already taken
+        vector<int> order(n);
+        for (int v = 0; v < n; v++) {
+            order[v] = v;
+        }
+        stable_sort(order.begin(), order.end(), [&](int a, int b) { return degree[a] > degree[b]; });
+        vector<bool> blocked(n, false);
+        for (int v : order) {
+            if (static_cast<int>(picked.size()) == columns || degree[v] == 0) {
+                break;
+            }
+            if (blocked[v]) {
+                continue;
+            }
+            picked.push_back(v);
+            blocked[v] = true;
+            for (int i = this->offsets[v]; i < this->offsets[v + 1]; i++) {
+                blocked[this->targets[i]] = true;
+            }
+            for (int i = reverseOffsets[v]; i < reverseOffsets[v + 1]; i++) {
+                blocked[reverseTargets[i]] = true;
+            }
+        }
+    }
+
+    // farthest: start from the connected system farthest from the first
+    // connected one, then keep taking the system farthest from every
+    // landmark so far, unreached systems first
+    vector<int> nearest(n, kUnreached);
+    vector<uint16_t> probe;
+    if (this->landmarkChoice == LandmarkChoice::Farthest) {
+        int first = find_if(degree.begin(), degree.end(), [](int d) { return d > 0; }) - degree.begin();
+        probe.assign(n, kUnreached);
+        hopsFrom(first, this->offsets, this->targets, probe, 0, 1);
+        int farthest = first;
+        for (int v = 0; v < n; v++) {
+            if (probe[v] != kUnreached && probe[v] > probe[farthest]) {
+                farthest = v;
+            }
+        }
+        picked.push_back(farthest);
+    }
+
+    for (int column = 0; column < static_cast<int>(picked.size()); column++) {
+        int landmark = picked[column];
+        hopsFrom(landmark, this->offsets, this->targets, this->fromLandmark, column, columns);
+        hopsFrom(landmark, reverseOffsets, reverseTargets, this->toLandmark, column, columns);
+
+        if (this->landmarkChoice == LandmarkChoice::Farthest && static_cast<int>(picked.size()) < columns) {
+            int next = -1;
+            for (int v = 0; v < n; v++) {
+                size_t cell = static_cast<size_t>(v) * columns + column;
+                nearest[v] = min({nearest[v], static_cast<int>(this->fromLandmark[cell]),
+                                  static_cast<int>(this->toLandmark[cell])});
+                if (degree[v] > 0 && nearest[v] > 0 && (next == -1 || nearest[v] > nearest[next])) {
+                    next = v;
+                }
+            }
+            if (next != -1) {
+                picked.push_back(next);
+            }
+        }
+    }
+
+    // fewer landmarks than columns only when the graph ran out of systems
+    if (static_cast<int>(picked.size()) < columns) {
+        vector<uint16_t> from, to;
+        for (int v = 0; v < n; v++) {
+            for (size_t c = 0; c < picked.size(); c++) {
+                from.push_back(this->fromLandmark[static_cast<size_t>(v) * columns + c]);
+                to.push_back(this->toLandmark[static_cast<size_t>(v) * columns + c]);
+            }
+        }
+        this->fromLandmark.swap(from);
+        this->toLandmark.swap(to);
+    }
+    this->landmarks = picked;
+}
+
+/// @brief breadth first search writing hop counts into one column of a
+///        table with a row per system
+static void hopsFrom(int source, const vector<int> &offsets, const vector<int> &targets,
+                     vector<uint16_t> &table, int column, int columns) {
+    vector<int> frontier = {source}, next;
+    table[static_cast<size_t>(source) * columns + column] = 0;
+    for (int hops = 1; !frontier.empty(); hops++) {
+        next.clear();
+        for (int v : frontier) {
+            for (int i = offsets[v]; i < offsets[v + 1]; i++) {
+                uint16_t &cell = table[static_cast<size_t>(targets[i]) * columns + column];
+                if (cell == kUnreached) {
+                    cell = min(hops, static_cast<int>(kFarthest));
+                    next.push_back(targets[i]);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+}
+
+/// @brief Number the systems for a build, see SystemOrder. Bfs and Rcm
+///        follow connections either way and take whole components one
+///        after another; Rcm starts each at a least connected system and
+///        queues neighbours least connected first, then reverses it all.
+/// @return system ids in their new order
+static vector<int> orderSystems(const vector<int> &offsets, const vector<int> &targets, SystemOrder order) {
+    int n = offsets.size() - 1;
+
+    // connections either way, as compressed rows
+    vector<int> bothOffsets(n + 1, 0), both(targets.size() * 2);
+    for (int v = 0; v < n; v++) {
+        bothOffsets[v + 1] += offsets[v + 1] - offsets[v];
+        for (int i = offsets[v]; i < offsets[v + 1]; i++) {
+            bothOffsets[targets[i] + 1]++;
+        }
+    }
+    partial_sum(bothOffsets.begin(), bothOffsets.end(), bothOffsets.begin());
+    vector<int> slot(bothOffsets.begin(), bothOffsets.end() - 1);
+    for (int v = 0; v < n; v++) {
+        for (int i = offsets[v]; i < offsets[v + 1]; i++) {
+            both[slot[v]++] = targets[i];
+            both[slot[targets[i]]++] = v;
+        }
+    }
+    vector<int> degree(n);
+    for (int v = 0; v < n; v++) {
+        degree[v] = bothOffsets[v + 1] - bothOffsets[v];
+    }
+
+    vector<int> ranked(n);
+    iota(ranked.begin(), ranked.end(), 0);
+    if (order == SystemOrder::Degree) {
+        stable_sort(ranked.begin(), ranked.end(), [&](int a, int b) { return degree[a] > degree[b]; });
+        return ranked;
+    }
+    auto fewer = [&](int a, int b) { return degree[a] < degree[b]; };
+    if (order == SystemOrder::Rcm) {
+        stable_sort(ranked.begin(), ranked.end(), fewer);
+    }
+
+    vector<int> numbered;
+    numbered.reserve(n);
+    vector<bool> placed(n, false);
+    for (int seed : ranked) {
+        if (placed[seed]) {
+            continue;
+        }
+        placed[seed] = true;
+        numbered.push_back(seed);
+        for (size_t head = numbered.size() - 1; head < numbered.size(); head++) {
+            int v = numbered[head];
+            size_t queued = numbered.size();
+            for (int i = bothOffsets[v]; i < bothOffsets[v + 1]; i++) {
+                if (!placed[both[i]]) {
+                    placed[both[i]] = true;
+                    numbered.push_back(both[i]);
+                }
+            }
+            if (order == SystemOrder::Rcm) {
+                stable_sort(numbered.begin() + queued, numbered.end(), fewer);
+            }
+        }
+    }
+    if (order == SystemOrder::Rcm) {
+        reverse(numbered.begin(), numbered.end());
+    }
+    return numbered;
+}
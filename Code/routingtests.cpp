@@ -0,0 +1,455 @@
+/// @file routingtests.cpp
+/// @brief Test suite cases for the route planner, contraction hierarchy,
+///        itinerary planner and spatial index, checked against a plain
+///        breadth first search and a scan of every system.
+///        Utilized by the Interstellar Travel App.
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "spatialindex.h"
+#include "routeplanner.h"
+#include "contractionhierarchy.h"
+#include "itineraryplanner.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief systems SYS0.. with three random one way connections each and
+///        random positions in a 10 unit cube
+static void makeUniverse(int numSystems, unsigned seed, vector<shared_ptr<SolarSystem>> &systems,
+                         SystemIndex &index) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> pick(0, max(0, numSystems - 1));
+    uniform_real_distribution<double> coordinate(0.0, 10.0);
+    for (int i = 0; i < numSystems; i++) {
+        systems.push_back(make_shared<SolarSystem>("SYS" + to_string(i)));
+    }
+    index.sync(systems);
+    for (int id = 0; id < numSystems; id++) {
+        index.setPosition(id, coordinate(rng), coordinate(rng), coordinate(rng));
+        for (int k = 0; k < 3 && numSystems > 1; k++) {
+            int target = pick(rng);
+            if (target != id) {
+                index.connect(id, target);
+            }
+        }
+    }
+}
+
+/// @return hops from the origins to every system, -1 when unreachable;
+///         systems in skip are never entered and, given a planner, jumps
+///         longer than range are never taken
+static vector<int> plainBfs(const SystemIndex &index, const vector<int> &origins,
+                            const SystemSet &skip = SystemSet(),
+                            const RoutePlanner *planner = nullptr, double range = 0.0) {
+    vector<int> hops(index.size(), -1);
+    queue<int> frontier;
+    for (int origin : origins) {
+        if (hops[origin] == -1 && !skip.contains(origin)) {
+            hops[origin] = 0;
+            frontier.push(origin);
+        }
+    }
+    while (!frontier.empty()) {
+        int from = frontier.front();
+        frontier.pop();
+        for (int to : index.neighbors(from)) {
+            if (hops[to] != -1 || skip.contains(to)) {
+                continue;
+            }
+            if (planner != nullptr && planner->jumpLength(from, to) > range) {
+                continue;
+            }
+            hops[to] = hops[from] + 1;
+            frontier.push(to);
+        }
+    }
+    return hops;
+}
+
+/// @return true when each step of route follows a connection of the index
+static bool followsConnections(const SystemIndex &index, const vector<int> &route) {
+    for (size_t i = 0; i + 1 < route.size(); i++) {
+        const vector<int> &targets = index.neighbors(route[i]);
+        if (find(targets.begin(), targets.end(), route[i + 1]) == targets.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief a random universe shared by the tests below
+class RoutingTest : public ::testing::Test
+{
+    protected:
+        static constexpr int kSystems = 400;
+
+        void SetUp() override {
+            makeUniverse(kSystems, 211, this->systems, this->index);
+            this->planner.build(this->index);
+        }
+
+        vector<shared_ptr<SolarSystem>> systems;
+        SystemIndex index;
+        RoutePlanner planner;
+};
+
+
+TEST_F(RoutingTest, FewestHopsMatchBfs) {
+    RoutePlanner withLandmarks;
+    withLandmarks.setLandmarks(4);
+    withLandmarks.build(this->index);
+    ASSERT_EQ(withLandmarks.landmarkCount(), 4);
+    RoutePlanner reordered;
+    reordered.setOrder(SystemOrder::Rcm);
+    reordered.build(this->index);
+
+    vector<int> route;
+    for (int start = 0; start < kSystems; start += 37) {
+        vector<int> hops = plainBfs(this->index, {start});
+        for (int end = 0; end < kSystems; end += 13) {
+            for (const RoutePlanner *searched : {&this->planner, &withLandmarks, &reordered}) {
+                bool found = searched->findRoute(start, end, route);
+                ASSERT_EQ(found, hops[end] != -1) << start << " to " << end;
+                if (found) {
+                    EXPECT_EQ(static_cast<int>(route.size()) - 1, hops[end]);
+                    EXPECT_EQ(route.front(), start);
+                    EXPECT_EQ(route.back(), end);
+                    EXPECT_TRUE(followsConnections(this->index, route));
+                }
+            }
+            bool found = withLandmarks.findRouteLandmarks(start, end, route);
+            ASSERT_EQ(found, hops[end] != -1) << start << " to " << end;
+            if (found) {
+                EXPECT_EQ(static_cast<int>(route.size()) - 1, hops[end]);
+            }
+        }
+    }
+}
+
+TEST_F(RoutingTest, ContractionHierarchyMatchesBfs) {
+    ContractionHierarchy hierarchy;
+    hierarchy.build(this->index);
+    ASSERT_EQ(hierarchy.size(), kSystems);
+    EXPECT_FALSE(hierarchy.isStale(this->index));
+
+    vector<int> route;
+    for (int start = 0; start < kSystems; start += 29) {
+        vector<int> hops = plainBfs(this->index, {start});
+        for (int end = 0; end < kSystems; end += 7) {
+            bool found = hierarchy.findRoute(start, end, route);
+            ASSERT_EQ(found, hops[end] != -1) << start << " to " << end;
+            if (found) {
+                EXPECT_EQ(static_cast<int>(route.size()) - 1, hops[end]);
+                EXPECT_EQ(route.front(), start);
+                EXPECT_EQ(route.back(), end);
+                EXPECT_TRUE(followsConnections(this->index, route));
+            }
+        }
+    }
+
+    this->index.connect(0, 1);
+    this->index.connect(1, 0);
+    EXPECT_TRUE(hierarchy.isStale(this->index));
+}
+
+TEST_F(RoutingTest, AvoidedSystemsMatchBfs) {
+    RouteConstraints constraints;
+    for (int id = 5; id < kSystems; id += 11) {
+        constraints.avoid.insert(id);
+    }
+
+    vector<int> route;
+    for (int start = 0; start < kSystems; start += 41) {
+        vector<int> hops = plainBfs(this->index, {start}, constraints.avoid);
+        for (int end = 0; end < kSystems; end += 17) {
+            bool found = this->planner.findConstrainedRoute(start, end, constraints, route);
+            ASSERT_EQ(found, hops[end] != -1) << start << " to " << end;
+            if (found) {
+                EXPECT_EQ(static_cast<int>(route.size()) - 1, hops[end]);
+                EXPECT_TRUE(followsConnections(this->index, route));
+                for (int id : route) {
+                    EXPECT_FALSE(constraints.avoid.contains(id));
+                }
+            }
+        }
+    }
+}
+
+TEST_F(RoutingTest, WaypointsAndHopLimitMatchBfs) {
+    vector<int> route;
+    for (int start = 0; start < kSystems; start += 53) {
+        int waypoint = (start * 7 + 3) % kSystems;
+        vector<int> fromStart = plainBfs(this->index, {start});
+        vector<int> fromWaypoint = plainBfs(this->index, {waypoint});
+        for (int end = 0; end < kSystems; end += 19) {
+            int expected = fromStart[waypoint] == -1 || fromWaypoint[end] == -1
+                ? -1 : fromStart[waypoint] + fromWaypoint[end];
+
+            RouteConstraints constraints;
+            constraints.waypoints = {waypoint};
+            bool found = this->planner.findConstrainedRoute(start, end, constraints, route);
+            ASSERT_EQ(found, expected != -1) << start << " via " << waypoint << " to " << end;
+            if (found) {
+                EXPECT_EQ(static_cast<int>(route.size()) - 1, expected);
+                EXPECT_NE(find(route.begin(), route.end(), waypoint), route.end());
+                EXPECT_TRUE(followsConnections(this->index, route));
+            }
+
+            // a limit one short of the fewest hops leaves no route
+            if (fromStart[end] > 0) {
+                RouteConstraints limited;
+                limited.maxHops = fromStart[end];
+                EXPECT_TRUE(this->planner.findConstrainedRoute(start, end, limited, route));
+                limited.maxHops = fromStart[end] - 1;
+                EXPECT_FALSE(this->planner.findConstrainedRoute(start, end, limited, route));
+            }
+        }
+    }
+}
+
+TEST_F(RoutingTest, RangedRouteMatchesBfsOverShortJumps) {
+    // with fuel at every system a ship can take exactly the jumps in range
+    SystemSet everywhere(kSystems);
+    for (int id = 0; id < kSystems; id++) {
+        everywhere.insert(id);
+    }
+
+    vector<int> route;
+    for (double range : {4.0, 6.0, 1000.0}) {
+        for (int start = 0; start < kSystems; start += 43) {
+            vector<int> hops = plainBfs(this->index, {start}, SystemSet(), &this->planner, range);
+            for (int end = 0; end < kSystems; end += 23) {
+                bool found = this->planner.findRangedRoute(start, end, range, everywhere, route);
+                ASSERT_EQ(found, hops[end] != -1) << start << " to " << end << " range " << range;
+                if (found) {
+                    EXPECT_EQ(static_cast<int>(route.size()) - 1, hops[end]);
+                    EXPECT_TRUE(followsConnections(this->index, route));
+                    for (size_t i = 0; i + 1 < route.size(); i++) {
+                        EXPECT_LE(this->planner.jumpLength(route[i], route[i + 1]), range);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(RoutingTest, ReachableRingsMatchBfs) {
+    const vector<int> origins = {3, 150, 3};
+    for (int maxHops : {0, 2, -1}) {
+        vector<int> hops = plainBfs(this->index, origins);
+        vector<int> ringOf(kSystems, -1);
+        int lastRing = -1;
+        long reached = this->planner.findReachable(origins, maxHops, [&](int ring, const vector<int> &ids) {
+            EXPECT_EQ(ring, lastRing + 1);
+            lastRing = ring;
+            for (int id : ids) {
+                EXPECT_EQ(ringOf[id], -1) << id << " reported twice";
+                ringOf[id] = ring;
+            }
+        });
+
+        long expected = 0;
+        for (int id = 0; id < kSystems; id++) {
+            int want = maxHops >= 0 && hops[id] > maxHops ? -1 : hops[id];
+            EXPECT_EQ(ringOf[id], want) << "system " << id;
+            expected += want != -1;
+        }
+        EXPECT_EQ(reached, expected);
+    }
+}
+
+TEST_F(RoutingTest, ReorderingKeepsSystemIds) {
+    vector<int> hops = plainBfs(this->index, {7});
+    for (SystemOrder order : {SystemOrder::Bfs, SystemOrder::Rcm, SystemOrder::Degree}) {
+        RoutePlanner reordered;
+        reordered.setOrder(order);
+        reordered.build(this->index);
+
+        // neighbors works on the snapshot's numbering, queries on ids
+        for (int id = 0; id < kSystems; id++) {
+            ASSERT_EQ(reordered.systemOf(reordered.vertexOf(id)), id);
+            auto [first, last] = reordered.neighbors(reordered.vertexOf(id));
+            vector<int> targets;
+            for (const int *v = first; v != last; v++) {
+                targets.push_back(reordered.systemOf(*v));
+            }
+            vector<int> expected = this->index.neighbors(id);
+            sort(targets.begin(), targets.end());
+            sort(expected.begin(), expected.end());
+            EXPECT_EQ(targets, expected) << "system " << id;
+        }
+
+        vector<int> ringOf(kSystems, -1);
+        reordered.findReachable({7}, -1, [&](int ring, const vector<int> &ids) {
+            for (int id : ids) {
+                ringOf[id] = ring;
+            }
+        });
+        EXPECT_EQ(ringOf, hops);
+    }
+}
+
+TEST_F(RoutingTest, NearestMatchesAScan) {
+    SpatialIndex spatial;
+    spatial.build(this->index);
+    ASSERT_EQ(spatial.size(), kSystems);
+
+    const double point[3] = {5.0, 2.5, 7.5};
+    vector<double> distances;
+    for (int id = 0; id < kSystems; id++) {
+        const shared_ptr<SolarSystem> &system = this->index.at(id);
+        distances.push_back(hypot(system->getX() - point[0], system->getY() - point[1], system->getZ() - point[2]));
+    }
+    sort(distances.begin(), distances.end());
+
+    vector<pair<int, double>> found = spatial.nearest(point[0], point[1], point[2], 10);
+    ASSERT_EQ(found.size(), 10u);
+    for (size_t i = 0; i < found.size(); i++) {
+        EXPECT_DOUBLE_EQ(found[i].second, distances[i]);
+    }
+}
+
+TEST_F(RoutingTest, NearestCapsTheCount) {
+    SpatialIndex spatial;
+    spatial.build(this->index);
+    EXPECT_EQ(spatial.nearest(1.0, 1.0, 1.0, INT_MAX).size(), static_cast<size_t>(kSystems));
+    EXPECT_EQ(spatial.nearest(1.0, 1.0, 1.0, kSystems + 1).size(), static_cast<size_t>(kSystems));
+    EXPECT_TRUE(spatial.nearest(1.0, 1.0, 1.0, 0).empty());
+    EXPECT_TRUE(spatial.nearest(1.0, 1.0, 1.0, -5).empty());
+}
+
+TEST(RoutingEdgeCases, EmptyGraph) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    index.sync(systems);
+
+    RoutePlanner planner;
+    planner.setLandmarks(4);
+    planner.build(index);
+    vector<int> route;
+    EXPECT_EQ(planner.size(), 0);
+    EXPECT_EQ(planner.landmarkCount(), 0);
+    EXPECT_FALSE(planner.findRoute(0, 0, route));
+    EXPECT_EQ(planner.findReachable({0}, -1, [](int, const vector<int> &) {}), 0);
+
+    ContractionHierarchy hierarchy;
+    hierarchy.build(index);
+    EXPECT_FALSE(hierarchy.findRoute(0, 0, route));
+
+    SpatialIndex spatial;
+    spatial.build(index);
+    EXPECT_TRUE(spatial.nearest(0.0, 0.0, 0.0, 3).empty());
+}
+
+TEST(RoutingEdgeCases, SystemsWithoutConnections) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    systems.push_back(make_shared<SolarSystem>("SYS0"));
+    systems.push_back(make_shared<SolarSystem>("SYS1"));
+    index.sync(systems);
+
+    RoutePlanner planner;
+    planner.setLandmarks(4);
+    planner.build(index);
+    vector<int> route;
+    EXPECT_FALSE(planner.findRoute(0, 1, route));
+    EXPECT_FALSE(planner.findRouteLandmarks(1, 0, route));
+}
+
+TEST(RoutingEdgeCases, SingleSystemRoutesToItself) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    makeUniverse(1, 5, systems, index);
+
+    RoutePlanner planner;
+    planner.setLandmarks(2);
+    planner.build(index);
+    vector<int> route;
+    ASSERT_TRUE(planner.findRoute(0, 0, route));
+    EXPECT_EQ(route, vector<int>({0}));
+    ASSERT_TRUE(planner.findConstrainedRoute(0, 0, RouteConstraints(), route));
+    EXPECT_EQ(route, vector<int>({0}));
+
+    ContractionHierarchy hierarchy;
+    hierarchy.build(index);
+    ASSERT_TRUE(hierarchy.findRoute(0, 0, route));
+    EXPECT_EQ(route, vector<int>({0}));
+}
+
+TEST(RoutingEdgeCases, UnknownSystems) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    makeUniverse(20, 9, systems, index);
+    EXPECT_EQ(index.idOf("NOWHERE"), -1);
+
+    RoutePlanner planner;
+    planner.build(index);
+    ContractionHierarchy hierarchy;
+    hierarchy.build(index);
+    vector<int> route;
+    for (auto [start, end] : {pair<int, int>{-1, 3}, {3, -1}, {0, 20}, {20, 0}}) {
+        EXPECT_FALSE(planner.findRoute(start, end, route));
+        EXPECT_FALSE(planner.findConstrainedRoute(start, end, RouteConstraints(), route));
+        EXPECT_FALSE(hierarchy.findRoute(start, end, route));
+    }
+    EXPECT_EQ(planner.findReachable({-1, 20}, -1, [](int, const vector<int> &) {}), 0);
+}
+
+TEST(RoutingEdgeCases, LongChainStaysReachableWithLandmarks) {
+    // longer than a landmark table entry can count
+    const int numSystems = 70000;
+    vector<int> offsets(numSystems + 1), targets;
+    for (int v = 0; v < numSystems; v++) {
+        offsets[v] = targets.size();
+        if (v + 1 < numSystems) {
+            targets.push_back(v + 1);
+        }
+    }
+    offsets[numSystems] = targets.size();
+
+    RoutePlanner planner;
+    planner.setLandmarks(2);
+    planner.build(offsets, targets);
+    vector<int> route;
+    ASSERT_TRUE(planner.findRoute(0, numSystems - 1, route));
+    EXPECT_EQ(static_cast<int>(route.size()), numSystems);
+    EXPECT_FALSE(planner.findRoute(numSystems - 1, 0, route));
+}
+
+TEST(ItineraryPlanner, ExactSolverIsBounded) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    makeUniverse(30, 13, systems, index);
+    RoutePlanner planner;
+    planner.build(index);
+    ItineraryPlanner itineraries(planner);
+
+    const int n = ItineraryPlanner::kMaxExact + 1;
+    vector<int> matrix(n * n, 1);
+    EXPECT_THROW(itineraries.solveExact(matrix, n), invalid_argument);
+
+    // a limit above kMaxExact is clamped, so plan falls back to the heuristic
+    itineraries.setExactLimit(1000);
+    vector<int> stops(n);
+    for (int i = 0; i < n; i++) {
+        stops[i] = i;
+    }
+    Itinerary itinerary;
+    ItineraryStats stats;
+    itineraries.plan(stops, itinerary, &stats);
+    EXPECT_FALSE(stats.exact);
+    EXPECT_EQ(stats.stops, n);
+}
@@ -0,0 +1,146 @@
+/// @file serverprotocol.cpp
+/// @brief Implementations for the query server's framing helpers.
+///        Utilized by the Interstellar Travel App and the loadclient tool.
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "serverprotocol.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief send every byte, retrying short writes
+static bool sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+/// @brief receive exactly length bytes
+static bool receiveAll(int fd, char *data, size_t length) {
+    while (length > 0) {
+        ssize_t got = recv(fd, data, length, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        length -= got;
+    }
+    return true;
+}
+
+
+/// @return payload with its length prefix
+string encodeFrame(const string &payload) {
+    uint32_t length = payload.size();
+    string frame(4, '\0');
+    frame[0] = static_cast<char>(length >> 24);
+    frame[1] = static_cast<char>(length >> 16);
+    frame[2] = static_cast<char>(length >> 8);
+    frame[3] = static_cast<char>(length);
+    frame += payload;
+    return frame;
+}
+
+/// @brief Take one whole frame off the front of a receive buffer.
+/// @param buffer bytes received so far, the frame is erased from it
+/// @param payload set to the frame's text
+/// @return 1 when a frame was taken, 0 when more bytes are needed, -1
+///         when the length is too large
+int decodeFrame(string &buffer, string &payload) {
+    if (buffer.size() < 4) {
+        return 0;
+    }
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(buffer.data());
+    uint32_t length = static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 |
+                      static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+    if (length > kMaxFrameBytes) {
+        return -1;
+    }
+    if (buffer.size() < 4 + static_cast<size_t>(length)) {
+        return 0;
+    }
+    payload.assign(buffer, 4, length);
+    buffer.erase(0, 4 + length);
+    return 1;
+}
+
+/// @brief Split a request or response into its lines.
+vector<string> splitLines(const string &payload) {
+    vector<string> lines;
+    size_t start = 0;
+    while (start <= payload.size()) {
+        size_t end = payload.find('\n', start);
+        if (end == string::npos) {
+            end = payload.size();
+        }
+        lines.push_back(payload.substr(start, end - start));
+        start = end + 1;
+    }
+    return lines;
+}
+
+/// @brief Connect a blocking socket to a server.
+/// @return the socket, -1 with errno set on failure
+int connectToServer(const string &socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+/// @brief Send one frame on a blocking socket.
+/// @return false when the connection failed
+bool sendFrame(int fd, const string &payload) {
+    string frame = encodeFrame(payload);
+    return sendAll(fd, frame.data(), frame.size());
+}
+
+/// @brief Receive one frame on a blocking socket.
+/// @return false when the connection closed or sent a bad frame
+bool receiveFrame(int fd, string &payload) {
+    unsigned char header[4];
+    if (!receiveAll(fd, reinterpret_cast<char *>(header), 4)) {
+        return false;
+    }
+    uint32_t length = static_cast<uint32_t>(header[0]) << 24 | static_cast<uint32_t>(header[1]) << 16 |
+                      static_cast<uint32_t>(header[2]) << 8 | header[3];
+    if (length > kMaxFrameBytes) {
+        return false;
+    }
+    payload.resize(length);
+    return length == 0 || receiveAll(fd, &payload[0], length);
+}
@@ -0,0 +1,185 @@
+/// @file snapshottests.cpp
+/// @brief Test suite cases for publishing universe snapshots while reader
+///        threads search them, and reclaiming the old ones.
+///        Utilized by the Interstellar Travel App.
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "celestial.h"
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "routeplanner.h"
+#include "universesnapshot.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief systems SYS0.. with no connections yet
+static void makeSystems(int numSystems, vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    for (int i = 0; i < numSystems; i++) {
+        systems.push_back(make_shared<SolarSystem>("SYS" + to_string(i)));
+    }
+    index.sync(systems);
+}
+
+/// @brief Connect every system to the next one, in a ring, and also to the
+///        system stride places on, so the connection count tells the
+///        version apart.
+static void connectRing(SystemIndex &index, int stride) {
+    index.clearConnections();
+    int n = index.size();
+    for (int id = 0; id < n; id++) {
+        index.connect(id, (id + 1) % n);
+        if (stride > 1) {
+            index.connect(id, (id + stride) % n);
+        }
+    }
+}
+
+/// @return connections in a planner
+static long countConnections(const RoutePlanner &planner) {
+    long connections = 0;
+    for (int v = 0; v < planner.size(); v++) {
+        auto [first, last] = planner.neighbors(v);
+        connections += last - first;
+    }
+    return connections;
+}
+
+
+TEST(SnapshotPublisher, NothingBeforeTheFirstPublish) {
+    SnapshotPublisher publisher;
+    EXPECT_EQ(publisher.current(), nullptr);
+    SnapshotReader reader(publisher);
+    SnapshotReader::Pin pin = reader.pin();
+    EXPECT_FALSE(pin);
+}
+
+TEST(SnapshotPublisher, SnapshotsDoNotSeeLaterChanges) {
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    makeSystems(10, systems, index);
+    connectRing(index, 1);
+
+    SnapshotPublisher publisher;
+    EXPECT_EQ(publisher.publish(systems, index), 1u);
+    SnapshotReader reader(publisher);
+    {
+        SnapshotReader::Pin pin = reader.pin();
+        ASSERT_TRUE(pin);
+        connectRing(index, 3);
+        EXPECT_EQ(publisher.publish(systems, index), 2u);
+
+        // the pinned snapshot is retired but neither changed nor freed
+        EXPECT_EQ(pin->getSequence(), 1u);
+        EXPECT_EQ(countConnections(pin->getPlanner()), 10);
+        EXPECT_EQ(pin->idOf("SYS4"), 4);
+        EXPECT_EQ(pin->idOf("NOWHERE"), -1);
+        publisher.reclaim();
+        EXPECT_EQ(publisher.getStats().pending, 1u);
+    }
+    publisher.reclaim();
+    SnapshotStats stats = publisher.getStats();
+    EXPECT_EQ(stats.published, 2u);
+    EXPECT_EQ(stats.reclaimed, 1u);
+    EXPECT_EQ(stats.pending, 0u);
+
+    SnapshotReader::Pin pin = reader.pin();
+    EXPECT_EQ(pin->getSequence(), 2u);
+    EXPECT_EQ(countConnections(pin->getPlanner()), 20);
+}
+
+TEST(SnapshotPublisher, ReaderSlotsRunOut) {
+    SnapshotPublisher publisher;
+    vector<unique_ptr<SnapshotReader>> readers;
+    for (int r = 0; r < SnapshotPublisher::kMaxReaders; r++) {
+        readers.push_back(make_unique<SnapshotReader>(publisher));
+    }
+    EXPECT_THROW(SnapshotReader extra(publisher), length_error);
+
+    // a slot given back can be claimed again
+    readers.pop_back();
+    EXPECT_NO_THROW(SnapshotReader again(publisher));
+}
+
+TEST(SnapshotPublisher, PublishAndReclaimUnderConcurrentReaders) {
+    const int numSystems = 300;
+    const int numReaders = 4;
+    const int numUpdates = 200;
+    vector<shared_ptr<SolarSystem>> systems;
+    SystemIndex index;
+    makeSystems(numSystems, systems, index);
+
+    // odd sequences hold the plain ring, even ones the ring with chords
+    const long connections[2] = {2L * numSystems, numSystems};
+    connectRing(index, 1);
+    SnapshotPublisher publisher;
+    publisher.publish(systems, index);
+
+    atomic<bool> stop{false};
+    atomic<long> failures{0};
+    atomic<long> reads{0};
+    vector<thread> threads;
+    for (int r = 0; r < numReaders; r++) {
+        threads.emplace_back([&, r]() {
+            SnapshotReader reader(publisher);
+            mt19937 rng(r + 1);
+            uniform_int_distribution<int> pick(0, numSystems - 1);
+            uint64_t lastSeen = 0;
+            vector<int> route;
+            while (!stop.load(memory_order_relaxed)) {
+                int a = pick(rng), b = pick(rng);
+                long failed = 0;
+                SnapshotReader::Pin snapshot = reader.pin();
+                uint64_t sequence = snapshot->getSequence();
+                failed += sequence < lastSeen;
+                lastSeen = sequence;
+                const RoutePlanner &planner = snapshot->getPlanner();
+                failed += countConnections(planner) != connections[sequence % 2];
+                if (snapshot->findRoute(a, b, route, reader.getScratch())) {
+                    failed += route.front() != a || route.back() != b;
+                    for (size_t i = 0; i + 1 < route.size(); i++) {
+                        auto [first, last] = planner.neighbors(planner.vertexOf(route[i]));
+                        failed += find(first, last, planner.vertexOf(route[i + 1])) == last;
+                    }
+                } else {
+                    failed++; // every ring is strongly connected
+                }
+                failed += snapshot->idOf(snapshot->nameOf(a)) != a;
+                failures.fetch_add(failed);
+                reads.fetch_add(1);
+            }
+        });
+    }
+
+    while (reads.load() < numReaders) {
+        this_thread::yield();
+    }
+    for (int update = 1; update <= numUpdates; update++) {
+        connectRing(index, update % 2 == 1 ? 7 : 1);
+        EXPECT_EQ(publisher.publish(systems, index), static_cast<uint64_t>(update + 1));
+        this_thread::yield();
+    }
+    stop.store(true);
+    for (thread &worker : threads) {
+        worker.join();
+    }
+
+    // with every reader gone nothing may stay retired
+    publisher.reclaim();
+    SnapshotStats stats = publisher.getStats();
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_GT(reads.load(), 0);
+    EXPECT_EQ(stats.published, static_cast<uint64_t>(numUpdates + 1));
+    EXPECT_EQ(stats.reclaimed, static_cast<uint64_t>(numUpdates));
+    EXPECT_EQ(stats.pending, 0u);
+    EXPECT_EQ(publisher.current()->getSequence(), static_cast<uint64_t>(numUpdates + 1));
+}
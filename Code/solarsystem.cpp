@@ -15,13 +15,25 @@
 // Disciplinary Policy (A2-c. Unauthorized Collaboration; and A2-e3. 
 // Participation in Academically Dishonest Activities: Material Distribution).
 
+#include <unordered_map>
 #include "solarsystem.h"
 #include "celestial.h"
+#include "memoryreport.h"
 
 // Local Helper Functions
 // If you were allowed to change the the .h files many, if not all,
 // of these would go into a private section of the class declaration.
 
+/// @brief look a name up in one of the per-type body indexes
+/// @return the body, nullptr if the index has no such name
+template <typename T>
+static shared_ptr<T> findIn(const unordered_map<string, shared_ptr<T>> &index, const string &n) {
+    auto it = index.find(n);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
 
 
 
@@ -35,6 +47,10 @@
 /// @param n the value to set the private data member name to
 SolarSystem::SolarSystem(const string &n) {
     this->name = n;
+    this->positioned = false;
+    this->x = 0.0;
+    this->y = 0.0;
+    this->z = 0.0;
 }
 
 /// @brief return name of SolarSystem
@@ -63,15 +79,112 @@ void SolarSystem::setName(const string &n) {
     this->name = n;
 }
 
+/// @brief set the 3D coordinates of the SolarSystem
+/// @param px, py, pz the coordinates to set the position to
+void SolarSystem::setPosition(double px, double py, double pz) {
+    this->x = px;
+    this->y = py;
+    this->z = pz;
+    this->positioned = true;
+}
+
+/// @brief return whether coordinates were given for the SolarSystem
+bool SolarSystem::hasPosition() const {
+    return this->positioned;
+}
+
+/// @brief return the x coordinate, 0 when there is no position
+double SolarSystem::getX() const {
+    return this->x;
+}
+
+/// @brief return the y coordinate, 0 when there is no position
+double SolarSystem::getY() const {
+    return this->y;
+}
+
+/// @brief return the z coordinate, 0 when there is no position
+double SolarSystem::getZ() const {
+    return this->z;
+}
+
 /// @brief clear the vector of connections to other SolarSystems
 void SolarSystem::clearConnections() {
     this->connections.clear();
 }
 
+/// @brief drop every celestial body and release the memory of the body
+/// vector and indexes, the SolarSystem and its connections stay
+void SolarSystem::clearCelestials() {
+    vector<shared_ptr<Celestial>>().swap(this->celestialBodies);
+    unordered_map<string, shared_ptr<Star>>().swap(this->starIndex);
+    unordered_map<string, shared_ptr<Planet>>().swap(this->planetIndex);
+    unordered_map<string, shared_ptr<Satellite>>().swap(this->satelliteIndex);
+}
+
 /// @brief Add a Celestial pointer to the back of private data member celestialBodies.
+/// The type is only known at run time here, prefer the typed overloads.
 /// @param newC is the celestial ptr to add
 void SolarSystem::insertCelestial(shared_ptr<Celestial> &newC) {
-    this->celestialBodies.push_back(newC);
+    if (shared_ptr<Star> star = dynamic_pointer_cast<Star>(newC)) {
+        this->insertCelestial(star);
+    } else if (shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(newC)) {
+        this->insertCelestial(planet);
+    } else {
+        this->celestialBodies.push_back(newC);
+    }
+}
+
+/// @brief Add a Star to celestialBodies and the star index.
+/// note: the index keeps the first star added under a name
+/// @param star is the star ptr to add
+void SolarSystem::insertCelestial(const shared_ptr<Star> &star) {
+    this->celestialBodies.push_back(star);
+    this->starIndex.emplace(star->getName(), star);
+}
+
+/// @brief Add a Planet to celestialBodies and the planet index.
+/// note: the index keeps the first planet added under a name
+/// @param planet is the planet ptr to add
+void SolarSystem::insertCelestial(const shared_ptr<Planet> &planet) {
+    this->celestialBodies.push_back(planet);
+    this->planetIndex.emplace(planet->getName(), planet);
+}
+
+/// @brief Put a Satellite in orbit of a Planet of this SolarSystem and add
+/// it to the satellite index.
+/// note: the index keeps the first satellite added under a name
+/// @param planet is the planet the satellite orbits
+/// @param satellite is the satellite ptr to add
+void SolarSystem::insertSatellite(const shared_ptr<Planet> &planet, const shared_ptr<Satellite> &satellite) {
+    shared_ptr<Celestial> sat = satellite;
+    planet->addSat(sat);
+    this->satelliteIndex.emplace(satellite->getName(), satellite);
+}
+
+/// @brief find a Star of this SolarSystem by name through the star index
+/// @param n the name of the star
+/// @return the star, nullptr if there is none with that name
+template <>
+shared_ptr<Star> SolarSystem::find<Star>(const string &n) const {
+    return findIn(this->starIndex, n);
+}
+
+/// @brief find a Planet of this SolarSystem by name through the planet index
+/// @param n the name of the planet
+/// @return the planet, nullptr if there is none with that name
+template <>
+shared_ptr<Planet> SolarSystem::find<Planet>(const string &n) const {
+    return findIn(this->planetIndex, n);
+}
+
+/// @brief find a Satellite orbiting any Planet of this SolarSystem by name
+/// through the satellite index
+/// @param n the name of the satellite
+/// @return the satellite, nullptr if there is none with that name
+template <>
+shared_ptr<Satellite> SolarSystem::find<Satellite>(const string &n) const {
+    return findIn(this->satelliteIndex, n);
 }
 
 /// @brief Add a Solar System pointer to the back of private data member connections.
@@ -92,6 +205,11 @@ void SolarSystem::addConnection(const shared_ptr<SolarSystem> &con) {
     this->connections.push_back(con);
 }
 
+/// @return the Solar Systems this one connects to, in the order added
+const vector<shared_ptr<SolarSystem>> &SolarSystem::getConnections() const {
+    return this->connections;
+}
+
 /// @brief return number of celestial bodies in the priv data member celestialBodies
 int SolarSystem::numCelestialBodies() const {
     return this->celestialBodies.size();
@@ -180,4 +298,43 @@ string SolarSystem::connectionsToString() const {
     details += "}";
 
     return details;
-}
\ No newline at end of file
+}
+
+/// @brief Charge this SolarSystem, its lists, lookup tables and bodies to
+///     a memory report. Planets charge their own satellites.
+/// @param report the report to add to
+void SolarSystem::addMemoryUsage(MemoryReport &report) const {
+    report.systems++;
+    report.addShared<SolarSystem>(report.systemBytes);
+    report.addName(this->name);
+    report.addVector(report.bodyListBytes, this->celestialBodies);
+    report.addVector(report.connectionBytes, this->connections);
+    report.addHashIndex(this->starIndex);
+    report.addHashIndex(this->planetIndex);
+    report.addHashIndex(this->satelliteIndex);
+
+    for (const auto& celestialBody : this->celestialBodies) {
+        if (shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(celestialBody)) {
+            planet->addMemoryUsage(report);
+        } else if (dynamic_pointer_cast<Star>(celestialBody)) {
+            report.stars++;
+            report.addShared<Star>(report.starBytes);
+            report.addName(celestialBody->getName());
+        }
+    }
+}
+
+/// @brief Release spare capacity of the body and connection vectors and
+///     shrink the lookup tables to their contents, planets included.
+void SolarSystem::shrink() {
+    this->celestialBodies.shrink_to_fit();
+    this->connections.shrink_to_fit();
+    this->starIndex.rehash(0);
+    this->planetIndex.rehash(0);
+    this->satelliteIndex.rehash(0);
+    for (const auto& celestialBody : this->celestialBodies) {
+        if (shared_ptr<Planet> planet = dynamic_pointer_cast<Planet>(celestialBody)) {
+            planet->shrink();
+        }
+    }
+}
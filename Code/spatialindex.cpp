@@ -0,0 +1,189 @@
+/// @file spatialindex.cpp
+/// @brief Implementations for the SpatialIndex k-d tree used for nearest
+///        system queries and route planning heuristics.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "spatialindex.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+/// @brief squared distance between a query point and a point in the tree
+static double distanceSq(const double *a, const double *b) {
+    double dx = a[0] - b[0];
+    double dy = a[1] - b[1];
+    double dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+
+/// @brief Build the tree from every system that has a position.
+/// @param index the system index to read systems from
+void SpatialIndex::build(const SystemIndex &index) {
+    this->coords.clear();
+    this->ids.clear();
+    for (int id = 0; id < index.size(); id++) {
+        shared_ptr<SolarSystem> system = index.at(id);
+        if (system->hasPosition()) {
+            this->ids.push_back(id);
+            this->coords.push_back(system->getX());
+            this->coords.push_back(system->getY());
+            this->coords.push_back(system->getZ());
+        }
+    }
+
+    this->buildRange(0, this->ids.size(), 0);
+    this->builtVersion = index.getVersion();
+    this->built = true;
+}
+
+/// @return true when the index changed since the last build
+bool SpatialIndex::isStale(const SystemIndex &index) const {
+    return !this->built || this->builtVersion != index.getVersion();
+}
+
+/// @return number of systems in the tree
+int SpatialIndex::size() const {
+    return this->ids.size();
+}
+
+/// @brief Find the k systems closest to a point. k comes from user input,
+///        so it is capped at the number of systems before anything is
+///        allocated for it.
+/// @return (system id, distance) pairs, closest first
+vector<pair<int, double>> SpatialIndex::nearest(double x, double y, double z, int k) const {
+    k = min(k, this->size());
+    if (k <= 0) {
+        return {};
+    }
+
+    vector<pair<double, int>> heap; // max heap on squared distance
+    double point[3] = {x, y, z};
+    heap.reserve(k + 1);
+    this->nearestRange(0, this->ids.size(), 0, point, k, heap);
+
+    sort_heap(heap.begin(), heap.end());
+    vector<pair<int, double>> found;
+    found.reserve(heap.size());
+    for (const auto &entry : heap) {
+        found.emplace_back(entry.second, sqrt(entry.first));
+    }
+    return found;
+}
+
+/// @brief Find every system within a distance of a point.
+/// @return (system id, distance) pairs, closest first
+vector<pair<int, double>> SpatialIndex::withinRadius(double x, double y, double z, double radius) const {
+    vector<pair<int, double>> found;
+    if (radius >= 0) {
+        double point[3] = {x, y, z};
+        this->radiusRange(0, this->ids.size(), 0, point, radius * radius, found);
+    }
+
+    for (auto &entry : found) {
+        entry.second = sqrt(entry.second);
+    }
+    sort(found.begin(), found.end(), [](const pair<int, double> &a, const pair<int, double> &b) {
+        return a.second < b.second;
+    });
+    return found;
+}
+
+/// @brief Arrange [lo, hi) so the middle point splits the range on the
+///        current axis, then arrange both halves the same way.
+void SpatialIndex::buildRange(int lo, int hi, int depth) {
+    if (hi - lo <= 1) {
+        return;
+    }
+
+    int axis = depth % 3;
+    int mid = lo + (hi - lo) / 2;
+
+    // order a permutation of the range, then apply it to both arrays
+    vector<int> order(hi - lo);
+    for (int i = 0; i < hi - lo; i++) {
+        order[i] = lo + i;
+    }
+    nth_element(order.begin(), order.begin() + (mid - lo), order.end(), [&](int a, int b) {
+        return this->coords[a * 3 + axis] < this->coords[b * 3 + axis];
+    });
+
+    vector<double> rangeCoords(this->coords.begin() + lo * 3, this->coords.begin() + hi * 3);
+    vector<int> rangeIds(this->ids.begin() + lo, this->ids.begin() + hi);
+    for (int i = 0; i < hi - lo; i++) {
+        int from = order[i] - lo;
+        this->ids[lo + i] = rangeIds[from];
+        copy(rangeCoords.begin() + from * 3, rangeCoords.begin() + from * 3 + 3,
+             this->coords.begin() + (lo + i) * 3);
+    }
+
+    this->buildRange(lo, mid, depth + 1);
+    this->buildRange(mid + 1, hi, depth + 1);
+}
+
+/// @brief k nearest search of [lo, hi), visiting the near half first and
+///        the far half only when it can still hold a closer point.
+void SpatialIndex::nearestRange(int lo, int hi, int depth, const double *point, size_t k,
+                                vector<pair<double, int>> &heap) const {
+    if (lo >= hi) {
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    const double *splitPoint = &this->coords[mid * 3];
+    double d = distanceSq(point, splitPoint);
+    if (heap.size() < k) {
+        heap.emplace_back(d, this->ids[mid]);
+        push_heap(heap.begin(), heap.end());
+    } else if (d < heap.front().first) {
+        pop_heap(heap.begin(), heap.end());
+        heap.back() = make_pair(d, this->ids[mid]);
+        push_heap(heap.begin(), heap.end());
+    }
+
+    int axis = depth % 3;
+    double diff = point[axis] - splitPoint[axis];
+    if (diff < 0) {
+        this->nearestRange(lo, mid, depth + 1, point, k, heap);
+        if (heap.size() < k || diff * diff < heap.front().first) {
+            this->nearestRange(mid + 1, hi, depth + 1, point, k, heap);
+        }
+    } else {
+        this->nearestRange(mid + 1, hi, depth + 1, point, k, heap);
+        if (heap.size() < k || diff * diff < heap.front().first) {
+            this->nearestRange(lo, mid, depth + 1, point, k, heap);
+        }
+    }
+}
+
+/// @brief radius search of [lo, hi), found holds squared distances
+void SpatialIndex::radiusRange(int lo, int hi, int depth, const double *point, double radiusSq,
+                               vector<pair<int, double>> &found) const {
+    if (lo >= hi) {
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    const double *splitPoint = &this->coords[mid * 3];
+    double d = distanceSq(point, splitPoint);
+    if (d <= radiusSq) {
+        found.emplace_back(this->ids[mid], d);
+    }
+
+    int axis = depth % 3;
+    double diff = point[axis] - splitPoint[axis];
+    if (diff <= 0 || diff * diff <= radiusSq) {
+        this->radiusRange(lo, mid, depth + 1, point, radiusSq, found);
+    }
+    if (diff >= 0 || diff * diff <= radiusSq) {
+        this->radiusRange(mid + 1, hi, depth + 1, point, radiusSq, found);
+    }
+}
@@ -0,0 +1,249 @@
+/// @file systemindex.cpp
+/// @brief Implementations for the SystemIndex class that maps Solar System
+///        names to ids and keeps the connection graph as id lists.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+
+using namespace std;
+
+/// @brief Index any systems appended to the vector since the last call.
+///        The systems vector only grows between clears, so the indexed
+///        prefix is checked by its last entry and rebuilt when it differs.
+///        Connections the new systems already hold are indexed too, so a
+///        rebuild keeps every connection. They are resolved before the
+///        index changes, so a failed sync leaves it as it was.
+/// @param systems the vector of loaded Solar Systems
+/// @throw logic_error when a system connects to one not in the vector
+void SystemIndex::sync(const vector<shared_ptr<SolarSystem>> &systems) {
+    size_t indexed = this->byId.size();
+    bool rebuild = indexed > systems.size() ||
+        (indexed > 0 && this->byId.at(indexed - 1) != systems.at(indexed - 1));
+    if (rebuild) {
+        indexed = 0;
+    }
+
+    // a new system gets its position in systems as id, and a name belongs
+    // to the first system holding it; fall back to the pointers when a
+    // name is shared
+    vector<vector<int>> resolved;
+    unordered_map<string, int> addedIds;
+    unordered_map<const SolarSystem *, int> byPointer;
+    for (size_t from = indexed; from < systems.size(); from++) {
+        const auto &connections = systems.at(from)->getConnections();
+        if (connections.empty()) {
+            continue;
+        }
+        if (resolved.empty()) {
+            resolved.resize(systems.size() - indexed);
+            for (size_t id = indexed; id < systems.size(); id++) {
+                addedIds.emplace(systems[id]->getName(), id);
+            }
+        }
+        vector<int> &list = resolved.at(from - indexed);
+        for (const auto &target : connections) {
+            int to = rebuild ? -1 : this->idOf(target->getName());
+            if (to == -1) {
+                auto it = addedIds.find(target->getName());
+                to = it == addedIds.end() ? -1 : it->second;
+            }
+            if (to == -1 || systems.at(to) != target) {
+                if (byPointer.empty()) {
+                    for (size_t id = 0; id < systems.size(); id++) {
+                        byPointer.emplace(systems[id].get(), id);
+                    }
+                }
+                auto it = byPointer.find(target.get());
+                if (it == byPointer.end()) {
+                    throw logic_error("System " + systems.at(from)->getName() + " connects to " +
+                                      target->getName() + ", which is not loaded.");
+                }
+                to = it->second;
+            }
+            list.push_back(to);
+        }
+    }
+
+    // every connection resolved, now change the index
+    if (rebuild) {
+        this->clear();
+    }
+    for (size_t i = indexed; i < systems.size(); i++) {
+        this->insert(systems.at(i));
+    }
+    for (size_t i = 0; i < resolved.size(); i++) {
+        if (!resolved[i].empty()) {
+            this->adjacency.at(indexed + i) = move(resolved[i]);
+            this->version++;
+        }
+    }
+}
+
+/// @brief Forget every indexed system and connection
+void SystemIndex::clear() {
+    this->byId.clear();
+    this->ids.clear();
+    this->adjacency.clear();
+    this->version++;
+}
+
+/// @brief Forget every connection, systems stay indexed
+void SystemIndex::clearConnections() {
+    for (auto &list : this->adjacency) {
+        list.clear();
+    }
+    this->version++;
+}
+
+/// @brief look up the id of a system by name
+/// @param name the name of the system
+/// @return the id, -1 when not indexed
+int SystemIndex::idOf(const string &name) const {
+    auto it = this->ids.find(name);
+    if (it == this->ids.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+/// @brief look up a system by name
+/// @param name the name of the system
+/// @return the system, nullptr when not indexed
+shared_ptr<SolarSystem> SystemIndex::find(const string &name) const {
+    int id = this->idOf(name);
+    if (id == -1) {
+        return nullptr;
+    }
+    return this->byId.at(id);
+}
+
+/// @brief return the system with the given id
+shared_ptr<SolarSystem> SystemIndex::at(int id) const {
+    return this->byId.at(id);
+}
+
+/// @brief return the number of indexed systems
+int SystemIndex::size() const {
+    return this->byId.size();
+}
+
+/// @brief Find the named system or create it at the back of systems
+/// @param systems the vector of loaded Solar Systems
+/// @param name the name of the system
+/// @param created set to true when a new system was made
+/// @return the id of the system
+int SystemIndex::findOrCreate(vector<shared_ptr<SolarSystem>> &systems,
+                              const string &name, bool &created) {
+    created = false;
+    int id = this->idOf(name);
+    if (id != -1) {
+        return id;
+    }
+
+    shared_ptr<SolarSystem> system = make_shared<SolarSystem>(name);
+    systems.push_back(system);
+    created = true;
+    return this->insert(system);
+}
+
+/// @brief Add a from -> to connection to the index and the SolarSystem
+/// @return true when the connection did not exist before
+bool SystemIndex::connect(int from, int to) {
+    vector<int> &list = this->adjacency.at(from);
+    if (std::find(list.begin(), list.end(), to) != list.end()) {
+        return false;
+    }
+
+    list.push_back(to);
+    this->byId.at(from)->addConnection(this->byId.at(to));
+    this->version++;
+    return true;
+}
+
+/// @brief Remove a from -> to connection from the index and the SolarSystem.
+///        SolarSystem can only clear its connections, so the remaining ones
+///        are added back in their original order.
+/// @return true when the connection existed
+bool SystemIndex::disconnect(int from, int to) {
+    vector<int> &list = this->adjacency.at(from);
+    auto it = std::find(list.begin(), list.end(), to);
+    if (it == list.end()) {
+        return false;
+    }
+
+    list.erase(it);
+    shared_ptr<SolarSystem> source = this->byId.at(from);
+    source->clearConnections();
+    for (int id : list) {
+        source->addConnection(this->byId.at(id));
+    }
+    this->version++;
+    return true;
+}
+
+/// @brief return ids of the systems the given system connects to
+const vector<int> &SystemIndex::neighbors(int id) const {
+    return this->adjacency.at(id);
+}
+
+/// @brief set the coordinates of a system and mark the index changed
+void SystemIndex::setPosition(int id, double x, double y, double z) {
+    this->byId.at(id)->setPosition(x, y, z);
+    this->version++;
+}
+
+/// @brief return the change counter of the index
+unsigned long SystemIndex::getVersion() const {
+    return this->version;
+}
+
+/// @brief note that celestial bodies are about to be added or changed
+void SystemIndex::markBodiesChanged() {
+    this->bodiesVersion++;
+}
+
+/// @brief return the change counter for celestial bodies
+unsigned long SystemIndex::getBodiesVersion() const {
+    return this->bodiesVersion;
+}
+
+/// @brief Charge the id table, name table and adjacency lists to a
+///        memory report. The systems themselves are charged by
+///        measureMemory through the systems vector.
+/// @param report the report to add to
+void SystemIndex::addMemoryUsage(MemoryReport &report) const {
+    report.addVector(report.systemTableBytes, this->byId);
+    report.addHashIndex(this->ids);
+    report.addVector(report.connectionBytes, this->adjacency);
+    for (const auto &neighbors : this->adjacency) {
+        report.addVector(report.connectionBytes, neighbors);
+    }
+}
+
+/// @brief Release spare capacity left over from loading.
+void SystemIndex::shrink() {
+    this->byId.shrink_to_fit();
+    this->ids.rehash(0);
+    this->adjacency.shrink_to_fit();
+    for (auto &neighbors : this->adjacency) {
+        neighbors.shrink_to_fit();
+    }
+}
+
+/// @brief add a system to the back of the index
+/// @return the id given to the system
+int SystemIndex::insert(const shared_ptr<SolarSystem> &system) {
+    int id = this->byId.size();
+    this->byId.push_back(system);
+    this->ids.emplace(system->getName(), id); // first system with a name wins
+    this->adjacency.emplace_back();
+    this->version++;
+    return id;
+}
@@ -0,0 +1,266 @@
+/// @file universegen.cpp
+/// @brief Implementations for the synthetic universe generator.
+///        Utilized by the Interstellar Travel App benchmarks.
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+#include <random>
+#include <string>
+#include "universegen.h"
+
+using namespace std;
+
+// Local Helper Functions
+
+namespace {
+
+/// @brief Formats lines into a large buffer and hands it to the stream in
+///        whole chunks, so writing costs little more than the disk does.
+class ChunkWriter
+{
+    public:
+        explicit ChunkWriter(ostream &out) : out(out) {
+            this->buffer.resize(kChunk + kSlack);
+        }
+
+        ~ChunkWriter() {
+            this->flush();
+        }
+
+        ChunkWriter &text(const char *s, size_t n) {
+            if (n > kSlack) {
+                this->flush();
+                this->out.write(s, n);
+                this->written += n;
+                return *this;
+            }
+            memcpy(&this->buffer[this->used], s, n);
+            this->used += n;
+            return *this;
+        }
+
+        ChunkWriter &text(const char *s) {
+            return this->text(s, strlen(s));
+        }
+
+        ChunkWriter &text(const string &s) {
+            return this->text(s.data(), s.size());
+        }
+
+        ChunkWriter &number(long value) {
+            auto result = to_chars(&this->buffer[this->used], &this->buffer[0] + this->buffer.size(), value);
+            this->used = result.ptr - &this->buffer[0];
+            return *this;
+        }
+
+        /// @brief write a double with a fixed number of decimals
+        ChunkWriter &number(double value, int decimals) {
+            auto result = to_chars(&this->buffer[this->used], &this->buffer[0] + this->buffer.size(),
+                                   value, chars_format::fixed, decimals);
+            this->used = result.ptr - &this->buffer[0];
+            return *this;
+        }
+
+        ChunkWriter &ch(char c) {
+            this->buffer[this->used++] = c;
+            return *this;
+        }
+
+        /// @brief end a line, sending the buffer on once a chunk is full
+        void endLine() {
+            this->buffer[this->used++] = '\n';
+            this->checkpoint();
+        }
+
+        /// @brief send the buffer on if a chunk is full; long lines call
+        ///        this between fields
+        void checkpoint() {
+            if (this->used >= kChunk) {
+                this->flush();
+            }
+        }
+
+        void flush() {
+            if (this->used > 0) {
+                this->out.write(this->buffer.data(), this->used);
+                this->written += this->used;
+                this->used = 0;
+            }
+        }
+
+        unsigned long long bytes() const {
+            return this->written + this->used;
+        }
+
+    private:
+        static constexpr size_t kChunk = 1 << 20;
+        // room for one line, or one field of a long connection line,
+        // past a full chunk
+        static constexpr size_t kSlack = 1 << 16;
+
+        ostream &out;
+        string buffer;
+        size_t used = 0;
+        unsigned long long written = 0;
+};
+
+/// @brief draw the number of connections of one system
+long drawDegree(const UniverseSpec &spec, mt19937_64 &rng) {
+    long most = max(0L, spec.systems - 1);
+    if (spec.degreeModel == "powerlaw") {
+        // Pareto with exponent 2.5 scaled so the mean is meanDegree
+        uniform_real_distribution<double> unit(0.0, 1.0);
+        double minimum = spec.meanDegree / 3.0;
+        double degree = minimum / pow(1.0 - unit(rng), 1.0 / 1.5);
+        return min(most, static_cast<long>(degree));
+    }
+    uniform_int_distribution<long> degree(0, static_cast<long>(2 * spec.meanDegree));
+    return min(most, degree(rng));
+}
+
+/// @brief draw the target of one connection. The power law model favours
+///        low numbered systems so a few of them become hubs.
+long drawTarget(const UniverseSpec &spec, mt19937_64 &rng) {
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    double u = unit(rng);
+    if (spec.degreeModel == "powerlaw") {
+        u = u * u * u;
+    }
+    return min(spec.systems - 1, static_cast<long>(u * spec.systems));
+}
+
+/// @brief comment and blank line separating blocks of systems, so the
+///        loaders' skipping paths are exercised at scale
+void writeBlockComment(ChunkWriter &writer, const UniverseSpec &spec, long first) {
+    if (spec.commentEvery <= 0 || first == 0 || first % spec.commentEvery != 0) {
+        return;
+    }
+    writer.endLine();
+    writer.text("# systems ").number(first).ch('-').number(min(spec.systems, first + spec.commentEvery) - 1);
+    writer.endLine();
+}
+
+}
+
+
+/// @return the name given to system i of a generated universe
+string generatedSystemName(long i) {
+    return "SYS" + to_string(i);
+}
+
+/// @brief Write System, Star, Planet and Satellite lines for a spec.
+/// @param out where to write the celestial data
+/// @param spec the size and shape of the universe
+/// @return bytes written
+unsigned long long writeCelestialData(ostream &out, const UniverseSpec &spec) {
+    static const char spectralClasses[] = "OBAFGKM";
+    static const double classTemperatures[] = {35000, 20000, 8500, 6500, 5500, 4500, 3200};
+
+    ChunkWriter writer(out);
+    mt19937_64 rng(spec.seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    // positions fill a cube sized so systems are about one unit apart
+    double side = cbrt(static_cast<double>(spec.systems));
+
+    if (spec.commentEvery > 0) {
+        writer.text("# generated universe: ").number(spec.systems).text(" systems, seed ").number(static_cast<long>(spec.seed));
+        writer.endLine();
+    }
+    for (long i = 0; i < spec.systems; i++) {
+        writeBlockComment(writer, spec, i);
+
+        writer.text("System,SYS").number(i);
+        if (spec.coordinates) {
+            writer.ch(',').number(unit(rng) * side, 3)
+                  .ch(',').number(unit(rng) * side, 3)
+                  .ch(',').number(unit(rng) * side, 3);
+        }
+        writer.endLine();
+
+        for (int s = 0; s < spec.starsPerSystem; s++) {
+            int spectralClass = static_cast<int>(unit(rng) * 7);
+            writer.text("Star,S").number(i).ch('_').number(static_cast<long>(s))
+                  .text(",SYS").number(i).ch(',')
+                  .ch(spectralClasses[spectralClass]).number(static_cast<long>(unit(rng) * 10)).text("V,")
+                  .number(classTemperatures[spectralClass] * (0.9 + 0.2 * unit(rng)), 0).ch(',')
+                  .number(0.1 + 2.9 * unit(rng), 3);
+            writer.endLine();
+        }
+
+        for (int p = 0; p < spec.planetsPerSystem; p++) {
+            // planets orbit the first star, S<i>_0
+            writer.text("Planet,P").number(i).ch('_').number(static_cast<long>(p))
+                  .text(",S").number(i).text("_0,SYS").number(i).ch(',')
+                  .number(10.0 + 5000.0 * unit(rng), 2).ch(',')
+                  .number(0.1 + 15.0 * unit(rng), 3);
+            writer.endLine();
+
+            for (int m = 0; m < spec.satellitesPerPlanet; m++) {
+                writer.text("Satellite,M").number(i).ch('_').number(static_cast<long>(p)).ch('_').number(static_cast<long>(m))
+                      .text(",P").number(i).ch('_').number(static_cast<long>(p))
+                      .text(",SYS").number(i).ch(',')
+                      .number(0.001 + unit(rng), 4).ch(',')
+                      .text(unit(rng) < 0.7 ? "Yes" : "No");
+                writer.endLine();
+            }
+        }
+    }
+    return writer.bytes();
+}
+
+/// @brief Write one connection line per system for a spec. Systems that
+///        draw no connections get no line, like in the provided data.
+/// @param out where to write the connection data
+/// @param spec the size and shape of the universe
+/// @return bytes written
+unsigned long long writeConnectionData(ostream &out, const UniverseSpec &spec) {
+    ChunkWriter writer(out);
+    mt19937_64 rng(spec.seed + 1);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+
+    if (spec.commentEvery > 0) {
+        writer.text("# generated connections: ").text(spec.degreeModel).text(" degree ").number(spec.meanDegree, 2);
+        writer.endLine();
+    }
+    // small world: ring lattice reaching half the degree either way, each
+    // edge rewired to a random system with probability rewire
+    long reach = max(1L, static_cast<long>(spec.meanDegree / 2.0 + 0.5));
+
+    for (long i = 0; i < spec.systems; i++) {
+        writeBlockComment(writer, spec, i);
+
+        long degree = 0;
+        if (spec.degreeModel == "smallworld") {
+            degree = min(2 * reach, spec.systems - 1);
+        } else {
+            degree = drawDegree(spec, rng);
+        }
+        if (degree == 0) {
+            continue;
+        }
+
+        writer.text("SYS").number(i);
+        for (long d = 0; d < degree; d++) {
+            long target;
+            if (spec.degreeModel == "smallworld") {
+                long offset = d < reach ? d + 1 : -(d - reach + 1);
+                target = ((i + offset) % spec.systems + spec.systems) % spec.systems;
+                if (unit(rng) < spec.rewire) {
+                    target = min(spec.systems - 1, static_cast<long>(unit(rng) * spec.systems));
+                }
+            } else {
+                target = drawTarget(spec, rng);
+            }
+            if (target == i) {
+                target = (target + 1) % spec.systems;
+            }
+            writer.text(",SYS").number(target);
+            writer.checkpoint();
+        }
+        writer.endLine();
+    }
+    return writer.bytes();
+}
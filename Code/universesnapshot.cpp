@@ -0,0 +1,219 @@
+/// @file universesnapshot.cpp
+/// @brief Implementations for publishing universe snapshots to concurrent
+///        readers with epoch based reclamation.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "solarsystem.h"
+#include "systemindex.h"
+#include "routeplanner.h"
+#include "catalog.h"
+#include "profiler.h"
+#include "universesnapshot.h"
+
+using namespace std;
+
+/// @brief Copy what queries need out of the loaded systems.
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @param sequence the publisher's number for this snapshot
+/// @param previous the last snapshot, nullptr for the first
+UniverseSnapshot::UniverseSnapshot(const vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index,
+                                   uint64_t sequence, const UniverseSnapshot *previous)
+    : sequence(sequence) {
+    PROFILE_SCOPE("snapshot.capture");
+    index.sync(systems);
+    this->bodiesVersion = index.getBodiesVersion();
+
+    // every loader that adds systems or bodies marks the bodies changed,
+    // so an equal version and count means the names and details still hold
+    if (previous != nullptr && previous->bodiesVersion == this->bodiesVersion &&
+        previous->size() == index.size()) {
+        this->names = previous->names;
+    } else {
+        shared_ptr<Names> fresh = make_shared<Names>();
+        int n = index.size();
+        fresh->byId.reserve(n);
+        fresh->details.reserve(n);
+        fresh->ids.reserve(n);
+        for (int id = 0; id < n; id++) {
+            shared_ptr<SolarSystem> system = index.at(id);
+            fresh->byId.push_back(system->getName());
+            fresh->ids.emplace(fresh->byId.back(), id);
+            fresh->details.push_back(system->toString());
+        }
+        this->names = fresh;
+    }
+
+    ostringstream stats;
+    printLoadedCelestialStats(systems, stats);
+    this->statsText = stats.str();
+
+    this->planner.build(index);
+}
+
+/// @return publish order, one higher than the snapshot before
+uint64_t UniverseSnapshot::getSequence() const {
+    return this->sequence;
+}
+
+/// @return number of systems
+int UniverseSnapshot::size() const {
+    return this->names->byId.size();
+}
+
+/// @return the id of the named system, -1 when there is none
+int UniverseSnapshot::idOf(const string &name) const {
+    auto found = this->names->ids.find(name);
+    return found == this->names->ids.end() ? -1 : found->second;
+}
+
+/// @return the name of a system
+const string &UniverseSnapshot::nameOf(int id) const {
+    return this->names->byId.at(id);
+}
+
+/// @return the system's name and bodies as captured
+const string &UniverseSnapshot::detailsOf(int id) const {
+    return this->names->details.at(id);
+}
+
+/// @return the stats report as captured
+const string &UniverseSnapshot::getStatsText() const {
+    return this->statsText;
+}
+
+/// @return the connection graph and positions
+const RoutePlanner &UniverseSnapshot::getPlanner() const {
+    return this->planner;
+}
+
+/// @brief Find a route with the fewest hops in this snapshot.
+/// @param route filled with system ids from start to end
+/// @param scratch the calling thread's work arrays
+/// @return true when end can be reached from start
+bool UniverseSnapshot::findRoute(int start, int end, vector<int> &route, RouteScratch &scratch) const {
+    return this->planner.findRoute(start, end, route, scratch);
+}
+
+
+/// @brief Claim a free reader slot.
+/// @param publisher the publisher to read from
+SnapshotReader::SnapshotReader(SnapshotPublisher &publisher) : publisher(publisher), slot(-1) {
+    for (int s = 0; s < SnapshotPublisher::kMaxReaders; s++) {
+        bool expected = false;
+        if (publisher.slots[s].claimed.compare_exchange_strong(expected, true)) {
+            this->slot = s;
+            return;
+        }
+    }
+    throw length_error("Too many snapshot readers, at most " +
+                       to_string(SnapshotPublisher::kMaxReaders) + " are supported.");
+}
+
+/// @brief Give the slot back for another reader
+SnapshotReader::~SnapshotReader() {
+    this->publisher.slots[this->slot].epoch.store(0);
+    this->publisher.slots[this->slot].claimed.store(false);
+}
+
+/// @brief Pin the current snapshot. The slot announces the epoch before
+///        the snapshot is loaded; all four operations are sequentially
+///        consistent, so a snapshot retired at an epoch later than the
+///        announced one was already replaced when this reader loaded, and
+///        the publisher keeps every snapshot retired at a later epoch.
+SnapshotReader::Pin SnapshotReader::pin() {
+    atomic<uint64_t> &announced = this->publisher.slots[this->slot].epoch;
+    announced.store(this->publisher.epoch.load());
+    return Pin(announced, this->publisher.latest.load());
+}
+
+/// @return this reader's work arrays for route searches
+RouteScratch &SnapshotReader::getScratch() {
+    return this->scratch;
+}
+
+/// @brief hold a snapshot for its reader
+SnapshotReader::Pin::Pin(atomic<uint64_t> &slot, const UniverseSnapshot *snapshot)
+    : slot(slot), snapshot(snapshot) {}
+
+/// @brief Announce that the reader holds no snapshot any more
+SnapshotReader::Pin::~Pin() {
+    this->slot.store(0, memory_order_release);
+}
+
+
+/// @return one line summary
+string SnapshotStats::toString() const {
+    ostringstream out;
+    out << this->published << " snapshots published, " << this->reclaimed << " reclaimed, "
+        << this->pending << " waiting for readers, last capture took " << fixed
+        << setprecision(2) << this->lastCaptureMs << " ms.";
+    return out.str();
+}
+
+/// @brief Free every snapshot
+SnapshotPublisher::~SnapshotPublisher() {
+    this->latest.store(nullptr);
+}
+
+/// @brief Capture the loaded systems and make the capture current. The
+///        previous snapshot is retired at the epoch after the swap and
+///        freed once every reading slot has announced that epoch or later.
+/// @param systems the vector of loaded Solar Systems
+/// @param index the index kept in step with systems
+/// @return the published snapshot's sequence number
+uint64_t SnapshotPublisher::publish(const vector<shared_ptr<SolarSystem>> &systems, SystemIndex &index) {
+    auto started = chrono::steady_clock::now();
+    unique_ptr<const UniverseSnapshot> next =
+        make_unique<const UniverseSnapshot>(systems, index, this->sequence + 1, this->owned.get());
+    this->stats.lastCaptureMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+
+    this->latest.store(next.get());
+    uint64_t retiredAt = this->epoch.fetch_add(1) + 1;
+    if (this->owned != nullptr) {
+        this->retired.emplace_back(retiredAt, move(this->owned));
+    }
+    this->owned = move(next);
+    this->sequence++;
+    this->stats.published++;
+
+    this->reclaim();
+    return this->sequence;
+}
+
+/// @brief Free retired snapshots that no reader can still hold
+void SnapshotPublisher::reclaim() {
+    uint64_t oldest = numeric_limits<uint64_t>::max();
+    for (const Slot &slot : this->slots) {
+        uint64_t announced = slot.epoch.load();
+        if (announced != 0) {
+            oldest = min(oldest, announced);
+        }
+    }
+
+    size_t before = this->retired.size();
+    this->retired.erase(remove_if(this->retired.begin(), this->retired.end(),
+                                  [oldest](const auto &entry) { return entry.first <= oldest; }),
+                        this->retired.end());
+    this->stats.reclaimed += before - this->retired.size();
+    this->stats.pending = this->retired.size();
+}
+
+/// @return the current snapshot, nullptr before the first publish
+const UniverseSnapshot *SnapshotPublisher::current() const {
+    return this->owned.get();
+}
+
+/// @return publish and reclaim counters
+SnapshotStats SnapshotPublisher::getStats() const {
+    return this->stats;
+}
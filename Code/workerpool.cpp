@@ -0,0 +1,36 @@
+/// @file workerpool.cpp
+/// @brief Implementations for splitting jobs across worker threads.
+///        Utilized by the Interstellar Travel App.
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "workerpool.h"
+
+using namespace std;
+
+/// @return threads to use for some jobs, at least one
+int workerCount(int wanted, int jobs) {
+    int count = wanted > 0 ? wanted : static_cast<int>(thread::hardware_concurrency());
+    return max(1, min(count, jobs));
+}
+
+/// @brief Hand out jobs 0..jobs-1 to workers; the calling thread is worker 0.
+void runJobs(int jobs, int workers, const function<void(int worker, int job)> &work) {
+    atomic<int> next(0);
+    auto run = [&](int worker) {
+        for (int job = next++; job < jobs; job = next++) {
+            work(worker, job);
+        }
+    };
+    vector<thread> threads;
+    for (int worker = 1; worker < workers; worker++) {
+        threads.emplace_back(run, worker);
+    }
+    run(0);
+    for (thread &worker : threads) {
+        worker.join();
+    }
+}